@@ -1,913 +1,2400 @@
-#pragma once
-
-#include <glad/glad.h>
-
-#include <GLFW/glfw3.h>
-
-#define NANOVG_GL2_IMPLEMENTATION
-
-#include <nanovg.h>
-#include <nanovg_gl.h>
-
-#include "../JuceLibraryCode/JuceHeader.h"
-
-#include <deque>
-
-#include "fft.h"
-#include "avgbuffer.h"
-#include "gl_shader.h"
-#include "audio_performance.h"
-#include "moving_avg.h"
-
-#include "spline.h"
-
-#include <chrono>
-#include <assert.h>
-#include <mutex>
-
-class MainComponent   : public AudioAppComponent, public Button::Listener, public Timer, public Slider::Listener
-{
-public:
-
-    MainComponent()
-    {
-		juce::Rectangle<int> screen = Desktop::getInstance().getDisplays().getMainDisplay().userArea; //Thank you Matthias Gehrmann
-	    setSize (screen.getWidth()*0.20, screen.getWidth()*0.5);
-		
-		setup_GL(screen.getWidth());
-
-		startTimerHz(30);
-		
-		addAndMakeVisible(audio_device_selector_component);
-		addAndMakeVisible(audio_performance_component);
-
-		addAndMakeVisible(num_rta_averages_slider);
-		num_rta_averages_slider.setRange(1.0, 100.0, 1.0);
-		num_rta_averages_slider.setValue(20.0, dontSendNotification);
-		num_rta_averages_slider.addListener(this);
-
-		addAndMakeVisible(lower_threshold_amplitude_slider);
-		lower_threshold_amplitude_slider.setRange(-96.0, 0.0, 1.0);
-		lower_threshold_amplitude_slider.setValue(-96.0);
-		lower_threshold_amplitude_slider_value = lower_threshold_amplitude_slider.getValue();
-		lower_threshold_amplitude_slider.addListener(this);
-
-		addAndMakeVisible(upper_threshold_amplitude_slider);
-		upper_threshold_amplitude_slider.setRange(-96.0, 0.0, 1.0);
-		upper_threshold_amplitude_slider.setValue(0.0);
-		upper_threshold_amplitude_slider_value = upper_threshold_amplitude_slider.getValue();
-		upper_threshold_amplitude_slider.addListener(this);
-
-		addAndMakeVisible(spectrogram_histories_slider);
-		spectrogram_histories_slider.setRange(100.0, 1000.0, 10.0);
-		spectrogram_histories_slider.setValue(250);
-		spectrogram_histories_slider_value = spectrogram_histories_slider.getValue();
-		spectrogram_histories_slider.addListener(this);
-
-		addAndMakeVisible(smoothing_window_type_slider);
-		smoothing_window_type_slider.setRange(0, 2, 1);
-		smoothing_window_type_slider.setValue(2);
-		smoothing_window_type_slider_value = smoothing_window_type_slider.getValue();
-		smoothing_window_type_slider.addListener(this);
-
-		addAndMakeVisible(smoothing_window_size_slider);
-		smoothing_window_size_slider.setRange(1, 99, 2);
-		smoothing_window_size_slider.setValue(15);
-		smoothing_window_size_slider_value = smoothing_window_size_slider.getValue();
-		smoothing_window_size_slider.addListener(this);
-		
-		fft_sample_buffer.resize(fft_size);
-		fft_bin_freqs.resize(fft_size / 2);
-		fft_bin_amps.resize(fft_size / 2);
-
-		generate_fft_bin_freq(fft_bin_freqs, fft_size);
-
-		spectrogram_frequencies.resize(spectrogram_num_frequencies);
-		spectrogram_amplitudes.resize(spectrogram_num_frequencies);
-
-		generate_spectrogram_frequencies();
-
-		fft_output_averager.set_num_averages(num_rta_averages_slider.getValue());
-		fft_output_averager.set_num_samples(fft_bin_amps.size());
-
-		input_sample_buffer.resize(fft_size);
-
-		setAudioChannels(2, 0);
-				
-    } 
-	
-    ~MainComponent()
-    {
-        shutdownAudio();
-		glfwTerminate();
-    }
-
-    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override
-    {
-
-		if (active_sample_rate != sampleRate) {
-
-			active_sample_rate = sampleRate;
-
-			generate_fft_bin_freq(fft_bin_freqs, fft_size);
-
-		}
-
-    }
-
-	void getNextAudioBlock(const AudioSourceChannelInfo& audio_device_buffer)
-	{
-	
-		//auto device_setup = this->deviceManager.getAudioDeviceSetup();
-
-		//auto output_channels = device_setup.outputChannels;
-		
-		auto start = std::chrono::high_resolution_clock::now(); //Thanks to Giovanni Dicanio for timing method
-
-		const float* device_input_buffer = audio_device_buffer.buffer->getReadPointer(0);
-
-		std::vector<float> latest_device_samples(audio_device_buffer.numSamples);
-
-		input_buffer_mtx.lock();
-
-		for (int sample = 0; sample < audio_device_buffer.numSamples; ++sample) {
-
-			input_sample_buffer.push_front(device_input_buffer[sample]);
-			latest_device_samples[sample] = device_input_buffer[sample];
-
-		}
-
-		while (input_sample_buffer.size() > fft_size) {
-			input_sample_buffer.pop_back();
-		}
-
-		input_buffer_mtx.unlock();
-
-		audio_device_buffer.clearActiveBufferRegion();
-
-		auto end = std::chrono::high_resolution_clock::now();
-
-		std::chrono::duration<double> elapsed = end - start;
-
-		double audio_time = elapsed.count() * 1000;
-
-		callback_timer_mtx.lock();
-
-		audio_callback_times.push_back(audio_time);
-		
-		while (audio_callback_times.size() > 100) { audio_callback_times.pop_back(); }
-
-		callback_timer_mtx.unlock();
-
-		reported_xruns = this->deviceManager.getXRunCount();
-
-	}
-
-    void releaseResources() override
-    {
-
-    }
-
-    void paint (Graphics& g) override
-    {
-
-        g.fillAll (Colour(20,20,20));
-
-		g.setColour(Colours::white);
-
-		draw_divider(g, audio_device_selector_outline, 2, Colour(100, 100, 100));
-		draw_divider(g, audio_performance_outline, 2, Colour(100, 100, 100));
-
-		g.setFont(num_rta_averages_slider_label_outline.getHeight() * 0.75);
-		g.drawText("RTA Averages", num_rta_averages_slider_label_outline, Justification::centred, false);
-
-		g.setFont(lower_threshold_amplitude_slider_label_outline.getHeight() * 0.75);
-		g.drawText("Spectrogram Lower Threshold", lower_threshold_amplitude_slider_label_outline, Justification::centred, false);
-
-		g.setFont(upper_threshold_amplitude_slider_label_outline.getHeight() * 0.75);
-		g.drawText("Spectrogram Upper Threshold", upper_threshold_amplitude_slider_label_outline, Justification::centred, false);
-
-		g.setFont(spectrogram_histories_slider_label_outline.getHeight() * 0.75);
-		g.drawText("Spectrogram Histories", spectrogram_histories_slider_label_outline, Justification::centred, false);
-
-		g.setFont(smoothing_window_type_slider_label_outline.getHeight() * 0.75);
-		g.drawText("RTA Smoothing Window Type", smoothing_window_type_slider_label_outline, Justification::centred, false);
-
-		g.setFont(smoothing_window_size_slider_label_outline.getHeight() * 0.75);
-		g.drawText("RTA Smoothing Window Size", smoothing_window_size_slider_label_outline, Justification::centred, false);
-
-    }
-
-	void draw_divider(Graphics& context, juce::Rectangle<int> rectangle_above_divider, int divider_height, Colour divider_color) {
-
-		context.saveState();
-
-		context.setColour(divider_color);
-
-		context.fillRect(rectangle_above_divider.getBottomLeft().getX(),
-			rectangle_above_divider.getBottomLeft().getY() - (divider_height/2),
-			rectangle_above_divider.getWidth(),
-			divider_height);
-
-		context.restoreState();
-
-	}
-
-    void resized() override
-    {
-		control_window_outline = getLocalBounds();
-		int control_window_height = control_window_outline.getHeight();
-
-		audio_device_selector_outline = control_window_outline.removeFromTop(225);
-		audio_device_selector_component.setBounds(audio_device_selector_outline);
-
-		audio_performance_outline = control_window_outline.removeFromTop(control_window_height * 0.15);
-		audio_performance_component.setBounds(audio_performance_outline);
-
-		control_window_outline.removeFromTop(control_window_height * 0.01);
-
-		num_rta_averages_slider_label_outline = control_window_outline.removeFromTop(control_window_height * 0.025);
-		num_rta_averages_slider.setBounds(control_window_outline.removeFromTop(control_window_height * 0.025));
-
-		lower_threshold_amplitude_slider_label_outline = control_window_outline.removeFromTop(control_window_height * 0.025);
-		lower_threshold_amplitude_slider.setBounds(control_window_outline.removeFromTop(control_window_height * 0.025));
-
-		upper_threshold_amplitude_slider_label_outline = control_window_outline.removeFromTop(control_window_height * 0.025);
-		upper_threshold_amplitude_slider.setBounds(control_window_outline.removeFromTop(control_window_height * 0.025));
-
-		spectrogram_histories_slider_label_outline = control_window_outline.removeFromTop(control_window_height * 0.025);
-		spectrogram_histories_slider.setBounds(control_window_outline.removeFromTop(control_window_height * 0.025));
-
-		smoothing_window_type_slider_label_outline = control_window_outline.removeFromTop(control_window_height * 0.025);
-		smoothing_window_type_slider.setBounds(control_window_outline.removeFromTop(control_window_height * 0.025));
-
-		smoothing_window_size_slider_label_outline = control_window_outline.removeFromTop(control_window_height * 0.025);
-		smoothing_window_size_slider.setBounds(control_window_outline.removeFromTop(control_window_height * 0.025));
-		
-    }
-
-private:
-
-	std::deque<float> input_sample_buffer;
-	std::mutex input_buffer_mtx, callback_timer_mtx;
-
-	const int fft_size = 16384;
-	int active_sample_rate = 44100;
-	fft fft0{ fft_size };
-	std::vector<float> fft_bin_freqs;
-	std::vector<float> fft_bin_amps;
-
-	double dBFS_lower_limit = -96.0;
-
-	int fft_amplitude_scaling_factor = 4.0;
-
-	AudioDeviceSelectorComponent audio_device_selector_component{ this->deviceManager,1,1,0,0,0,0,0,0 };
-
-	std::vector<double> fft_sample_buffer;
-	AveragingBuffer fft_output_averager;
-	MovingAverageSmoother sample_smoother;
-
-	AudioPeformanceEngine audio_performance_engine{1};
-	AudioPerformanceComponent audio_performance_component;
-	std::vector<float> audio_performance_buffer;
-	std::deque<float> audio_callback_times;
-	int reported_xruns{ 0 }; //reported over/underruns of audio device buffer
-	
-	juce::Rectangle<int> control_window_outline;
-	juce::Rectangle<int> audio_device_selector_outline;
-	juce::Rectangle<int> audio_performance_outline;
-
-	juce::Rectangle<int> display_window_outline;
-
-	juce::Rectangle<int> rta_outline, frequency_label_outline, spectrogram_outline;
-
-	juce::Rectangle<int> num_rta_averages_slider_label_outline;
-	Slider num_rta_averages_slider;
-	int num_rta_averages_slider_value;
-
-	juce::Rectangle<int> lower_threshold_amplitude_slider_label_outline;
-	Slider lower_threshold_amplitude_slider;
-	int lower_threshold_amplitude_slider_value;
-
-	juce::Rectangle<int> upper_threshold_amplitude_slider_label_outline;
-	Slider upper_threshold_amplitude_slider;
-	int upper_threshold_amplitude_slider_value;
-
-	juce::Rectangle<int> spectrogram_histories_slider_label_outline;
-	Slider spectrogram_histories_slider;
-	int spectrogram_histories_slider_value;
-
-	juce::Rectangle<int> smoothing_window_type_slider_label_outline;
-	Slider smoothing_window_type_slider;
-	int smoothing_window_type_slider_value;
-
-	juce::Rectangle<int> smoothing_window_size_slider_label_outline;
-	Slider smoothing_window_size_slider;
-	int smoothing_window_size_slider_value;
-
-	//====================//
-
-	GLFWwindow *display_window;
-	struct NVGcontext *nvg_context;
-
-	int gl_success{ 0 };
-	char gl_infolog[512];
-
-	unsigned int gl_texture;
-
-	unsigned int VAO[2], VBO[2];
-
-	int gl_shader_program;
-
-	std::deque<unsigned char> spectrogram_texture_pixel_values;
-
-	int spectrogram_num_frequencies = 1024; //must be a multiple of 4
-	int spectrogram_num_past_rows = 256;
-
-	std::vector<float> spectrogram_frequencies, spectrogram_amplitudes;
-	
-	//====================//
-
-	int display_window_width, display_window_height;
-
-	std::vector<int> frequency_label_values{20,50,100,500,1000,5000,10000,20000}; //the first and last values also control the upper/lower bounds of the display
-	
-	std::vector<int> frequency_gridlines{	20,30,40,50,60,70,80,90,100,
-											200,300,400,500,600,700,800,900,1000,
-											2000,3000,4000,5000,6000,7000,8000,9000,10000,
-											20000 };
-
-	std::vector<int> rta_amplitude_gridlines{0,-12,-24,-36,-48,-60,-72,-84,-96}; //in dBFS
-
-	tk::spline cubic_interpolator;
-			
-	void timerCallback() override
-	{
-
-		input_buffer_mtx.lock();
-
-		std::copy(input_sample_buffer.begin(), input_sample_buffer.begin() + (fft0.local_fft_size), fft0.fft_input_samples);
-		
-		if (audio_performance_buffer.size() != input_sample_buffer.size()) {
-
-			audio_performance_buffer.resize(input_sample_buffer.size());
-
-		}
-
-		std::copy(input_sample_buffer.begin(), input_sample_buffer.end(), audio_performance_buffer.begin());
-
-		input_buffer_mtx.unlock();
-
-		run_performance_calcs();
-						
-		fft0.run_fft_analysis();
-
-		get_fft_amplitudes(fft0.fftw_complex_out, fft_bin_amps);
-
-		update_averages();
-
-		render_display();
-
-	}
-
-	void run_performance_calcs() {
-
-		audio_performance_component.set_ape_analysis_results(audio_performance_engine.analyse_samples(audio_performance_buffer));
-
-		callback_timer_mtx.lock();
-		float sum_callback_times = std::accumulate(audio_callback_times.begin(), audio_callback_times.end(), 0.0);
-		callback_timer_mtx.unlock();
-		
-		audio_performance_component.set_indicated_callback_time(sum_callback_times / (audio_callback_times.size()*1.0));
-		audio_performance_component.set_indicated_xruns(reported_xruns);
-		audio_performance_component.repaint();
-			
-	}
-
-	void sliderValueChanged(Slider* slider) override
-		
-	{
-		if (slider == &num_rta_averages_slider) {
-
-			num_rta_averages_slider_value = num_rta_averages_slider.getValue();
-
-			fft_output_averager.set_num_averages(num_rta_averages_slider_value);
-
-		}
-
-		if (slider == &lower_threshold_amplitude_slider) {
-
-			lower_threshold_amplitude_slider_value = lower_threshold_amplitude_slider.getValue();
-
-		}
-
-		if (slider == &upper_threshold_amplitude_slider) {
-
-			upper_threshold_amplitude_slider_value = upper_threshold_amplitude_slider.getValue();
-
-		}
-
-		if (slider == &spectrogram_histories_slider) {
-
-			spectrogram_num_past_rows = spectrogram_histories_slider.getValue();
-
-		}
-
-		if (slider == &smoothing_window_type_slider) {
-
-			smoothing_window_type_slider_value = smoothing_window_type_slider.getValue();
-
-		}
-
-		if (slider == &smoothing_window_size_slider) {
-
-			smoothing_window_size_slider_value = smoothing_window_size_slider.getValue();
-
-		}
-				
-	}
-
-	void buttonClicked(Button* button) override 
-	{
-		
-	}
-
-	void generate_fft_bin_freq(std::vector<float> &freq_vect, int fft_size_N) {
-
-		freq_vect[0] = 0.0;
-
-		for (int x = 1; x < fft_size_N / 2; x++) {
-
-			freq_vect[x] = x * (active_sample_rate * 1.0 / fft_size_N * 1.0);
-
-		}
-
-	}
-
-	void generate_spectrogram_frequencies() {
-
-		//this function generates log spaced frequencies based on the limits of frequency_label_values and resolution of the spectrogram.
-		//these log spaced frequencies will be used to generate the spectrogram texture, which will align correctly with the log frequency 
-		//axis of the display
-
-		int lowest_freq = frequency_label_values.front();
-		int highest_freq = frequency_label_values.back();
-
-		float log_lowest_freq = log10(lowest_freq);
-		float log_higest_freq = log10(highest_freq);
-
-		float log_freq_range = log_higest_freq - log_lowest_freq;
-
-		int num_freq = spectrogram_num_frequencies;
-
-		for (int x = 0; x < num_freq; x++) {
-
-			float exponent = log_lowest_freq + (log_freq_range)*((x*1.0) / (num_freq - 1.0));
-
-			spectrogram_frequencies[x] = pow(10, exponent);
-
-		}
-		
-	}
-
-	void get_fft_amplitudes(std::vector<std::vector<double>> &fft_output_complex, std::vector<float> &amplitude_vector)
-	{
-
-		for (int x = 0; x < amplitude_vector.size(); x++) {
-
-			amplitude_vector[x] =	(sqrtf((pow(fft_output_complex[0][x],2)) + (pow(fft_output_complex[1][x], 2)))) 
-				
-									* fft_amplitude_scaling_factor;
-
-		}
-
-	}
-
-	void update_averages() {
-
-		fft_output_averager.add_new_samples(fft_bin_amps);
-
-	}
-
-	void update_spectrogram_texture() {
-
-		std::vector<double> interpolator_ref_freq, interpolator_ref_amp;
-		interpolator_ref_freq.resize(fft_bin_freqs.size());
-		interpolator_ref_amp.resize(fft_bin_amps.size());
-
-		std::copy(fft_bin_freqs.begin(), fft_bin_freqs.end(), interpolator_ref_freq.begin());
-		std::copy(fft_bin_amps.begin(), fft_bin_amps.end(), interpolator_ref_amp.begin());
-
-		cubic_interpolator.set_points(interpolator_ref_freq, interpolator_ref_amp);
-
-		std::vector<float> interpolated_amplitudes;
-		interpolated_amplitudes.resize(spectrogram_num_frequencies);
-
-		for (int frequency = 0; frequency < spectrogram_num_frequencies; frequency++) {
-
-			interpolated_amplitudes[frequency] = cubic_interpolator(spectrogram_frequencies[frequency]);
-
-		}
-
-		int total_pixels = spectrogram_num_frequencies * spectrogram_num_past_rows;
-
-		if (spectrogram_texture_pixel_values.size() != total_pixels) {
-
-			spectrogram_texture_pixel_values.clear();
-
-			spectrogram_texture_pixel_values.resize(spectrogram_num_frequencies * spectrogram_num_past_rows);
-
-		}
-
-		for (int texture_pixel = 0; texture_pixel < spectrogram_num_frequencies; texture_pixel++) {
-
-			float frequency = spectrogram_frequencies[texture_pixel];
-
-			float value_dBFS = fft_amp_to_dBFS(cubic_interpolator(frequency));
-
-			int value_pixel = (((value_dBFS - (-96.0)) * 255) / 96);
-
-			spectrogram_texture_pixel_values.push_back(value_pixel);
-
-		}
-
-		while (spectrogram_texture_pixel_values.size() > total_pixels) {
-
-			spectrogram_texture_pixel_values.pop_front();
-
-		}
-		
-	}
-
-	void setup_GL(int screen_width) {
-
-		glfwInit();
-
-		//glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-		//glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
-		//glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_ANY_PROFILE);
-
-		display_window = glfwCreateWindow(screen_width*0.5, screen_width*0.5, "SoundView Display", NULL, NULL);
-
-		if (display_window == NULL) {
-
-			AlertWindow::showMessageBox(AlertWindow::AlertIconType::WarningIcon, "ERROR", "GLFW could not set up a window", "OK", NULL);
-
-		}
-
-		glfwMakeContextCurrent(display_window);
-
-		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-
-			AlertWindow::showMessageBox(AlertWindow::AlertIconType::WarningIcon, "ERROR", "GLAD could not be initialized", "OK", NULL);
-
-		}
-
-		Shader glShader{
-			"D://Active//SoundView//Source//vertex_shader.vert",
-			"D://Active//SoundView//Source//fragment_shader.frag"
-		};
-
-		gl_shader_program = glShader.ID;
-		
-		//==========//
-		
-		glGenTextures(1, &gl_texture);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		//==========//
-
-		glGenVertexArrays(2, VAO);
-		glGenBuffers(2, VBO);
-		
-		//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); //this will configure OpenGL to render in wireframe mode
-		
-		//==//
-
-		nvg_context = nvgCreateGL2(NVG_ANTIALIAS | NVG_STENCIL_STROKES);
-
-		nvgCreateFont(nvg_context, "Arial", "C://Windows//Fonts//arial.ttf");
-		
-	}
-
-	void render_display() {
-
-		if (glfwWindowShouldClose(display_window))
-		{
-			JUCEApplicationBase::quit();
-		}
-
-		glfwGetWindowSize(display_window, &display_window_width, &display_window_height);
-
-		glViewport(0, 0, display_window_width, display_window_height);
-
-		calc_layout();
-
-		glUseProgram(gl_shader_program);
-
-		float triangle1[] = {
-			-1.0f, -1.0f, 0.0f,		0.0f,0.0f,  // bottom left
-			-1.0f, 0.0f, 0.0f,		0.0f,1.0f,	// top left
-			1.0f, 0.0f, 0.0f,		1.0f,1.0f	// top right
-		};
-
-		float triangle2[] = {
-			-1.0f, -1.0f, 0.0f,		0.0f,0.0f,  // bottom left
-			1.0f, 0.0f, 0.0f,		1.0f,1.0f,	// top right
-			1.0f, -1.0f, 0.0f,		1.0f,0.0f	// bottom right
-		};
-
-		glBindVertexArray(VAO[0]);
-		glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(triangle1), triangle1, GL_DYNAMIC_DRAW);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(0);
-		glEnableVertexAttribArray(1);
-
-		glBindVertexArray(VAO[1]);
-		glBindBuffer(GL_ARRAY_BUFFER, VBO[1]);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(triangle2), triangle2, GL_DYNAMIC_DRAW);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(0);
-		glEnableVertexAttribArray(1);
-
-		update_spectrogram_texture();
-		
-		int spectrogram_texture_pixel_count = spectrogram_num_frequencies * spectrogram_num_past_rows;
-
-		unsigned char* spectrogram_texture_pixels;
-		spectrogram_texture_pixels = (unsigned char*) malloc(spectrogram_texture_pixel_count * sizeof(unsigned char));
-
-		std::copy(spectrogram_texture_pixel_values.begin(), spectrogram_texture_pixel_values.end(), spectrogram_texture_pixels);
-		
-		glUniform1i(glGetUniformLocation(gl_shader_program, "ourTexture"), 0); //specify which texture unit the frag shader will use
-		glActiveTexture(GL_TEXTURE0); //some drivers require the active texture unit to be specified
-		glBindTexture(GL_TEXTURE_2D, gl_texture);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, spectrogram_num_frequencies, spectrogram_num_past_rows, 0, GL_RED, GL_UNSIGNED_BYTE, spectrogram_texture_pixels);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		free(spectrogram_texture_pixels);
-
-		Shader::setOutsideFloat(gl_shader_program, "lower_amplitude_limit", lower_threshold_amplitude_slider_value);
-		Shader::setOutsideFloat(gl_shader_program, "upper_amplitude_limit", upper_threshold_amplitude_slider_value);
-		Shader::setOutsideFloat(gl_shader_program, "dBFS_lower_limit", dBFS_lower_limit);
-		
-		glClearColor(0.0, 0.0, 0.0, 1.0);
-		glClear(GL_COLOR_BUFFER_BIT);
-						
-		glBindVertexArray(VAO[0]);
-		glDrawArrays(GL_TRIANGLES, 0, 3);
-
-		glBindVertexArray(VAO[1]);
-		glDrawArrays(GL_TRIANGLES, 0, 3);
-
-		nvg_render(nvg_context);
-					
-		glfwSwapBuffers(display_window);
-
-	}
-
-	void calc_layout() {
-
-		display_window_outline = juce::Rectangle<int>{ 0, 0, display_window_width, display_window_height };
-
-		rta_outline = display_window_outline.removeFromTop(display_window_outline.getHeight()*0.48);
-
-		frequency_label_outline = display_window_outline.removeFromTop(display_window_outline.getHeight()*0.04);
-
-		spectrogram_outline = display_window_outline;
-
-	}
-
-	void nvg_render(NVGcontext *ctx)
-	{
-		nvgBeginFrame(ctx, display_window_width, display_window_height, 1.0f);
-
-		//==========//
-
-		nvgStrokeWidth(ctx, 2);
-
-		nvgStrokeColor(ctx, nvgRGBA(255, 127, 0, 255));
-		
-		//render_juce_int_rect(ctx, rta_outline);
-
-		//render_juce_int_rect(ctx, frequency_label_outline);
-		
-		//render_juce_int_rect(ctx, spectrogram_outline);
-
-		//////////
-
-		int font_size = frequency_label_outline.getHeight() * 0.8;
-
-		char int_string[33];
-
-		memset(int_string, 0, sizeof int_string);
-
-		itoa(frequency_label_values.front(), int_string, 10);
-
-		render_text(ctx, int_string, frequency_label_outline.getX() + 5, frequency_label_outline.getCentreY(), font_size, 1, FALSE);
-
-		memset(int_string, 0, sizeof int_string);
-
-		itoa(frequency_label_values.back(), int_string, 10);
-
-		render_text(ctx, int_string, frequency_label_outline.getTopRight().getX() - 5, frequency_label_outline.getCentreY(), font_size, 2, FALSE);
-
-		for (int x = 1; x < frequency_label_values.size() - 1; x++) {
-
-			memset(int_string, 0, sizeof int_string);
-
-			itoa(frequency_label_values[x], int_string, 10);
-
-			render_text(ctx, 
-						int_string, 
-						frequency_label_outline.getX() + frequency_label_outline.getWidth() * frequency_to_x_proportion(frequency_label_values[x]), 
-						frequency_label_outline.getCentreY(), 
-						font_size,
-						0, 
-						FALSE);
-
-		}
-
-		//////////
-
-		for (int x = 0; x < frequency_gridlines.size(); x++)
-		{
-
-			nvgStrokeWidth(ctx, 1);
-
-			nvgStrokeColor(ctx, nvgRGBA(40, 40, 40, 255));
-			
-			nvgBeginPath(ctx);
-
-			nvgMoveTo(ctx, rta_outline.getX() + rta_outline.getWidth() * frequency_to_x_proportion(frequency_gridlines[x]), rta_outline.getY());
-
-			nvgLineTo(ctx, rta_outline.getX() + rta_outline.getWidth() * frequency_to_x_proportion(frequency_gridlines[x]), rta_outline.getBottomLeft().getY());
-
-			nvgStroke(ctx);
-
-		}
-
-		//////////
-
-		for (int x = 0; x < rta_amplitude_gridlines.size(); x++)
-		{
-
-			nvgStrokeWidth(ctx, 1);
-
-			nvgStrokeColor(ctx, nvgRGBA(40, 40, 40, 255));
-
-			nvgBeginPath(ctx);
-
-			nvgMoveTo(ctx, rta_outline.getX(), rta_outline.getY() + rta_outline.getHeight() * rta_dBFS_to_y_proportion(rta_amplitude_gridlines[x]));
-
-			nvgLineTo(ctx, rta_outline.getTopRight().getX(), rta_outline.getY() + rta_outline.getHeight() * rta_dBFS_to_y_proportion(rta_amplitude_gridlines[x]));
-
-			nvgStroke(ctx);
-
-		}
-
-		//////////
-
-		nvgStrokeWidth(ctx, 1);
-
-		nvgStrokeColor(ctx, nvgRGBA(255, 127, 0, 255));
-
-		nvgBeginPath(ctx);
-
-		std::vector<float> rta_amplitudes = 
-			sample_smoother.process_samples(	fft_output_averager.get_average(), 
-												smoothing_window_type_slider_value, 
-												smoothing_window_size_slider_value);
-
-		nvgMoveTo(	ctx, 
-					rta_outline.getX() + rta_outline.getWidth() * frequency_to_x_proportion(fft_bin_freqs[1]),
-					rta_outline.getY() + rta_outline.getHeight() * rta_dBFS_to_y_proportion(fft_amp_to_dBFS(rta_amplitudes[1])));
-
-		for (int x = 2; x < rta_amplitudes.size(); x++)
-		{
-						
-			nvgLineTo(ctx,
-				rta_outline.getX() + rta_outline.getWidth() * frequency_to_x_proportion(fft_bin_freqs[x]),
-				rta_outline.getY() + rta_outline.getHeight() * rta_dBFS_to_y_proportion(fft_amp_to_dBFS(rta_amplitudes[x])));
-
-		}
-
-		nvgStroke(ctx);
-
-		//==========//
-
-		nvgEndFrame(ctx);
-
-	}
-
-	void render_text(	NVGcontext *ctx, const char* text, int pos_x_pix, int pos_y_pix, 
-						int font_size_pix, int positioning, bool show_bounding_box) {
-		
-		//Positioning values are 0 = center, 1 = middle left edge, 2 = middle right edge
-
-		int font_x, font_y;
-
-		float font_bounds[4];
-
-		nvgFontSize(ctx, font_size_pix);
-
-		nvgTextAlign(ctx, NVGalign::NVG_ALIGN_BOTTOM);
-
-		nvgTextBounds(ctx, 0.0, 0.0, text, NULL, font_bounds);
-
-		int font_width = font_bounds[2] - font_bounds[0];
-
-		int font_height = font_bounds[3] - font_bounds[1];
-
-		if (positioning == 0) {
-
-			font_x = pos_x_pix - (font_width / 2);
-
-			font_y = pos_y_pix + (font_height / 2);
-
-		}
-
-		if (positioning == 1) {
-
-			font_x = pos_x_pix;
-
-			font_y = pos_y_pix + (font_height / 2);
-
-		}
-
-		if (positioning == 2) {
-
-			font_x = pos_x_pix - font_width;
-
-			font_y = pos_y_pix + (font_height / 2);
-
-		}
-
-		nvgText(ctx, font_x, font_y, text, NULL);
-
-		if (show_bounding_box == true) {
-
-			nvgStrokeWidth(ctx, 1);
-
-			nvgStrokeColor(ctx, nvgRGBA(255, 255, 255, 255));
-
-			nvgBeginPath(ctx);
-
-			nvgRect(ctx, font_x, font_y - font_height, font_width, font_height);
-
-			nvgStroke(ctx);
-
-		}
-		
-	}
-
-	void render_juce_int_rect(NVGcontext *ctx, juce::Rectangle<int> rect) {
-
-		nvgBeginPath(ctx);
-
-		nvgRect(ctx, rect.getX(), rect.getY(), rect.getWidth(), rect.getHeight());
-
-		nvgStroke(ctx);
-
-	}
-
-	float frequency_to_x_proportion(float frequency)
-	{
-
-		float min_offset = log10f(frequency_label_values.front());
-		float max_offset = log10f(frequency_label_values.back());
-		float offset_range = max_offset - min_offset;
-
-		float freq_offset = log10f(frequency) - min_offset;
-
-		return freq_offset / offset_range;
-
-	}
-
-	float rta_dBFS_to_y_proportion(float dBFS)
-	{
-
-		float offset_range = rta_amplitude_gridlines.front() - rta_amplitude_gridlines.back();
-
-		float amplitude_offset = abs(dBFS) - rta_amplitude_gridlines.front();
-
-		return amplitude_offset / offset_range;
-
-	}
-
-	float fft_amp_to_dBFS(double amp) {
-
-		return Decibels::gainToDecibels(amp, dBFS_lower_limit);
-
-	}
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
-};
+#pragma once
+
+#include <glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+#define NANOVG_GL2_IMPLEMENTATION
+
+#include <nanovg.h>
+#include <nanovg_gl.h>
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#include <deque>
+
+#include "multi_resolution_engine.h"
+#include "spectrogram_history.h"
+#include "gl_shader.h"
+#include "audio_performance.h"
+#include "delay_finder.h"
+#include "zoom_fft.h"
+#include "octave_filter_bank.h"
+#include "spectrum_holds.h"
+#include "percentile_spectrum.h"
+#include "fixed_frequency_grid.h"
+#include "spectrogram_auto_range.h"
+#include "spectral_peaks.h"
+#include "feedback_detector.h"
+#include "loudness_meter.h"
+#include "virtual_audio_device.h"
+#include "frame_profiler.h"
+#include "display_latency.h"
+#include "quality_governor.h"
+
+#include <sstream>
+
+#include <chrono>
+#include <assert.h>
+#include <mutex>
+
+class MainComponent   : public AudioAppComponent, public Button::Listener, public Timer, public Slider::Listener
+{
+public:
+
+    MainComponent(const StringArray &arguments = StringArray())
+    {
+		juce::Rectangle<int> screen = Desktop::getInstance().getDisplays().getMainDisplay().userArea; //Thank you Matthias Gehrmann
+	    setSize (screen.getWidth()*0.20, screen.getWidth()*0.5);
+		
+		setup_GL(screen.getWidth());
+
+		quality_governor.set_enabled(!arguments.contains("--no-governor"));
+		quality_settings = quality_governor.get_settings();
+
+		startTimerHz(quality_settings.render_rate_hz);
+		
+		addAndMakeVisible(audio_device_selector_component);
+		addAndMakeVisible(audio_performance_component);
+
+		addAndMakeVisible(num_rta_averages_slider);
+		num_rta_averages_slider.setRange(1.0, 100.0, 1.0);
+		num_rta_averages_slider.setValue(20.0, dontSendNotification);
+		num_rta_averages_slider.addListener(this);
+
+		addAndMakeVisible(averaging_mode_slider);
+		averaging_mode_slider.setRange(0, num_averaging_modes - 1, 1);
+		averaging_mode_slider.setValue(mean_averaging, dontSendNotification);
+		averaging_mode_slider.addListener(this);
+
+		addAndMakeVisible(lower_threshold_amplitude_slider);
+		lower_threshold_amplitude_slider.setRange(-96.0, 0.0, 1.0);
+		lower_threshold_amplitude_slider.setValue(-96.0);
+		lower_threshold_amplitude_slider_value = lower_threshold_amplitude_slider.getValue();
+		lower_threshold_amplitude_slider.addListener(this);
+
+		addAndMakeVisible(upper_threshold_amplitude_slider);
+		upper_threshold_amplitude_slider.setRange(-96.0, 0.0, 1.0);
+		upper_threshold_amplitude_slider.setValue(0.0);
+		upper_threshold_amplitude_slider_value = upper_threshold_amplitude_slider.getValue();
+		upper_threshold_amplitude_slider.addListener(this);
+
+		addAndMakeVisible(auto_thresholds_slider);
+		auto_thresholds_slider.setRange(0, 1, 1);
+		auto_thresholds_slider.setValue(0, dontSendNotification);
+		auto_thresholds_slider.addListener(this);
+
+		addAndMakeVisible(spectrogram_histories_slider);
+		spectrogram_histories_slider.setRange(100.0, 1000.0, 10.0);
+		spectrogram_histories_slider.setValue(250);
+		spectrogram_histories_slider_value = spectrogram_histories_slider.getValue();
+		spectrogram_histories_slider.addListener(this);
+
+		addAndMakeVisible(smoothing_window_type_slider);
+		smoothing_window_type_slider.setRange(0, 2, 1);
+		smoothing_window_type_slider.setValue(2);
+		smoothing_window_type_slider_value = smoothing_window_type_slider.getValue();
+		smoothing_window_type_slider.addListener(this);
+
+		addAndMakeVisible(smoothing_window_size_slider);
+		smoothing_window_size_slider.setRange(1, 99, 2);
+		smoothing_window_size_slider.setValue(15);
+		smoothing_window_size_slider_value = smoothing_window_size_slider.getValue();
+		smoothing_window_size_slider.addListener(this);
+
+		addAndMakeVisible(analysis_resolution_slider);
+		analysis_resolution_slider.setRange(0, 1, 1);
+		analysis_resolution_slider.setValue(1, dontSendNotification);
+		analysis_resolution_slider.addListener(this);
+
+		addAndMakeVisible(constant_q_slider);
+		constant_q_slider.setRange(0, 96, 6);
+		constant_q_slider.setValue(0, dontSendNotification);
+		constant_q_slider.addListener(this);
+
+		addAndMakeVisible(frequency_scale_slider);
+		frequency_scale_slider.setRange(0, num_frequency_scales - 1, 1);
+		frequency_scale_slider.setValue(log_scale, dontSendNotification);
+		frequency_scale_slider.addListener(this);
+
+		addAndMakeVisible(zoom_analysis_slider);
+		zoom_analysis_slider.setRange(0, 1, 1);
+		zoom_analysis_slider.setValue(0, dontSendNotification);
+		zoom_analysis_slider.addListener(this);
+
+		addAndMakeVisible(zoom_band_slider);
+		zoom_band_slider.setSliderStyle(Slider::TwoValueHorizontal);
+		zoom_band_slider.setTextBoxStyle(Slider::NoTextBox, false, 0, 0); //the band is shown in the label
+		zoom_band_slider.setRange(1.0, 2000.0, 1.0);
+		zoom_band_slider.setMinAndMaxValues(zoom_band_low, zoom_band_high, dontSendNotification);
+		zoom_band_slider.addListener(this);
+
+		addAndMakeVisible(octave_bands_slider);
+		octave_bands_slider.setRange(0, 2, 1);
+		octave_bands_slider.setValue(0, dontSendNotification);
+		octave_bands_slider.addListener(this);
+
+		addAndMakeVisible(hold_traces_slider);
+		hold_traces_slider.setRange(0, 1, 1);
+		hold_traces_slider.setValue(0, dontSendNotification);
+		hold_traces_slider.addListener(this);
+
+		addAndMakeVisible(percentile_spectra_slider);
+		percentile_spectra_slider.setRange(0, 1, 1);
+		percentile_spectra_slider.setValue(0, dontSendNotification);
+		percentile_spectra_slider.addListener(this);
+
+		addAndMakeVisible(peak_labels_slider);
+		peak_labels_slider.setRange(0, 1, 1);
+		peak_labels_slider.setValue(0, dontSendNotification);
+		peak_labels_slider.addListener(this);
+
+		addAndMakeVisible(feedback_detection_slider);
+		feedback_detection_slider.setRange(0, 1, 1);
+		feedback_detection_slider.setValue(0, dontSendNotification);
+		feedback_detection_slider.addListener(this);
+		
+		fft_sample_buffer.resize(fft_size);
+
+		analysis_engine.set_num_averages(num_rta_averages_slider.getValue());
+		apply_smoothing();
+		apply_analysis_resolution();
+
+		input_sample_buffer.resize(input_ring_size);
+
+		delay_finder.start();
+
+		zoom_fft.set_band(zoom_band_low, zoom_band_high);
+		zoom_fft.start();
+
+		octave_filter_bank.start();
+
+		full_band_label_values = frequency_label_values;
+		full_band_gridlines = frequency_gridlines;
+
+		setAudioChannels(2, 0);
+
+		setup_virtual_audio_device(arguments);
+
+		setup_spl_meter(arguments);
+
+		FrameProfiler::get_instance().set_thread_name("Message thread");
+
+		if (arguments.contains("--profile")) { //start with the stage profiler and its overlay on
+
+			FrameProfiler::get_instance().set_enabled(true);
+
+			show_profiler_overlay = true;
+
+		}
+
+		if (arguments.contains("--feedback")) { //start with feedback detection on
+
+			feedback_detection_slider.setValue(1);
+
+		}
+
+		if (arguments.contains("--soak")) { //run for a fixed time, print the callback and xrun statistics, then quit
+
+			soak_end_time_ms = Time::getMillisecondCounterHiRes() + arguments[arguments.indexOf("--soak") + 1].getDoubleValue() * 1000.0;
+
+		}
+				
+    } 
+	
+    ~MainComponent()
+    {
+        shutdownAudio();
+		delay_finder.stop();
+		zoom_fft.stop();
+		octave_filter_bank.stop();
+		glfwTerminate();
+    }
+
+    void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override
+    {
+
+		analysis_engine.set_sample_rate(sampleRate);
+
+		delay_finder.set_sample_rate(sampleRate);
+		delay_finder.reset();
+
+		reference_hold_samples = (int64_t)sampleRate; //1 s
+		reference_silent_samples = reference_hold_samples + 1;
+		delay_reference_active.store(false);
+
+		zoom_fft.set_sample_rate(sampleRate);
+
+		spl_meter.set_sample_rate(sampleRate);
+
+		level_meter.set_sample_rate(sampleRate);
+
+		feedback_detector.set_sample_rate(sampleRate);
+
+		loudness_meter.set_sample_rate(sampleRate); //starts a new integrated loudness measurement
+
+		octave_filter_bank.set_sample_rate(sampleRate);
+
+		audio_performance_engine.set_sample_rate(sampleRate);
+
+		callback_timing_monitor.prepare(sampleRate, samplesPerBlockExpected);
+
+		display_latency_tracker.reset();
+
+		FrameProfiler::get_instance().reserve_thread_buffer("Audio callback"); //the callback may run on a new thread
+		audio_thread_registered = false;
+
+    }
+
+	void getNextAudioBlock(const AudioSourceChannelInfo& audio_device_buffer)
+	{
+	
+		//auto device_setup = this->deviceManager.getAudioDeviceSetup();
+
+		//auto output_channels = device_setup.outputChannels;
+		
+		auto start = std::chrono::high_resolution_clock::now(); //Thanks to Giovanni Dicanio for timing method
+
+		int64_t block_arrival_ns = FrameProfiler::get_instance().get_time_ns();
+
+		if (!audio_thread_registered) { //takes the buffer reserved in prepareToPlay, so no scope here allocates or locks
+
+			FrameProfiler::get_instance().claim_reserved_thread_buffer();
+
+			audio_thread_registered = true;
+
+		}
+
+		SOUNDVIEW_PROFILE_SCOPE("audio_callback");
+
+		const float* device_input_buffer = audio_device_buffer.buffer->getReadPointer(0);
+
+		std::vector<float> latest_device_samples(audio_device_buffer.numSamples);
+
+		input_buffer_mtx.lock();
+
+		for (int sample = 0; sample < audio_device_buffer.numSamples; ++sample) {
+
+			input_sample_buffer.push_front(device_input_buffer[sample]);
+			latest_device_samples[sample] = device_input_buffer[sample];
+
+		}
+
+		while (input_sample_buffer.size() > input_ring_size) {
+			input_sample_buffer.pop_back();
+		}
+
+		newest_block_arrival_ns = block_arrival_ns;
+		samples_received += audio_device_buffer.numSamples;
+
+		input_buffer_mtx.unlock();
+
+		//input 1 is the measurement signal shown on the display, input 2 (if active) is the reference for the delay finder
+
+		const float* device_reference_buffer = nullptr;
+
+		if (audio_device_buffer.buffer->getNumChannels() > 1) {
+
+			device_reference_buffer = audio_device_buffer.buffer->getReadPointer(1);
+
+		}
+
+		//the delay finder only runs while input 2 carries a signal, an unconnected or disabled input would only correlate noise
+
+		if (device_reference_buffer != nullptr && audio_device_buffer.buffer->getMagnitude(1, audio_device_buffer.startSample, audio_device_buffer.numSamples) > reference_active_amplitude) {
+
+			if (!delay_reference_active.load()) { //the old window holds a different signal
+
+				delay_finder.reset();
+
+			}
+
+			reference_silent_samples = 0;
+
+			delay_reference_active.store(true);
+
+		}
+
+		else {
+
+			reference_silent_samples += audio_device_buffer.numSamples;
+
+			if (reference_silent_samples > reference_hold_samples) { //quiet passages shorter than the hold keep it running
+
+				delay_reference_active.store(false);
+
+			}
+
+		}
+
+		if (delay_reference_active.load()) {
+
+			delay_finder.push_samples(device_input_buffer, device_reference_buffer, audio_device_buffer.numSamples);
+
+		}
+
+		zoom_fft.push_samples(device_input_buffer, audio_device_buffer.numSamples, block_arrival_ns);
+
+		octave_filter_bank.push_samples(device_input_buffer, audio_device_buffer.numSamples);
+
+		audio_performance_engine.process_block(device_input_buffer, audio_device_buffer.numSamples);
+
+		const float* input_channels[2] = { device_input_buffer, device_reference_buffer };
+
+		int num_input_channels = device_reference_buffer != nullptr ? 2 : 1;
+
+		spl_meter.process_block(input_channels, num_input_channels, audio_device_buffer.numSamples);
+
+		level_meter.process_block(input_channels, num_input_channels, audio_device_buffer.numSamples);
+
+		loudness_meter.process_block(&device_input_buffer, 1, audio_device_buffer.numSamples);
+
+		feedback_detector.process_block(device_input_buffer, audio_device_buffer.numSamples);
+
+		audio_device_buffer.clearActiveBufferRegion();
+
+		auto end = std::chrono::high_resolution_clock::now();
+
+		callback_timing_monitor.callback_finished(start, end, audio_device_buffer.numSamples);
+
+		reported_xruns = this->deviceManager.getXRunCount();
+
+	}
+
+    void releaseResources() override
+    {
+
+    }
+
+    void paint (Graphics& g) override
+    {
+
+        g.fillAll (Colour(20,20,20));
+
+		g.setColour(Colours::white);
+
+		draw_divider(g, audio_device_selector_outline, 2, Colour(100, 100, 100));
+		draw_divider(g, audio_performance_outline, 2, Colour(100, 100, 100));
+
+		g.setFont(num_rta_averages_slider_label_outline.getHeight() * 0.75);
+		g.drawText("RTA Averages", num_rta_averages_slider_label_outline, Justification::centred, false);
+
+		g.setFont(averaging_mode_slider_label_outline.getHeight() * 0.75);
+		g.drawText("RTA Averaging (Mean / Median / Trimmed Mean)", averaging_mode_slider_label_outline, Justification::centred, false);
+
+		g.setFont(lower_threshold_amplitude_slider_label_outline.getHeight() * 0.75);
+		g.drawText("Spectrogram Lower Threshold", lower_threshold_amplitude_slider_label_outline, Justification::centred, false);
+
+		g.setFont(upper_threshold_amplitude_slider_label_outline.getHeight() * 0.75);
+		g.drawText("Spectrogram Upper Threshold", upper_threshold_amplitude_slider_label_outline, Justification::centred, false);
+
+		g.setFont(auto_thresholds_slider_label_outline.getHeight() * 0.75);
+		g.drawText("Spectrogram Thresholds (Manual / Auto)", auto_thresholds_slider_label_outline, Justification::centred, false);
+
+		g.setFont(spectrogram_histories_slider_label_outline.getHeight() * 0.75);
+		g.drawText("Spectrogram Histories", spectrogram_histories_slider_label_outline, Justification::centred, false);
+
+		g.setFont(smoothing_window_type_slider_label_outline.getHeight() * 0.75);
+		g.drawText("RTA Smoothing Window Type", smoothing_window_type_slider_label_outline, Justification::centred, false);
+
+		g.setFont(smoothing_window_size_slider_label_outline.getHeight() * 0.75);
+		g.drawText("RTA Smoothing Window Size", smoothing_window_size_slider_label_outline, Justification::centred, false);
+
+		g.setFont(analysis_resolution_slider_label_outline.getHeight() * 0.75);
+		g.drawText("RTA Resolution (Single FFT / Multi-resolution)", analysis_resolution_slider_label_outline, Justification::centred, false);
+
+		g.setFont(constant_q_slider_label_outline.getHeight() * 0.75);
+		g.drawText("Constant-Q Bins per Octave (0 = FFT Bins)", constant_q_slider_label_outline, Justification::centred, false);
+
+		g.setFont(frequency_scale_slider_label_outline.getHeight() * 0.75);
+		g.drawText("Frequency Scale: " + String(get_frequency_scale_name(frequency_scale)), frequency_scale_slider_label_outline, Justification::centred, false);
+
+		g.setFont(zoom_analysis_slider_label_outline.getHeight() * 0.75);
+		g.drawText("Zoom Analysis (Off / On)", zoom_analysis_slider_label_outline, Justification::centred, false);
+
+		g.setFont(zoom_band_slider_label_outline.getHeight() * 0.75);
+		g.drawText("Zoom Band " + String(zoom_band_low) + " - " + String(zoom_band_high) + " Hz", zoom_band_slider_label_outline, Justification::centred, false);
+
+		g.setFont(octave_bands_slider_label_outline.getHeight() * 0.75);
+		g.drawText("Octave Band Levels (Off / 1/1 / 1/3)", octave_bands_slider_label_outline, Justification::centred, false);
+
+		g.setFont(hold_traces_slider_label_outline.getHeight() * 0.75);
+		g.drawText("Peak / Min / Decay Hold Traces (Off / On)", hold_traces_slider_label_outline, Justification::centred, false);
+
+		g.setFont(percentile_spectra_slider_label_outline.getHeight() * 0.75);
+		g.drawText("L10 / L50 / L90 Spectra (Off / On)", percentile_spectra_slider_label_outline, Justification::centred, false);
+
+		g.setFont(peak_labels_slider_label_outline.getHeight() * 0.75);
+		g.drawText("RTA Peak Labels (Off / On)", peak_labels_slider_label_outline, Justification::centred, false);
+
+		g.setFont(feedback_detection_slider_label_outline.getHeight() * 0.75);
+		g.drawText("Feedback Detection (Off / On)", feedback_detection_slider_label_outline, Justification::centred, false);
+
+    }
+
+	void draw_divider(Graphics& context, juce::Rectangle<int> rectangle_above_divider, int divider_height, Colour divider_color) {
+
+		context.saveState();
+
+		context.setColour(divider_color);
+
+		context.fillRect(rectangle_above_divider.getBottomLeft().getX(),
+			rectangle_above_divider.getBottomLeft().getY() - (divider_height/2),
+			rectangle_above_divider.getWidth(),
+			divider_height);
+
+		context.restoreState();
+
+	}
+
+    void resized() override
+    {
+		control_window_outline = getLocalBounds();
+		int control_window_height = control_window_outline.getHeight();
+
+		audio_device_selector_outline = control_window_outline.removeFromTop(225);
+		audio_device_selector_component.setBounds(audio_device_selector_outline);
+
+		audio_performance_outline = control_window_outline.removeFromTop(control_window_height * 0.36);
+		audio_performance_component.setBounds(audio_performance_outline);
+
+		control_window_outline.removeFromTop(control_window_height * 0.01);
+
+		//each control is a label row and a slider row, squeezed to fit when the screen is short
+
+		std::vector<std::pair<juce::Rectangle<int>*, Slider*>> control_rows{
+			{ &num_rta_averages_slider_label_outline, &num_rta_averages_slider },
+			{ &averaging_mode_slider_label_outline, &averaging_mode_slider },
+			{ &lower_threshold_amplitude_slider_label_outline, &lower_threshold_amplitude_slider },
+			{ &upper_threshold_amplitude_slider_label_outline, &upper_threshold_amplitude_slider },
+			{ &auto_thresholds_slider_label_outline, &auto_thresholds_slider },
+			{ &spectrogram_histories_slider_label_outline, &spectrogram_histories_slider },
+			{ &smoothing_window_type_slider_label_outline, &smoothing_window_type_slider },
+			{ &smoothing_window_size_slider_label_outline, &smoothing_window_size_slider },
+			{ &analysis_resolution_slider_label_outline, &analysis_resolution_slider },
+			{ &constant_q_slider_label_outline, &constant_q_slider },
+			{ &frequency_scale_slider_label_outline, &frequency_scale_slider },
+			{ &zoom_analysis_slider_label_outline, &zoom_analysis_slider },
+			{ &zoom_band_slider_label_outline, &zoom_band_slider },
+			{ &octave_bands_slider_label_outline, &octave_bands_slider },
+			{ &hold_traces_slider_label_outline, &hold_traces_slider },
+			{ &percentile_spectra_slider_label_outline, &percentile_spectra_slider },
+			{ &peak_labels_slider_label_outline, &peak_labels_slider },
+			{ &feedback_detection_slider_label_outline, &feedback_detection_slider } };
+
+		int row_height = jmin((int)(control_window_height * 0.025), control_window_outline.getHeight() / (int)(control_rows.size() * 2));
+
+		for (int x = 0; x < control_rows.size(); x++) {
+
+			*control_rows[x].first = control_window_outline.removeFromTop(row_height);
+			control_rows[x].second->setBounds(control_window_outline.removeFromTop(row_height));
+
+		}
+		
+    }
+
+private:
+
+	std::deque<float> input_sample_buffer;
+	std::mutex input_buffer_mtx;
+	int64_t newest_block_arrival_ns{ 0 }; //FrameProfiler clock, guarded by input_buffer_mtx
+	int64_t samples_received{ 0 }; //guarded by input_buffer_mtx
+	int64_t samples_received_at_last_frame{ 0 };
+	const int minimum_analysis_hop = 256; //samples
+
+	bool display_needs_redraw{ true }; //set by anything that changes the display other than a new frame
+	bool spectrogram_texture_needs_upload{ false };
+	double last_render_time_ms{ 0.0 };
+
+	const int fft_size = 16384; //single resolution mode
+	const int input_ring_size = 65536; //the longest multi-resolution FFT
+
+	double dBFS_lower_limit = -96.0;
+
+	AudioDeviceSelectorComponent audio_device_selector_component{ this->deviceManager,1,2,0,0,0,0,0,0 };
+
+	std::vector<double> fft_sample_buffer;
+
+	AudioPeformanceEngine audio_performance_engine{1}; //sample health over the last second of input 1
+	SPLMeter spl_meter; //runs in the audio callback on both inputs
+	LevelMeter level_meter; //peak, RMS and true peak of both inputs, in the audio callback
+	LevelMeterBallistics level_meter_ballistics; //applied to level_meter's periods on the message thread
+	LoudnessMeter loudness_meter{ 1 }; //input 1 as a mono programme, in the audio callback, F8 restarts it
+	AudioPerformanceComponent audio_performance_component;
+	CallbackTimingMonitor callback_timing_monitor;
+	DisplayLatencyTracker display_latency_tracker;
+	DisplayLatencyFrame frame_latency; //the frame being analysed and rendered
+	double zoom_analysis_seconds{ 0.0 }; //the zoom thread's share of the frame's analysis, in zoom mode
+
+	QualityGovernor quality_governor; //--no-governor keeps full quality regardless of frame cost
+	QualitySettings quality_settings;
+	int ticks_since_analysis{ 0 };
+	int reported_xruns{ 0 }; //reported over/underruns of audio device buffer
+
+	DelayFinder delay_finder{ 65536, 8192 }; //~1.5 s window re-estimated ~5 times a second at 44.1 kHz
+	std::atomic<bool> delay_reference_active{ false }; //input 2 has carried a signal within the last reference_hold_samples
+	const float reference_active_amplitude = 1.0e-4f; //-80 dBFS
+	int64_t reference_hold_samples{ 44100 };
+	int64_t reference_silent_samples{ 44101 }; //audio thread only
+
+	ZoomFFT zoom_fft{ 8192 }; //input 1 only, runs while zoom analysis is on
+	ZoomSpectrum zoom_spectrum;
+	int64_t zoom_frame_index{ -1 };
+	std::vector<float> zoom_spectrogram_row;
+	bool zoom_mode{ false };
+	int zoom_band_low{ 20 }, zoom_band_high{ 500 };
+
+	OctaveFilterBank octave_filter_bank; //input 1 only, runs while octave band levels are shown
+	OctaveBandLevels octave_band_levels;
+	int64_t octave_band_frame_index{ -1 };
+
+	SpectrumHolds rta_holds; //over the averaged RTA while the hold traces are on, F5 / F6 / F7 reset peak, min and decay
+	bool show_hold_traces{ false };
+	double last_rta_holds_update_ms{ 0.0 };
+
+	FixedFrequencyGrid measurement_grid{ 1024, 20.0f, 20000.0f }; //the spectrogram rows for the long term statistics, whatever the display settings
+
+	PercentileSpectrum percentile_spectrum; //of every spectrogram row on the measurement grid while the L10 / L50 / L90 spectra are on, F8 restarts it
+	bool show_percentile_spectra{ false };
+	double percentile_spectrum_start_ms{ 0.0 };
+
+	SpectralPeakTracker rta_peaks; //the strongest peaks of the RTA or zoom spectrum, tracked while the peak labels are on
+	bool show_peak_labels{ false };
+
+	FeedbackDetector feedback_detector; //Goertzel filters on input 1 at the feedback candidates, in the audio callback
+	FeedbackMonitor feedback_monitor; //candidates from the unaveraged analysis frames while feedback detection is on
+	bool detect_feedback{ false };
+
+	SpectrogramAutoRange spectrogram_auto_range; //of every spectrogram row on the measurement grid (the zoom row in zoom mode) while the thresholds are automatic
+	bool auto_thresholds{ false };
+	double last_auto_range_update_ms{ 0.0 };
+
+	double soak_end_time_ms{ 0.0 }; //0 = not soak testing
+
+	bool show_profiler_overlay{ false }; //F9 toggles the profiler and overlay, F10 writes a Chrome trace
+	bool profiler_toggle_key_down{ false }, trace_export_key_down{ false };
+	bool measurement_reset_key_down{ false };
+	bool hold_reset_keys_down[3] = { false, false, false };
+	bool audio_thread_registered{ false };
+	
+	juce::Rectangle<int> control_window_outline;
+	juce::Rectangle<int> audio_device_selector_outline;
+	juce::Rectangle<int> audio_performance_outline;
+
+	juce::Rectangle<int> display_window_outline;
+
+	juce::Rectangle<int> rta_outline, frequency_label_outline, spectrogram_outline;
+
+	juce::Rectangle<int> num_rta_averages_slider_label_outline;
+	Slider num_rta_averages_slider;
+	int num_rta_averages_slider_value;
+
+	juce::Rectangle<int> averaging_mode_slider_label_outline;
+	Slider averaging_mode_slider;
+
+	juce::Rectangle<int> lower_threshold_amplitude_slider_label_outline;
+	Slider lower_threshold_amplitude_slider;
+	int lower_threshold_amplitude_slider_value;
+
+	juce::Rectangle<int> upper_threshold_amplitude_slider_label_outline;
+	Slider upper_threshold_amplitude_slider;
+	int upper_threshold_amplitude_slider_value;
+
+	juce::Rectangle<int> auto_thresholds_slider_label_outline;
+	Slider auto_thresholds_slider;
+
+	juce::Rectangle<int> spectrogram_histories_slider_label_outline;
+	Slider spectrogram_histories_slider;
+	int spectrogram_histories_slider_value;
+
+	juce::Rectangle<int> smoothing_window_type_slider_label_outline;
+	Slider smoothing_window_type_slider;
+	int smoothing_window_type_slider_value;
+
+	juce::Rectangle<int> smoothing_window_size_slider_label_outline;
+	Slider smoothing_window_size_slider;
+	int smoothing_window_size_slider_value;
+
+	juce::Rectangle<int> analysis_resolution_slider_label_outline;
+	Slider analysis_resolution_slider;
+
+	juce::Rectangle<int> constant_q_slider_label_outline;
+	Slider constant_q_slider;
+
+	juce::Rectangle<int> frequency_scale_slider_label_outline;
+	Slider frequency_scale_slider;
+
+	juce::Rectangle<int> zoom_analysis_slider_label_outline;
+	Slider zoom_analysis_slider;
+
+	juce::Rectangle<int> zoom_band_slider_label_outline;
+	Slider zoom_band_slider;
+
+	juce::Rectangle<int> octave_bands_slider_label_outline;
+	Slider octave_bands_slider;
+
+	juce::Rectangle<int> hold_traces_slider_label_outline;
+	Slider hold_traces_slider;
+
+	juce::Rectangle<int> percentile_spectra_slider_label_outline;
+	Slider percentile_spectra_slider;
+
+	juce::Rectangle<int> peak_labels_slider_label_outline;
+	Slider peak_labels_slider;
+
+	juce::Rectangle<int> feedback_detection_slider_label_outline;
+	Slider feedback_detection_slider;
+
+	//====================//
+
+	GLFWwindow *display_window;
+	struct NVGcontext *nvg_context;
+
+	int gl_success{ 0 };
+	char gl_infolog[512];
+
+	unsigned int gl_texture;
+
+	unsigned int VAO[2], VBO[2];
+
+	int gl_shader_program;
+
+	SpectrogramHistory spectrogram_history;
+
+	int spectrogram_num_frequencies = 1024; //the analysis row, fixed so the statistics kept per frequency never restart
+	int spectrogram_texture_width = 1024; //must be a multiple of 4, the quality governor lowers it
+	int spectrogram_num_past_rows = 256;
+	
+	//====================//
+
+	int display_window_width, display_window_height;
+
+	std::vector<int> frequency_label_values{20,50,100,500,1000,5000,10000,20000}; //the first and last values also control the upper/lower bounds of the display
+	
+	std::vector<int> frequency_gridlines{	20,30,40,50,60,70,80,90,100,
+											200,300,400,500,600,700,800,900,1000,
+											2000,3000,4000,5000,6000,7000,8000,9000,10000,
+											20000 };
+
+	std::vector<int> full_band_label_values, full_band_gridlines; //restored when zoom analysis is turned off
+
+	const std::vector<int> perceptual_label_values{20,200,500,1000,2000,5000,10000,20000}; //mel, Bark and ERB crowd the lows together
+
+	FrequencyScale frequency_scale{ log_scale };
+
+	std::vector<int> rta_amplitude_gridlines{0,-12,-24,-36,-48,-60,-72,-84,-96}; //in dBFS
+
+	MultiResolutionEngine analysis_engine{ spectrogram_num_frequencies, (float)frequency_label_values.front(), (float)frequency_label_values.back() };
+			
+	void timerCallback() override
+	{
+
+		if (soak_end_time_ms > 0.0 && Time::getMillisecondCounterHiRes() > soak_end_time_ms) {
+
+			print_soak_report();
+
+			soak_end_time_ms = 0.0;
+
+			JUCEApplicationBase::quit();
+
+			return;
+
+		}
+
+		if (glfwWindowShouldClose(display_window))
+		{
+			JUCEApplicationBase::quit();
+
+			return;
+		}
+
+		handle_profiler_keys();
+
+		handle_measurement_reset_key();
+
+		handle_hold_reset_keys();
+
+		run_performance_calcs();
+
+		update_feedback_detection();
+
+		if (++ticks_since_analysis < quality_settings.analysis_interval) { //the governor has reduced the analysis rate
+
+			return;
+
+		}
+
+		ticks_since_analysis = 0;
+
+		//The timer only polls. A frame is analysed when at least a hop of new samples has arrived, and the display is
+		//redrawn only for a new frame or a change in what is shown, and never while the window is minimised or hidden.
+
+		SOUNDVIEW_PROFILE_SCOPE("frame");
+
+		bool new_frame = analyse_new_samples();
+
+		if (octave_filter_bank.is_enabled() && octave_filter_bank.get_levels(octave_band_levels, octave_band_frame_index)) {
+
+			display_needs_redraw = true;
+
+		}
+
+		bool window_hidden = glfwGetWindowAttrib(display_window, GLFW_ICONIFIED) || !glfwGetWindowAttrib(display_window, GLFW_VISIBLE);
+
+		int window_width, window_height;
+
+		glfwGetWindowSize(display_window, &window_width, &window_height);
+
+		if (window_width != display_window_width || window_height != display_window_height) {
+
+			display_needs_redraw = true;
+
+		}
+
+		double now_ms = Time::getMillisecondCounterHiRes();
+
+		if (show_profiler_overlay && now_ms - last_render_time_ms > 500.0) { //keep the overlay statistics current when idle
+
+			display_needs_redraw = true;
+
+		}
+
+		if (window_hidden || !(new_frame || display_needs_redraw)) {
+
+			return;
+
+		}
+
+		render_display();
+
+		display_needs_redraw = false;
+		last_render_time_ms = now_ms;
+
+		if (new_frame) {
+
+			display_latency_tracker.add_frame(frame_latency);
+
+			if (quality_governor.add_frame(frame_latency.get_analysis() + (zoom_mode ? zoom_analysis_seconds : 0.0), frame_latency.get_render())) {
+
+				apply_quality_settings();
+
+			}
+
+		}
+
+	}
+
+	bool analyse_new_samples() { //returns false if less than a hop has arrived since the last frame
+
+		if (zoom_mode) {
+
+			return analyse_zoom_spectrum();
+
+		}
+
+		frame_latency.ring_copy_ns = FrameProfiler::get_instance().get_time_ns();
+
+		{
+			SOUNDVIEW_PROFILE_SCOPE("ring_copy");
+
+			std::lock_guard<std::mutex> input_buffer_lock(input_buffer_mtx);
+
+			if (samples_received - samples_received_at_last_frame < minimum_analysis_hop) {
+
+				return false;
+
+			}
+
+			int num_samples_due = analysis_engine.get_num_samples_due(samples_received); //only as much as the longest due band needs
+
+			if (num_samples_due == 0) {
+
+				return false;
+
+			}
+
+			samples_received_at_last_frame = samples_received;
+
+			std::copy(input_sample_buffer.begin(), input_sample_buffer.begin() + num_samples_due, analysis_engine.get_input_samples());
+
+			frame_latency.newest_sample_ns = newest_block_arrival_ns;
+		}
+
+		analysis_engine.analyse_frame(samples_received_at_last_frame);
+
+		if (detect_feedback) {
+
+			SOUNDVIEW_PROFILE_SCOPE("feedback_candidates");
+
+			feedback_monitor.add_frame(feedback_detector, analysis_engine.get_frame_amplitudes(), analysis_engine.get_bin_frequencies(),
+				samples_received_at_last_frame / feedback_detector.get_sample_rate());
+
+		}
+
+		update_spectrogram_texture(); //the history keeps scrolling while the display is hidden
+
+		spectrogram_texture_needs_upload = true;
+
+		update_rta_traces(analysis_engine.get_rta_amplitudes(), analysis_engine.get_bin_frequencies());
+
+		frame_latency.analysis_done_ns = FrameProfiler::get_instance().get_time_ns();
+
+		return true;
+
+	}
+
+	bool analyse_zoom_spectrum() { //returns false until the zoom FFT has a new spectrum
+
+		if (!zoom_fft.get_spectrum(zoom_spectrum, zoom_frame_index) || !zoom_spectrum.valid || zoom_spectrum.frequencies.size() < 2) {
+
+			return false;
+
+		}
+
+		//the spectrum was analysed on the zoom thread, so the ring wait runs from its newest block's arrival to here and
+		//includes that thread's filtering and FFT, which the governor is given on top of the GUI side's analysis
+
+		frame_latency = DisplayLatencyFrame();
+		frame_latency.newest_sample_ns = zoom_spectrum.newest_sample_ns;
+		frame_latency.ring_copy_ns = FrameProfiler::get_instance().get_time_ns();
+
+		zoom_analysis_seconds = zoom_spectrum.processing_seconds;
+
+		update_zoom_spectrogram_texture();
+
+		spectrogram_texture_needs_upload = true;
+
+		update_rta_traces(zoom_spectrum.amplitudes, zoom_spectrum.frequencies);
+
+		frame_latency.analysis_done_ns = FrameProfiler::get_instance().get_time_ns();
+
+		return true;
+
+	}
+
+	void update_rta_traces(const std::vector<float> &rta_amplitudes, const std::vector<float> &frequencies) {
+
+		//once per new frame, so redraws for controls, resizes or the profiler overlay do not count as frames. The render
+		//only reads the results
+
+		if (!zoom_mode && show_hold_traces) {
+
+			SOUNDVIEW_PROFILE_SCOPE("hold_traces");
+
+			double now_ms = Time::getMillisecondCounterHiRes();
+
+			rta_holds.update(rta_amplitudes, last_rta_holds_update_ms > 0.0 ? (now_ms - last_rta_holds_update_ms) * 0.001 : 0.0);
+
+			last_rta_holds_update_ms = now_ms;
+
+		}
+
+		if (show_peak_labels) {
+
+			SOUNDVIEW_PROFILE_SCOPE("peak_tracking");
+
+			rta_peaks.update(rta_amplitudes, frequencies);
+
+		}
+
+	}
+
+	void run_performance_calcs() {
+
+		SOUNDVIEW_PROFILE_SCOPE("performance_stats");
+
+		audio_performance_component.set_ape_analysis_results(audio_performance_engine.get_recent_counts());
+
+		audio_performance_component.set_callback_timing(callback_timing_monitor.get_summary());
+		audio_performance_component.set_display_latency(display_latency_tracker.get_summary());
+		audio_performance_component.set_indicated_xruns(reported_xruns);
+		audio_performance_component.set_spl_readings(spl_meter.get_readings());
+
+		level_meter_ballistics.update(level_meter);
+
+		audio_performance_component.set_level_readings(level_meter_ballistics.get_readings());
+		audio_performance_component.repaint_if_changed();
+			
+	}
+
+	void setup_spl_meter(const StringArray &arguments) { //weightings, Leq interval and per input calibration from the command line
+
+		int weighting_argument = arguments.indexOf("--spl-weighting");
+
+		if (weighting_argument >= 0) {
+
+			String weighting = arguments[weighting_argument + 1].unquoted().toUpperCase();
+
+			spl_meter.set_frequency_weighting(weighting == "C" ? c_weighting : (weighting == "Z" ? z_weighting : a_weighting));
+
+		}
+
+		if (arguments.contains("--spl-slow")) {
+
+			spl_meter.set_time_weighting(slow_time_weighting);
+
+		}
+
+		if (arguments.contains("--spl-interval")) {
+
+			spl_meter.set_interval(arguments[arguments.indexOf("--spl-interval") + 1].getDoubleValue());
+
+		}
+
+		if (arguments.contains("--spl-calibration")) { //dB SPL of a full scale sine, one value for both inputs or "input1,input2"
+
+			StringArray offsets = StringArray::fromTokens(arguments[arguments.indexOf("--spl-calibration") + 1].unquoted(), ",", "");
+
+			for (int channel = 0; channel < SPLMeter::max_channels; channel++) {
+
+				spl_meter.set_calibration_offset(channel, offsets[jmin(channel, offsets.size() - 1)].getFloatValue());
+
+			}
+
+		}
+
+	}
+
+	void setup_virtual_audio_device(const StringArray &arguments) {
+
+		//the virtual test signal device is always listed in the device selector, the command line can also open it at start up
+
+		deviceManager.addAudioDeviceType(new VirtualAudioIODeviceType(VirtualAudioIODeviceType::settings_from_arguments(arguments)));
+
+		int device_argument = arguments.indexOf("--virtual-device");
+
+		if (device_argument < 0) {
+
+			return;
+
+		}
+
+		String device_name = arguments[device_argument + 1].unquoted();
+
+		if (!VirtualAudioIODevice::get_signal_names().contains(device_name)) {
+
+			device_name = VirtualAudioIODevice::get_signal_names()[0];
+
+		}
+
+		deviceManager.setCurrentAudioDeviceType(VirtualAudioIODeviceType::get_type_name(), true);
+
+		AudioDeviceManager::AudioDeviceSetup device_setup;
+		deviceManager.getAudioDeviceSetup(device_setup);
+
+		device_setup.inputDeviceName = device_name;
+		device_setup.outputDeviceName = device_name;
+		device_setup.useDefaultInputChannels = false;
+		device_setup.inputChannels.clear();
+		device_setup.inputChannels.setRange(0, 2, true);
+
+		if (arguments.contains("--virtual-rate")) {
+
+			device_setup.sampleRate = arguments[arguments.indexOf("--virtual-rate") + 1].getDoubleValue();
+
+		}
+
+		if (arguments.contains("--virtual-block")) {
+
+			device_setup.bufferSize = arguments[arguments.indexOf("--virtual-block") + 1].getIntValue();
+
+		}
+
+		deviceManager.setAudioDeviceSetup(device_setup, true);
+
+	}
+
+	void print_soak_report() {
+
+		CallbackTimingSummary callback_timing = callback_timing_monitor.get_summary();
+
+		std::cout	<< "Xruns: " << deviceManager.getXRunCount() << ", callbacks: " << callback_timing.num_callbacks
+					<< ", buffer period: " << callback_timing.buffer_period * 1000.0 << " ms" << std::endl;
+
+		std::cout	<< "Callback time p50/p99/p99.9/max: " << callback_timing.duration_p50 * 1000.0 << " / " << callback_timing.duration_p99 * 1000.0
+					<< " / " << callback_timing.duration_p999 * 1000.0 << " / " << callback_timing.duration_max * 1000.0 << " ms ("
+					<< callback_timing.get_percent_of_period(callback_timing.duration_p999) << "% of the buffer period at p99.9)" << std::endl;
+
+		std::cout	<< "Callback jitter p50/p99/p99.9/max: " << callback_timing.jitter_p50 * 1000.0 << " / " << callback_timing.jitter_p99 * 1000.0
+					<< " / " << callback_timing.jitter_p999 * 1000.0 << " / " << callback_timing.jitter_max * 1000.0 << " ms" << std::endl;
+
+		DisplayLatencySummary display_latency = display_latency_tracker.get_summary();
+
+		std::cout	<< "Input to display p50/p99/max: " << display_latency.total_p50 * 1000.0 << " / " << display_latency.total_p99 * 1000.0
+					<< " / " << display_latency.total_max * 1000.0 << " ms (p50 ring wait " << display_latency.ring_wait_p50 * 1000.0
+					<< ", analysis " << display_latency.analysis_p50 * 1000.0 << ", render " << display_latency.render_p50 * 1000.0 << " ms)" << std::endl;
+
+		SampleHealthCounts sample_health = audio_performance_engine.get_total_counts();
+
+		std::cout	<< "Input 1 samples: " << sample_health.zeroed << " zeroed, " << sample_health.out_of_range << " out of range, "
+					<< sample_health.non_finite << " NaN/Inf" << std::endl;
+
+		level_meter_ballistics.update(level_meter);
+
+		LevelReadings levels = level_meter_ballistics.get_readings();
+
+		std::cout	<< "Input 1 overs: " << levels.sample_overs[0] << " sample, " << levels.true_peak_overs[0] << " true peak (max "
+					<< levels.max_true_peak[0] << " dBTP)" << std::endl;
+
+		VirtualAudioIODevice* virtual_device = dynamic_cast<VirtualAudioIODevice*>(deviceManager.getCurrentAudioDevice());
+
+		if (virtual_device != nullptr) {
+
+			VirtualAudioDeviceStatistics statistics = virtual_device->get_statistics();
+
+			double audio_seconds = statistics.samples_delivered / virtual_device->getCurrentSampleRate();
+
+			std::cout	<< "Virtual device: " << statistics.blocks_delivered << " blocks, " << audio_seconds << " s of audio in "
+						<< statistics.wall_seconds << " s (" << audio_seconds / statistics.wall_seconds << "x real time)" << std::endl;
+
+			if (detect_feedback && virtual_device->getName() == VirtualAudioIODevice::get_signal_names()[VirtualAudioIODevice::feedback_build_up]) {
+
+				print_feedback_latency_report(audio_seconds);
+
+			}
+
+		}
+
+	}
+
+	void print_feedback_latency_report(double audio_seconds) {
+
+		//detection latency against the virtual feedback build-up: from the tone's onset in each cycle to the first
+		//confirmation near its frequency
+
+		typedef VirtualAudioIODevice device;
+
+		double sample_rate = feedback_detector.get_sample_rate();
+
+		int num_build_ups = audio_seconds > device::feedback_onset_seconds ? (int)((audio_seconds - device::feedback_onset_seconds) / device::feedback_cycle_seconds) + 1 : 0;
+
+		int64_t last_cycle = -1;
+		int num_detected = 0, num_false = 0;
+		double latency_sum = 0.0, latency_max = 0.0, frequency_error_max = 0.0;
+
+		int64_t num_confirmations = feedback_monitor.get_num_confirmations();
+		int64_t first_confirmation = jmax((int64_t)0, num_confirmations - FeedbackMonitor::max_confirmations);
+
+		if (first_confirmation > 0) { //only the last confirmations are kept, so only the build-ups they span are counted
+
+			num_build_ups -= (int)(feedback_monitor.get_confirmation(first_confirmation).sample / sample_rate / device::feedback_cycle_seconds);
+
+		}
+
+		for (int64_t confirmation = first_confirmation; confirmation < num_confirmations; confirmation++) {
+
+			FeedbackConfirmation result = feedback_monitor.get_confirmation(confirmation);
+
+			double seconds = result.sample / sample_rate;
+			double cycle_seconds = fmod(seconds, device::feedback_cycle_seconds);
+			int64_t cycle = (int64_t)(seconds / device::feedback_cycle_seconds);
+
+			double frequency_error = std::abs(result.frequency - device::feedback_frequency);
+
+			if (cycle_seconds < device::feedback_onset_seconds || cycle_seconds >= device::feedback_stop_seconds || frequency_error > 10.0) {
+
+				num_false++;
+
+				continue;
+
+			}
+
+			if (cycle == last_cycle) { //one per build-up
+
+				continue;
+
+			}
+
+			last_cycle = cycle;
+
+			double latency = cycle_seconds - device::feedback_onset_seconds;
+
+			num_detected++;
+			latency_sum += latency;
+			latency_max = jmax(latency_max, latency);
+			frequency_error_max = jmax(frequency_error_max, frequency_error);
+
+		}
+
+		double latency_mean = num_detected > 0 ? latency_sum / num_detected : 0.0;
+
+		std::cout	<< "Feedback build-ups detected: " << num_detected << " of " << num_build_ups << ", latency mean/max " << latency_mean << " / "
+					<< latency_max << " s (tone at " << jmin(device::feedback_highest_dBFS, device::feedback_start_dBFS + device::feedback_growth_dB_per_second * latency_mean)
+					<< " dBFS at the mean), frequency error max " << frequency_error_max << " Hz, " << num_false << " other confirmations" << std::endl;
+
+	}
+
+	void sliderValueChanged(Slider* slider) override
+		
+	{
+
+		display_needs_redraw = true;
+
+		if (slider == &num_rta_averages_slider) {
+
+			num_rta_averages_slider_value = num_rta_averages_slider.getValue();
+
+			analysis_engine.set_num_averages(num_rta_averages_slider_value);
+
+		}
+
+		if (slider == &averaging_mode_slider) {
+
+			analysis_engine.set_averaging_mode((AveragingMode)(int)averaging_mode_slider.getValue());
+
+		}
+
+		if (slider == &lower_threshold_amplitude_slider) {
+
+			lower_threshold_amplitude_slider_value = lower_threshold_amplitude_slider.getValue();
+
+			auto_thresholds_slider.setValue(0); //setting a threshold by hand goes back to manual
+
+		}
+
+		if (slider == &upper_threshold_amplitude_slider) {
+
+			upper_threshold_amplitude_slider_value = upper_threshold_amplitude_slider.getValue();
+
+			auto_thresholds_slider.setValue(0);
+
+		}
+
+		if (slider == &auto_thresholds_slider) {
+
+			auto_thresholds = auto_thresholds_slider.getValue() == 1;
+
+			spectrogram_auto_range.reset();
+
+			last_auto_range_update_ms = 0.0;
+
+		}
+
+		if (slider == &spectrogram_histories_slider) {
+
+			spectrogram_num_past_rows = spectrogram_histories_slider.getValue();
+
+		}
+
+		if (slider == &smoothing_window_type_slider) {
+
+			smoothing_window_type_slider_value = smoothing_window_type_slider.getValue();
+
+			apply_smoothing();
+
+		}
+
+		if (slider == &smoothing_window_size_slider) {
+
+			smoothing_window_size_slider_value = smoothing_window_size_slider.getValue();
+
+			apply_smoothing();
+
+		}
+
+		if (slider == &analysis_resolution_slider) {
+
+			apply_analysis_resolution();
+
+			rta_holds.reset();
+
+			rta_peaks.reset();
+
+			feedback_monitor.reset(feedback_detector);
+
+		}
+
+		if (slider == &constant_q_slider) {
+
+			analysis_engine.set_constant_q(constant_q_slider.getValue());
+
+			rta_holds.reset();
+
+			rta_peaks.reset();
+
+			feedback_monitor.reset(feedback_detector);
+
+		}
+
+		if (slider == &frequency_scale_slider) {
+
+			frequency_scale = (FrequencyScale)(int)frequency_scale_slider.getValue();
+
+			analysis_engine.set_frequency_scale(frequency_scale);
+
+			rta_holds.reset();
+
+			rta_peaks.reset();
+
+			feedback_monitor.reset(feedback_detector);
+
+			set_frequency_axis();
+
+			repaint(); //the label shows the scale
+
+		}
+
+		if (slider == &zoom_analysis_slider) {
+
+			zoom_mode = zoom_analysis_slider.getValue() == 1;
+
+			zoom_fft.set_enabled(zoom_mode);
+
+			spectrogram_auto_range.reset(); //the thresholds hold until the zoomed rows have been measured
+
+			rta_peaks.reset();
+
+			set_frequency_axis();
+
+		}
+
+		if (slider == &zoom_band_slider) {
+
+			zoom_band_low = zoom_band_slider.getMinValue();
+			zoom_band_high = jmax((int)zoom_band_slider.getMaxValue(), zoom_band_low + 10); //narrower bands would need a longer FFT
+
+			zoom_fft.set_band(zoom_band_low, zoom_band_high);
+
+			set_frequency_axis();
+
+			repaint(); //the label shows the band
+
+		}
+
+		if (slider == &octave_bands_slider) {
+
+			int octave_bands_mode = (int)octave_bands_slider.getValue();
+
+			if (octave_bands_mode > 0) {
+
+				octave_filter_bank.set_bands_per_octave(octave_bands_mode == 1 ? 1 : 3);
+
+			}
+
+			octave_filter_bank.set_enabled(octave_bands_mode > 0);
+
+			octave_band_levels.valid = false;
+
+			display_needs_redraw = true;
+
+		}
+
+		if (slider == &hold_traces_slider) {
+
+			show_hold_traces = hold_traces_slider.getValue() == 1;
+
+			rta_holds.reset(); //each time they are turned on the traces start from the current spectrum
+
+			last_rta_holds_update_ms = 0.0;
+
+		}
+
+		if (slider == &percentile_spectra_slider) {
+
+			show_percentile_spectra = percentile_spectra_slider.getValue() == 1;
+
+			percentile_spectrum.reset();
+
+		}
+
+		if (slider == &peak_labels_slider) {
+
+			show_peak_labels = peak_labels_slider.getValue() == 1;
+
+			rta_peaks.reset();
+
+		}
+
+		if (slider == &feedback_detection_slider) {
+
+			detect_feedback = feedback_detection_slider.getValue() == 1;
+
+			feedback_monitor.reset(feedback_detector);
+
+		}
+				
+	}
+
+	void apply_smoothing() { //the slider setting, limited by the quality governor
+
+		analysis_engine.set_smoothing(smoothing_window_type_slider_value, jmin(smoothing_window_size_slider_value, quality_settings.max_smoothing_window_size));
+
+	}
+
+	void apply_analysis_resolution() { //one 16384 point FFT, or 64k below 200 Hz, 16k to 5 kHz and 2k above
+
+		if (analysis_resolution_slider.getValue() == 1) {
+
+			analysis_engine.set_bands(MultiResolutionEngine::get_multi_resolution_bands());
+
+		}
+
+		else {
+
+			analysis_engine.set_bands(MultiResolutionEngine::get_single_resolution_bands(fft_size, minimum_analysis_hop));
+
+		}
+
+	}
+
+	void apply_quality_settings() {
+
+		QualitySettings new_settings = quality_governor.get_settings();
+
+		if (new_settings.render_rate_hz != quality_settings.render_rate_hz) {
+
+			startTimerHz(new_settings.render_rate_hz);
+
+		}
+
+		//only the texture narrows, the analysis rows keep their frequencies, so the RTA bins of constant-Q and the
+		//perceptual scales, the averages and the per frequency statistics are not lost to a load spike
+
+		spectrogram_texture_width = new_settings.spectrogram_texture_width;
+
+		quality_settings = new_settings;
+
+		apply_smoothing();
+
+		display_needs_redraw = true;
+
+	}
+
+	void set_frequency_axis() { //the frequency scale over the full band, or linear over the zoom band with round number labels
+
+		if (!zoom_mode) {
+
+			frequency_label_values = frequency_scale == log_scale ? full_band_label_values : perceptual_label_values;
+			frequency_gridlines = full_band_gridlines;
+
+			return;
+
+		}
+
+		double rough_step = (zoom_band_high - zoom_band_low) / 5.0;
+		double magnitude = pow(10.0, floor(log10(rough_step)));
+
+		int step = magnitude * (rough_step <= magnitude * 2.0 ? 2 : rough_step <= magnitude * 5.0 ? 5 : 10);
+
+		frequency_label_values = { zoom_band_low };
+		frequency_gridlines = { zoom_band_low };
+
+		for (int frequency = (zoom_band_low / step + 1) * step; frequency < zoom_band_high; frequency += step) {
+
+			frequency_gridlines.push_back(frequency);
+
+			if (frequency - zoom_band_low > step / 2 && zoom_band_high - frequency > step / 2) { //keep clear of the end labels
+
+				frequency_label_values.push_back(frequency);
+
+			}
+
+		}
+
+		frequency_label_values.push_back(zoom_band_high);
+		frequency_gridlines.push_back(zoom_band_high);
+
+	}
+
+	void buttonClicked(Button* button) override 
+	{
+		
+	}
+
+	void update_spectrogram_texture() {
+
+		SOUNDVIEW_PROFILE_SCOPE("spectrogram_row");
+
+		spectrogram_history.set_size(spectrogram_texture_width, spectrogram_num_past_rows);
+
+		const std::vector<float>& spectrogram_row = analysis_engine.update_spectrogram_amplitudes();
+
+		spectrogram_history.add_row(spectrogram_row);
+
+		if (!auto_thresholds && !show_percentile_spectra) {
+
+			return;
+
+		}
+
+		//the long term statistics keep their bins whatever the frequency scale, constant-Q or resolution
+
+		const std::vector<float>& measurement_row = measurement_grid.resample(spectrogram_row, analysis_engine.get_spectrogram_frequencies());
+
+		update_auto_thresholds(measurement_row);
+
+		if (show_percentile_spectra) { //unaveraged levels, so the statistics do not depend on the RTA settings
+
+			SOUNDVIEW_PROFILE_SCOPE("percentile_spectra");
+
+			percentile_spectrum.update(measurement_row);
+
+			if (percentile_spectrum.get_num_frames() == 1) { //the first frame since a reset
+
+				percentile_spectrum_start_ms = Time::getMillisecondCounterHiRes();
+
+			}
+
+		}
+
+	}
+
+	void update_zoom_spectrogram_texture() { //the zoom spectrum linearly interpolated across the spectrogram's width
+
+		SOUNDVIEW_PROFILE_SCOPE("spectrogram_row");
+
+		zoom_spectrogram_row.resize(spectrogram_num_frequencies);
+
+		const std::vector<float> &frequencies = zoom_spectrum.frequencies;
+		const std::vector<float> &amplitudes = zoom_spectrum.amplitudes;
+
+		int bin = 0;
+
+		for (int column = 0; column < spectrogram_num_frequencies; column++) {
+
+			float frequency = zoom_band_low + ((zoom_band_high - zoom_band_low) * column) / (spectrogram_num_frequencies - 1.0f);
+
+			while (bin + 2 < frequencies.size() && frequencies[bin + 1] < frequency) {
+
+				bin++;
+
+			}
+
+			float fraction = jlimit(0.0f, 1.0f, (frequency - frequencies[bin]) / (frequencies[bin + 1] - frequencies[bin]));
+
+			zoom_spectrogram_row[column] = fft_amp_to_dBFS(amplitudes[bin] + (amplitudes[bin + 1] - amplitudes[bin]) * fraction);
+
+		}
+
+		spectrogram_history.set_size(spectrogram_texture_width, spectrogram_num_past_rows);
+
+		spectrogram_history.add_row(zoom_spectrogram_row);
+
+		update_auto_thresholds(zoom_spectrogram_row);
+
+	}
+
+	void update_auto_thresholds(const std::vector<float> &spectrogram_row) { //the sliders follow, so manual starts from there
+
+		if (!auto_thresholds) {
+
+			return;
+
+		}
+
+		SOUNDVIEW_PROFILE_SCOPE("auto_thresholds");
+
+		double now_ms = Time::getMillisecondCounterHiRes();
+
+		spectrogram_auto_range.update(spectrogram_row, last_auto_range_update_ms > 0.0 ? (now_ms - last_auto_range_update_ms) * 0.001 : 0.0);
+
+		last_auto_range_update_ms = now_ms;
+
+		if (spectrogram_auto_range.has_limits()) {
+
+			lower_threshold_amplitude_slider_value = roundToInt(spectrogram_auto_range.get_lower_limit());
+			upper_threshold_amplitude_slider_value = roundToInt(spectrogram_auto_range.get_upper_limit());
+
+			lower_threshold_amplitude_slider.setValue(lower_threshold_amplitude_slider_value, dontSendNotification);
+			upper_threshold_amplitude_slider.setValue(upper_threshold_amplitude_slider_value, dontSendNotification);
+
+		}
+
+	}
+
+	void setup_GL(int screen_width) {
+
+		glfwInit();
+
+		//glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		//glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+		//glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_ANY_PROFILE);
+
+		display_window = glfwCreateWindow(screen_width*0.5, screen_width*0.5, "SoundView Display", NULL, NULL);
+
+		if (display_window == NULL) {
+
+			AlertWindow::showMessageBox(AlertWindow::AlertIconType::WarningIcon, "ERROR", "GLFW could not set up a window", "OK", NULL);
+
+		}
+
+		glfwMakeContextCurrent(display_window);
+
+		if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+
+			AlertWindow::showMessageBox(AlertWindow::AlertIconType::WarningIcon, "ERROR", "GLAD could not be initialized", "OK", NULL);
+
+		}
+
+		Shader glShader{
+			"D://Active//SoundView//Source//vertex_shader.vert",
+			"D://Active//SoundView//Source//fragment_shader.frag"
+		};
+
+		gl_shader_program = glShader.ID;
+		
+		//==========//
+		
+		glGenTextures(1, &gl_texture);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		//==========//
+
+		glGenVertexArrays(2, VAO);
+		glGenBuffers(2, VBO);
+		
+		//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); //this will configure OpenGL to render in wireframe mode
+		
+		//==//
+
+		nvg_context = nvgCreateGL2(NVG_ANTIALIAS | NVG_STENCIL_STROKES);
+
+		nvgCreateFont(nvg_context, "Arial", "C://Windows//Fonts//arial.ttf");
+		
+	}
+
+	void render_display() {
+
+		glfwGetWindowSize(display_window, &display_window_width, &display_window_height);
+
+		glViewport(0, 0, display_window_width, display_window_height);
+
+		calc_layout();
+
+		glUseProgram(gl_shader_program);
+
+		float triangle1[] = {
+			-1.0f, -1.0f, 0.0f,		0.0f,0.0f,  // bottom left
+			-1.0f, 0.0f, 0.0f,		0.0f,1.0f,	// top left
+			1.0f, 0.0f, 0.0f,		1.0f,1.0f	// top right
+		};
+
+		float triangle2[] = {
+			-1.0f, -1.0f, 0.0f,		0.0f,0.0f,  // bottom left
+			1.0f, 0.0f, 0.0f,		1.0f,1.0f,	// top right
+			1.0f, -1.0f, 0.0f,		1.0f,0.0f	// bottom right
+		};
+
+		glBindVertexArray(VAO[0]);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(triangle1), triangle1, GL_DYNAMIC_DRAW);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+
+		glBindVertexArray(VAO[1]);
+		glBindBuffer(GL_ARRAY_BUFFER, VBO[1]);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(triangle2), triangle2, GL_DYNAMIC_DRAW);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+
+		glUniform1i(glGetUniformLocation(gl_shader_program, "ourTexture"), 0); //specify which texture unit the frag shader will use
+		glActiveTexture(GL_TEXTURE0); //some drivers require the active texture unit to be specified
+		glBindTexture(GL_TEXTURE_2D, gl_texture);
+
+		if (spectrogram_texture_needs_upload && spectrogram_history.get_num_rows() > 0) { //only re-upload when a row was added
+
+			SOUNDVIEW_PROFILE_SCOPE("texture_upload");
+
+			int spectrogram_texture_pixel_count = spectrogram_history.get_num_pixels();
+
+			unsigned char* spectrogram_texture_pixels;
+			spectrogram_texture_pixels = (unsigned char*) malloc(spectrogram_texture_pixel_count * sizeof(unsigned char));
+
+			spectrogram_history.copy_pixels(spectrogram_texture_pixels);
+
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, spectrogram_history.get_num_frequencies(), spectrogram_history.get_num_rows(), 0, GL_RED, GL_UNSIGNED_BYTE, spectrogram_texture_pixels);
+			glGenerateMipmap(GL_TEXTURE_2D);
+
+			free(spectrogram_texture_pixels);
+
+			spectrogram_texture_needs_upload = false;
+
+		}
+
+		bool use_auto_thresholds = auto_thresholds && spectrogram_auto_range.has_limits();
+
+		Shader::setOutsideFloat(gl_shader_program, "lower_amplitude_limit", use_auto_thresholds ? spectrogram_auto_range.get_lower_limit() : lower_threshold_amplitude_slider_value);
+		Shader::setOutsideFloat(gl_shader_program, "upper_amplitude_limit", use_auto_thresholds ? spectrogram_auto_range.get_upper_limit() : upper_threshold_amplitude_slider_value);
+		Shader::setOutsideFloat(gl_shader_program, "dBFS_lower_limit", dBFS_lower_limit);
+		
+		glClearColor(0.0, 0.0, 0.0, 1.0);
+		glClear(GL_COLOR_BUFFER_BIT);
+						
+		glBindVertexArray(VAO[0]);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+
+		glBindVertexArray(VAO[1]);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+
+		{
+			SOUNDVIEW_PROFILE_SCOPE("nanovg");
+
+			nvg_render(nvg_context);
+		}
+
+		{
+			SOUNDVIEW_PROFILE_SCOPE("swap_buffers");
+
+			glfwSwapBuffers(display_window);
+		}
+
+		frame_latency.presented_ns = FrameProfiler::get_instance().get_time_ns();
+
+	}
+
+	void calc_layout() {
+
+		display_window_outline = juce::Rectangle<int>{ 0, 0, display_window_width, display_window_height };
+
+		rta_outline = display_window_outline.removeFromTop(display_window_outline.getHeight()*0.48);
+
+		frequency_label_outline = display_window_outline.removeFromTop(display_window_outline.getHeight()*0.04);
+
+		spectrogram_outline = display_window_outline;
+
+	}
+
+	void nvg_render(NVGcontext *ctx)
+	{
+		nvgBeginFrame(ctx, display_window_width, display_window_height, 1.0f);
+
+		//==========//
+
+		nvgStrokeWidth(ctx, 2);
+
+		nvgStrokeColor(ctx, nvgRGBA(255, 127, 0, 255));
+		
+		//render_juce_int_rect(ctx, rta_outline);
+
+		//render_juce_int_rect(ctx, frequency_label_outline);
+		
+		//render_juce_int_rect(ctx, spectrogram_outline);
+
+		//////////
+
+		int font_size = frequency_label_outline.getHeight() * 0.8;
+
+		char int_string[33];
+
+		memset(int_string, 0, sizeof int_string);
+
+		itoa(frequency_label_values.front(), int_string, 10);
+
+		render_text(ctx, int_string, frequency_label_outline.getX() + 5, frequency_label_outline.getCentreY(), font_size, 1, FALSE);
+
+		memset(int_string, 0, sizeof int_string);
+
+		itoa(frequency_label_values.back(), int_string, 10);
+
+		render_text(ctx, int_string, frequency_label_outline.getTopRight().getX() - 5, frequency_label_outline.getCentreY(), font_size, 2, FALSE);
+
+		for (int x = 1; x < frequency_label_values.size() - 1; x++) {
+
+			memset(int_string, 0, sizeof int_string);
+
+			itoa(frequency_label_values[x], int_string, 10);
+
+			render_text(ctx, 
+						int_string, 
+						frequency_label_outline.getX() + frequency_label_outline.getWidth() * frequency_to_x_proportion(frequency_label_values[x]), 
+						frequency_label_outline.getCentreY(), 
+						font_size,
+						0, 
+						FALSE);
+
+		}
+
+		//////////
+
+		for (int x = 0; x < frequency_gridlines.size(); x++)
+		{
+
+			nvgStrokeWidth(ctx, 1);
+
+			nvgStrokeColor(ctx, nvgRGBA(40, 40, 40, 255));
+			
+			nvgBeginPath(ctx);
+
+			nvgMoveTo(ctx, rta_outline.getX() + rta_outline.getWidth() * frequency_to_x_proportion(frequency_gridlines[x]), rta_outline.getY());
+
+			nvgLineTo(ctx, rta_outline.getX() + rta_outline.getWidth() * frequency_to_x_proportion(frequency_gridlines[x]), rta_outline.getBottomLeft().getY());
+
+			nvgStroke(ctx);
+
+		}
+
+		//////////
+
+		for (int x = 0; x < rta_amplitude_gridlines.size(); x++)
+		{
+
+			nvgStrokeWidth(ctx, 1);
+
+			nvgStrokeColor(ctx, nvgRGBA(40, 40, 40, 255));
+
+			nvgBeginPath(ctx);
+
+			nvgMoveTo(ctx, rta_outline.getX(), rta_outline.getY() + rta_outline.getHeight() * rta_dBFS_to_y_proportion(rta_amplitude_gridlines[x]));
+
+			nvgLineTo(ctx, rta_outline.getTopRight().getX(), rta_outline.getY() + rta_outline.getHeight() * rta_dBFS_to_y_proportion(rta_amplitude_gridlines[x]));
+
+			nvgStroke(ctx);
+
+		}
+
+		//////////
+
+		if (!zoom_mode && octave_filter_bank.is_enabled() && octave_band_levels.valid) {
+
+			render_octave_band_levels(ctx);
+
+		}
+
+		//////////
+
+		//zoom spectra are drawn as they are, without the RTA's averaging, smoothing and hold traces
+
+		const std::vector<float>& rta_amplitudes = zoom_mode ? zoom_spectrum.amplitudes : analysis_engine.get_rta_amplitudes();
+
+		const std::vector<float>& fft_bin_freqs = zoom_mode ? zoom_spectrum.frequencies : analysis_engine.get_bin_frequencies();
+
+		if (!zoom_mode && show_percentile_spectra && percentile_spectrum.get_num_frames() > 0) {
+
+			render_percentile_spectra(ctx);
+
+		}
+
+		if (!zoom_mode && show_hold_traces) {
+
+			render_hold_traces(ctx, fft_bin_freqs);
+
+		}
+
+		render_rta_trace(ctx, rta_amplitudes, fft_bin_freqs, nvgRGBA(255, 127, 0, 255));
+
+		if (show_peak_labels) {
+
+			render_peak_labels(ctx);
+
+		}
+
+		if (detect_feedback) {
+
+			render_feedback_candidates(ctx);
+
+		}
+
+		//////////
+
+		render_delay_finder_result(ctx);
+
+		render_loudness(ctx);
+
+		if (zoom_mode && zoom_spectrum.valid) {
+
+			char zoom_string[128];
+
+			snprintf(zoom_string, sizeof zoom_string, "Zoom %d - %d Hz  Resolution %.3f Hz  Update %.2f s  Decimation %d",
+				zoom_band_low, zoom_band_high, zoom_spectrum.resolution, zoom_spectrum.update_interval, zoom_spectrum.decimation);
+
+			nvgFillColor(ctx, nvgRGBA(255, 255, 255, 255));
+
+			render_text(ctx, zoom_string, rta_outline.getX() + 5, rta_outline.getY() + frequency_label_outline.getHeight() * 0.5, frequency_label_outline.getHeight() * 0.6, 1, FALSE);
+
+		}
+
+		if (show_profiler_overlay) {
+
+			render_profiler_overlay(ctx);
+
+		}
+
+		if (quality_governor.is_reduced()) {
+
+			String reductions = "Reduced quality: " + quality_governor.describe_reductions();
+
+			nvgFillColor(ctx, nvgRGBA(255, 200, 0, 255));
+
+			render_text(ctx, reductions.toRawUTF8(), rta_outline.getX() + 5, rta_outline.getBottom() - frequency_label_outline.getHeight() * 0.5, frequency_label_outline.getHeight() * 0.6, 1, FALSE);
+
+		}
+
+		//==========//
+
+		nvgEndFrame(ctx);
+
+	}
+
+	void render_text(	NVGcontext *ctx, const char* text, int pos_x_pix, int pos_y_pix, 
+						int font_size_pix, int positioning, bool show_bounding_box) {
+		
+		//Positioning values are 0 = center, 1 = middle left edge, 2 = middle right edge
+
+		int font_x, font_y;
+
+		float font_bounds[4];
+
+		nvgFontSize(ctx, font_size_pix);
+
+		nvgTextAlign(ctx, NVGalign::NVG_ALIGN_BOTTOM);
+
+		nvgTextBounds(ctx, 0.0, 0.0, text, NULL, font_bounds);
+
+		int font_width = font_bounds[2] - font_bounds[0];
+
+		int font_height = font_bounds[3] - font_bounds[1];
+
+		if (positioning == 0) {
+
+			font_x = pos_x_pix - (font_width / 2);
+
+			font_y = pos_y_pix + (font_height / 2);
+
+		}
+
+		if (positioning == 1) {
+
+			font_x = pos_x_pix;
+
+			font_y = pos_y_pix + (font_height / 2);
+
+		}
+
+		if (positioning == 2) {
+
+			font_x = pos_x_pix - font_width;
+
+			font_y = pos_y_pix + (font_height / 2);
+
+		}
+
+		nvgText(ctx, font_x, font_y, text, NULL);
+
+		if (show_bounding_box == true) {
+
+			nvgStrokeWidth(ctx, 1);
+
+			nvgStrokeColor(ctx, nvgRGBA(255, 255, 255, 255));
+
+			nvgBeginPath(ctx);
+
+			nvgRect(ctx, font_x, font_y - font_height, font_width, font_height);
+
+			nvgStroke(ctx);
+
+		}
+		
+	}
+
+	void render_delay_finder_result(NVGcontext *ctx) {
+
+		DelayFinderResult delay = delay_finder.get_tracked_result();
+
+		DelayFinderResult latest_delay = delay_finder.get_latest_result();
+
+		if (!latest_delay.valid || !delay_reference_active.load()) {
+
+			return;
+
+		}
+
+		char delay_string[128];
+
+		if (delay.valid) {
+
+			snprintf(delay_string, sizeof delay_string, "Delay %.3f ms (%.1f samples%s)  Confidence %.2f",
+				delay.delay_ms, delay.delay_samples, delay.polarity_inverted ? ", inverted" : "", latest_delay.confidence);
+
+		}
+
+		else {
+
+			snprintf(delay_string, sizeof delay_string, "Delay --  Confidence %.2f", latest_delay.confidence);
+
+		}
+
+		nvgFillColor(ctx, nvgRGBA(255, 255, 255, 255));
+
+		render_text(ctx, delay_string, rta_outline.getTopRight().getX() - 5, rta_outline.getY() + frequency_label_outline.getHeight() * 0.5, frequency_label_outline.getHeight() * 0.6, 2, FALSE);
+
+	}
+
+	void render_rta_trace(NVGcontext *ctx, const std::vector<float> &amplitudes, const std::vector<float> &frequencies, NVGcolor colour) {
+
+		//bins that land in the same pixel column are reduced to their highest and lowest points, so a 64k FFT costs
+		//no more path points than the display is wide
+
+		int first_bin = frequencies.size() > 0 && frequencies[0] <= 0.0f ? 1 : 0; //a DC bin has no place on the log axis
+
+		int num_bins = (int)std::min(amplitudes.size(), frequencies.size());
+
+		if (num_bins <= first_bin) {
+
+			return;
+
+		}
+
+		nvgStrokeWidth(ctx, 1);
+
+		nvgStrokeColor(ctx, colour);
+
+		nvgBeginPath(ctx);
+
+		bool path_started = false;
+		int column = 0;
+		float column_x = 0.0f, column_top = 0.0f, column_bottom = 0.0f;
+
+		for (int x = first_bin; x <= num_bins; x++) {
+
+			float point_x = 0.0f, point_y = 0.0f;
+
+			if (x < num_bins) {
+
+				point_x = rta_outline.getX() + rta_outline.getWidth() * frequency_to_x_proportion(frequencies[x]);
+				point_y = rta_outline.getY() + rta_outline.getHeight() * rta_dBFS_to_y_proportion(fft_amp_to_dBFS(amplitudes[x]));
+
+				if (x > first_bin && (int)point_x == column) {
+
+					column_top = jmin(column_top, point_y);
+					column_bottom = jmax(column_bottom, point_y);
+
+					continue;
+
+				}
+
+			}
+
+			if (x > first_bin) { //the previous column is complete
+
+				if (path_started) { nvgLineTo(ctx, column_x, column_top); }
+				else { nvgMoveTo(ctx, column_x, column_top); }
+
+				if (column_bottom != column_top) {
+
+					nvgLineTo(ctx, column_x, column_bottom);
+
+				}
+
+				path_started = true;
+
+			}
+
+			column = (int)point_x;
+			column_x = point_x;
+			column_top = column_bottom = point_y;
+
+		}
+
+		nvgStroke(ctx);
+
+	}
+
+	void render_hold_traces(NVGcontext *ctx, const std::vector<float> &frequencies) { //updated in update_rta_traces
+
+		if (rta_holds.has_min_hold()) {
+
+			render_rta_trace(ctx, rta_holds.get_min_hold(), frequencies, nvgRGBA(0, 150, 255, 200));
+
+		}
+
+		if (rta_holds.has_decaying_peak()) {
+
+			render_rta_trace(ctx, rta_holds.get_decaying_peak(), frequencies, nvgRGBA(255, 230, 0, 200));
+
+		}
+
+		if (rta_holds.has_peak_hold()) {
+
+			render_rta_trace(ctx, rta_holds.get_peak_hold(), frequencies, nvgRGBA(255, 40, 40, 200));
+
+		}
+
+	}
+
+	void render_feedback_candidates(NVGcontext *ctx) { //a line at each candidate, red once confirmed, with its growth below the top row
+
+		const std::vector<FeedbackReport> &reports = feedback_monitor.get_reports();
+
+		int font_size = frequency_label_outline.getHeight() * 0.6;
+
+		for (int candidate = 0; candidate < reports.size(); candidate++) {
+
+			const FeedbackReport &report = reports[candidate];
+
+			float x_proportion = frequency_to_x_proportion(report.frequency);
+
+			if (x_proportion < 0.0f || x_proportion > 1.0f) {
+
+				continue;
+
+			}
+
+			NVGcolor colour = report.confirmed ? nvgRGBA(255, 40, 40, 255) : nvgRGBA(255, 170, 0, 255);
+
+			float line_x = rta_outline.getX() + rta_outline.getWidth() * x_proportion;
+
+			nvgStrokeWidth(ctx, report.confirmed ? 3 : 1);
+
+			nvgStrokeColor(ctx, colour);
+
+			nvgBeginPath(ctx);
+
+			nvgMoveTo(ctx, line_x, rta_outline.getY());
+
+			nvgLineTo(ctx, line_x, rta_outline.getBottom());
+
+			nvgStroke(ctx);
+
+			char feedback_string[128];
+
+			int length = snprintf(feedback_string, sizeof feedback_string, "%s%.1f Hz  %+.1f dB/s", report.confirmed ? "FEEDBACK " : "",
+				report.frequency, report.growth_dB_per_second);
+
+			if (report.seconds_to_threshold >= 0.0f) {
+
+				snprintf(feedback_string + length, sizeof feedback_string - length, "  %.1f s to %.0f dBFS", report.seconds_to_threshold, feedback_monitor.get_threshold());
+
+			}
+
+			nvgFillColor(ctx, colour);
+
+			bool text_on_right = x_proportion < 0.6f;
+
+			render_text(ctx, feedback_string, line_x + (text_on_right ? 5 : -5), rta_outline.getY() + frequency_label_outline.getHeight() * (1.5 + candidate),
+				font_size, text_on_right ? 1 : 2, FALSE);
+
+		}
+
+	}
+
+	void render_peak_labels(NVGcontext *ctx) { //tracked in update_rta_traces
+
+		//only stable partials are labelled, so noise peaks that come and go do not flicker
+
+		int font_size = frequency_label_outline.getHeight() * 0.5;
+
+		const std::vector<SpectralPeakTrack> &tracks = rta_peaks.get_tracks();
+
+		for (int track = 0; track < tracks.size(); track++) {
+
+			if (!rta_peaks.is_stable(tracks[track])) {
+
+				continue;
+
+			}
+
+			float x_proportion = frequency_to_x_proportion(tracks[track].frequency);
+
+			if (x_proportion < 0.0f || x_proportion > 1.0f) {
+
+				continue;
+
+			}
+
+			float point_x = rta_outline.getX() + rta_outline.getWidth() * x_proportion;
+			float point_y = rta_outline.getY() + rta_outline.getHeight() * rta_dBFS_to_y_proportion(jmax((float)dBFS_lower_limit, tracks[track].level_dB));
+
+			nvgFillColor(ctx, nvgRGBA(255, 255, 255, 255));
+
+			nvgBeginPath(ctx);
+
+			nvgCircle(ctx, point_x, point_y, 3.0f);
+
+			nvgFill(ctx);
+
+			char peak_string[48];
+
+			if (tracks[track].frequency < 1000.0f) {
+
+				snprintf(peak_string, sizeof peak_string, "%.1f Hz %.1f dB", tracks[track].frequency, tracks[track].level_dB);
+
+			}
+
+			else {
+
+				snprintf(peak_string, sizeof peak_string, "%.2f kHz %.1f dB", tracks[track].frequency * 0.001f, tracks[track].level_dB);
+
+			}
+
+			render_text(ctx, peak_string, point_x, point_y - font_size * 0.8, font_size, 0, FALSE);
+
+		}
+
+	}
+
+	void render_percentile_spectra(NVGcontext *ctx) { //at the measurement grid frequencies, with the measurement time top left
+
+		const std::vector<float>& frequencies = measurement_grid.get_frequencies();
+
+		render_rta_trace(ctx, percentile_spectrum.get_levels(l90_level), frequencies, nvgRGBA(0, 110, 60, 220));
+		render_rta_trace(ctx, percentile_spectrum.get_levels(l50_level), frequencies, nvgRGBA(0, 180, 100, 220));
+		render_rta_trace(ctx, percentile_spectrum.get_levels(l10_level), frequencies, nvgRGBA(120, 255, 170, 220));
+
+		int elapsed_seconds = (int)((Time::getMillisecondCounterHiRes() - percentile_spectrum_start_ms) * 0.001);
+
+		char percentile_string[96];
+
+		snprintf(percentile_string, sizeof percentile_string, "L10 / L50 / L90 over %d:%02d:%02d (%lld frames)",
+			elapsed_seconds / 3600, (elapsed_seconds / 60) % 60, elapsed_seconds % 60, (long long)percentile_spectrum.get_num_frames());
+
+		nvgFillColor(ctx, nvgRGBA(120, 255, 170, 255));
+
+		render_text(ctx, percentile_string, rta_outline.getX() + 5, rta_outline.getY() + frequency_label_outline.getHeight() * 0.5, frequency_label_outline.getHeight() * 0.6, 1, FALSE);
+
+	}
+
+	void render_octave_band_levels(NVGcontext *ctx) { //one bar per band between its edges, behind the RTA trace
+
+		nvgFillColor(ctx, nvgRGBA(0, 150, 255, 90));
+
+		nvgBeginPath(ctx);
+
+		for (int band = 0; band < octave_band_levels.amplitudes.size(); band++) {
+
+			float left = jlimit(0.0f, 1.0f, frequency_to_x_proportion(octave_band_levels.lower_edges[band]));
+			float right = jlimit(0.0f, 1.0f, frequency_to_x_proportion(octave_band_levels.upper_edges[band]));
+			float top = jlimit(0.0f, 1.0f, rta_dBFS_to_y_proportion(fft_amp_to_dBFS(octave_band_levels.amplitudes[band])));
+
+			if (right <= left) {
+
+				continue;
+
+			}
+
+			nvgRect(ctx,
+				rta_outline.getX() + rta_outline.getWidth() * left + 1,
+				rta_outline.getY() + rta_outline.getHeight() * top,
+				jmax(1.0f, rta_outline.getWidth() * (right - left) - 2),
+				rta_outline.getHeight() * (1.0f - top));
+
+		}
+
+		nvgFill(ctx);
+
+	}
+
+	void render_loudness(NVGcontext *ctx) { //bottom right, below the RTA trace
+
+		LoudnessReadings loudness = loudness_meter.get_readings();
+
+		if (!loudness.momentary_valid) {
+
+			return;
+
+		}
+
+		char loudness_string[160];
+
+		snprintf(loudness_string, sizeof loudness_string, "M %s  S %s  I %s LUFS  LRA %s LU",
+			format_loudness(loudness.momentary, true).toRawUTF8(),
+			format_loudness(loudness.short_term, loudness.short_term_valid).toRawUTF8(),
+			format_loudness(loudness.integrated, loudness.integrated_valid).toRawUTF8(),
+			format_loudness(loudness.loudness_range, loudness.range_valid).toRawUTF8());
+
+		nvgFillColor(ctx, nvgRGBA(255, 255, 255, 255));
+
+		render_text(ctx, loudness_string, rta_outline.getTopRight().getX() - 5, rta_outline.getBottom() - frequency_label_outline.getHeight() * 0.5, frequency_label_outline.getHeight() * 0.6, 2, FALSE);
+
+	}
+
+	static String format_loudness(float value, bool valid) {
+
+		return valid && value > LoudnessMeter::no_level ? String(value, 1) : String("--");
+
+	}
+
+	void render_profiler_overlay(NVGcontext *ctx) { //mean and max time of each stage over the last second
+
+		std::vector<ProfileStageStats> stage_stats = FrameProfiler::get_instance().get_stage_stats(1.0);
+
+		int line_height = frequency_label_outline.getHeight() * 0.6;
+		int x = rta_outline.getX() + 10;
+		int y = rta_outline.getY() + line_height * 2;
+
+		nvgBeginPath(ctx);
+		nvgRect(ctx, x - 5, y - line_height, line_height * 18, line_height * (stage_stats.size() + 1) + 10);
+		nvgFillColor(ctx, nvgRGBA(0, 0, 0, 180));
+		nvgFill(ctx);
+
+		nvgFillColor(ctx, nvgRGBA(255, 255, 255, 255));
+
+		render_text(ctx, "Stage: mean / max ms (last second)", x, y, line_height, 1, FALSE);
+
+		char stage_string[128];
+
+		for (int stage = 0; stage < stage_stats.size(); stage++) {
+
+			y += line_height;
+
+			snprintf(stage_string, sizeof stage_string, "%s: %.3f / %.3f", stage_stats[stage].name.c_str(), stage_stats[stage].mean_ms, stage_stats[stage].max_ms);
+
+			render_text(ctx, stage_string, x, y, line_height, 1, FALSE);
+
+		}
+
+	}
+
+	void handle_profiler_keys() {
+
+		bool toggle_key_down = glfwGetKey(display_window, GLFW_KEY_F9) == GLFW_PRESS;
+		bool export_key_down = glfwGetKey(display_window, GLFW_KEY_F10) == GLFW_PRESS;
+
+		if (toggle_key_down && !profiler_toggle_key_down) {
+
+			show_profiler_overlay = !show_profiler_overlay;
+
+			display_needs_redraw = true;
+
+			FrameProfiler::get_instance().set_enabled(show_profiler_overlay);
+
+		}
+
+		if (export_key_down && !trace_export_key_down) {
+
+			write_profiler_trace();
+
+		}
+
+		profiler_toggle_key_down = toggle_key_down;
+		trace_export_key_down = export_key_down;
+
+	}
+
+	void update_feedback_detection() { //the Goertzel windows since the last tick, at the timer rate
+
+		if (!detect_feedback) {
+
+			return;
+
+		}
+
+		bool had_candidates = !feedback_monitor.get_reports().empty();
+
+		feedback_monitor.update(feedback_detector);
+
+		if (had_candidates || !feedback_monitor.get_reports().empty()) {
+
+			display_needs_redraw = true;
+
+		}
+
+	}
+
+	void handle_measurement_reset_key() { //F8: loudness, maximum true peak, overs and the percentile spectra start again
+
+		bool reset_key_down = glfwGetKey(display_window, GLFW_KEY_F8) == GLFW_PRESS;
+
+		if (reset_key_down && !measurement_reset_key_down) {
+
+			loudness_meter.request_reset();
+
+			level_meter_ballistics.reset_holds();
+
+			percentile_spectrum.reset();
+
+			display_needs_redraw = true;
+
+		}
+
+		measurement_reset_key_down = reset_key_down;
+
+	}
+
+	void handle_hold_reset_keys() { //F5 peak hold, F6 min hold, F7 decaying peak
+
+		const int reset_keys[3] = { GLFW_KEY_F5, GLFW_KEY_F6, GLFW_KEY_F7 };
+
+		for (int trace = 0; trace < 3; trace++) {
+
+			bool reset_key_down = glfwGetKey(display_window, reset_keys[trace]) == GLFW_PRESS;
+
+			if (reset_key_down && !hold_reset_keys_down[trace]) {
+
+				if (trace == 0) { rta_holds.reset_peak_hold(); }
+				else if (trace == 1) { rta_holds.reset_min_hold(); }
+				else { rta_holds.reset_decaying_peak(); }
+
+				display_needs_redraw = true;
+
+			}
+
+			hold_reset_keys_down[trace] = reset_key_down;
+
+		}
+
+	}
+
+	void write_profiler_trace() {
+
+		std::ostringstream trace;
+
+		FrameProfiler::get_instance().write_chrome_trace(trace, display_latency_tracker.get_trace_counter_events());
+
+		File trace_file = File::getSpecialLocation(File::userDocumentsDirectory)
+							.getChildFile("SoundView trace " + Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S") + ".json");
+
+		if (!trace_file.replaceWithText(trace.str())) {
+
+			AlertWindow::showMessageBoxAsync(AlertWindow::AlertIconType::WarningIcon, "ERROR", "Could not write " + trace_file.getFullPathName(), "OK");
+
+		}
+
+	}
+
+	void render_juce_int_rect(NVGcontext *ctx, juce::Rectangle<int> rect) {
+
+		nvgBeginPath(ctx);
+
+		nvgRect(ctx, rect.getX(), rect.getY(), rect.getWidth(), rect.getHeight());
+
+		nvgStroke(ctx);
+
+	}
+
+	float frequency_to_x_proportion(float frequency) //the frequency scale over the full band, linear in zoom mode
+	{
+
+		if (zoom_mode) {
+
+			return (frequency - frequency_label_values.front()) / (float)(frequency_label_values.back() - frequency_label_values.front());
+
+		}
+
+		float min_offset = frequency_to_scale(frequency_scale, frequency_label_values.front());
+		float max_offset = frequency_to_scale(frequency_scale, frequency_label_values.back());
+		float offset_range = max_offset - min_offset;
+
+		float freq_offset = frequency_to_scale(frequency_scale, frequency) - min_offset;
+
+		return freq_offset / offset_range;
+
+	}
+
+	float rta_dBFS_to_y_proportion(float dBFS)
+	{
+
+		float offset_range = rta_amplitude_gridlines.front() - rta_amplitude_gridlines.back();
+
+		float amplitude_offset = abs(dBFS) - rta_amplitude_gridlines.front();
+
+		return amplitude_offset / offset_range;
+
+	}
+
+	float fft_amp_to_dBFS(double amp) {
+
+		return Decibels::gainToDecibels(amp, dBFS_lower_limit);
+
+	}
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
+};
@@ -0,0 +1,43 @@
+#include "allocation_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	thread_local size_t thread_bytes_allocated = 0;
+	thread_local size_t thread_allocations = 0;
+
+	void* counted_allocation(size_t size) {
+
+		thread_bytes_allocated += size;
+		thread_allocations++;
+
+		void* allocation = std::malloc(size == 0 ? 1 : size);
+
+		if (allocation == nullptr) {
+
+			throw std::bad_alloc();
+
+		}
+
+		return allocation;
+
+	}
+}
+
+size_t AllocationCounter::get_thread_bytes_allocated() { return thread_bytes_allocated; }
+
+size_t AllocationCounter::get_thread_allocations() { return thread_allocations; }
+
+void* operator new(size_t size) { return counted_allocation(size); }
+
+void* operator new[](size_t size) { return counted_allocation(size); }
+
+void operator delete(void* allocation) noexcept { std::free(allocation); }
+
+void operator delete[](void* allocation) noexcept { std::free(allocation); }
+
+void operator delete(void* allocation, size_t) noexcept { std::free(allocation); }
+
+void operator delete[](void* allocation, size_t) noexcept { std::free(allocation); }
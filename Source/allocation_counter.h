@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+//Counts heap allocations made by the calling thread through the global operator new. The replacement operators
+//live in allocation_counter.cpp. Counting is per thread, so the audio and GUI threads do not disturb a benchmark.
+
+struct AllocationCounter
+{
+
+	static size_t get_thread_bytes_allocated();
+	static size_t get_thread_allocations();
+
+};
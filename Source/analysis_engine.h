@@ -0,0 +1,355 @@
+#pragma once
+
+#include "fft.h"
+#include "avgbuffer.h"
+#include "moving_avg.h"
+#include "spline.h"
+#include "constant_q.h"
+#include "filterbank.h"
+#include "frame_profiler.h"
+
+#include <vector>
+#include <cmath>
+
+//The DSP core shared by the display and the offline analyser: windowed FFT, magnitude, averaging, smoothing and
+//resampling onto the log spaced spectrogram frequencies. Nothing in here depends on JUCE, OpenGL or GLFW so it can
+//run headless. Write fft_size samples into get_input_samples() before each call to analyse_frame(). The spectrogram
+//frequencies are equally spaced on the chosen frequency scale. With constant-Q on, or on a mel, Bark or ERB scale
+//(through a triangular filterbank), the output bins are the spectrogram frequencies rather than the linear FFT bins.
+
+class AnalysisEngine
+{
+public:
+
+	AnalysisEngine(int fft_size, int num_spectrogram_frequencies, float lowest_frequency, float highest_frequency) :
+		fft0(fft_size),
+		spectrogram_num_frequencies(num_spectrogram_frequencies),
+		spectrogram_lowest_frequency(lowest_frequency),
+		spectrogram_highest_frequency(highest_frequency)
+	{
+
+		fft_bin_freqs.resize(fft_size / 2);
+		fft_bin_amps.resize(fft_size / 2);
+		averaged_amplitudes.resize(fft_size / 2);
+
+		generate_fft_bin_freq();
+
+		set_spectrogram_num_frequencies(num_spectrogram_frequencies);
+
+		interpolator_ref_freq.resize(fft_bin_freqs.size());
+		interpolator_ref_amp.resize(fft_bin_amps.size());
+
+		fft_output_averager.set_num_averages(1);
+		fft_output_averager.set_num_samples(fft_bin_amps.size());
+
+	};
+
+	~AnalysisEngine() {};
+
+	void set_sample_rate(double sample_rate) {
+
+		if (active_sample_rate != sample_rate) {
+
+			active_sample_rate = sample_rate;
+
+			generate_fft_bin_freq();
+
+			if (uses_spectrogram_bins()) {
+
+				configure_output_bins();
+
+			}
+
+		}
+
+	}
+
+	void set_num_averages(int num_averages) {
+
+		fft_output_averager.set_num_averages(num_averages);
+
+	}
+
+	void set_averaging_mode(AveragingMode mode) {
+
+		fft_output_averager.set_averaging_mode(mode);
+
+	}
+
+	void reset_averages() {
+
+		fft_output_averager.clear();
+
+	}
+
+	void set_spectrogram_num_frequencies(int num_frequencies) {
+
+		spectrogram_num_frequencies = num_frequencies;
+
+		spectrogram_frequencies.resize(spectrogram_num_frequencies);
+		spectrogram_amplitudes.resize(spectrogram_num_frequencies);
+
+		generate_spectrogram_frequencies();
+
+		if (uses_spectrogram_bins()) {
+
+			configure_output_bins();
+
+		}
+
+	}
+
+	void set_frequency_scale(FrequencyScale scale) {
+
+		if (frequency_scale != scale) {
+
+			frequency_scale = scale;
+
+			generate_spectrogram_frequencies();
+
+			configure_output_bins();
+
+		}
+
+	}
+
+	FrequencyScale get_frequency_scale() const { return frequency_scale; }
+
+	void set_constant_q(int bins_per_octave) { //0 = linear FFT bins
+
+		if (constant_q_bins_per_octave != bins_per_octave) {
+
+			constant_q_bins_per_octave = bins_per_octave;
+
+			configure_output_bins();
+
+		}
+
+	}
+
+	bool is_constant_q() const { return constant_q_bins_per_octave > 0; }
+
+	bool uses_spectrogram_bins() const { return is_constant_q() || frequency_scale != log_scale; }
+
+	void set_smoothing(int window_type, int window_size) {
+
+		smoothing_window_type = window_type;
+		smoothing_window_size = window_size;
+
+	}
+
+	double* get_input_samples() { return fft0.fft_input_samples; }
+
+	int get_fft_size() const { return fft0.local_fft_size; }
+
+	double get_sample_rate() const { return active_sample_rate; }
+
+	double get_dBFS_lower_limit() const { return dBFS_lower_limit; }
+
+	const std::vector<float>& get_bin_frequencies() const { return uses_spectrogram_bins() ? spectrogram_frequencies : fft_bin_freqs; }
+
+	const std::vector<float>& get_bin_amplitudes() const { return uses_spectrogram_bins() ? spectrogram_bin_amps : fft_bin_amps; } //latest frame, linear
+
+	const std::vector<float>& get_spectrogram_frequencies() const { return spectrogram_frequencies; }
+
+	void analyse_frame() {
+
+		{
+			SOUNDVIEW_PROFILE_SCOPE("window_fft");
+
+			fft0.run_fft_analysis();
+		}
+
+		if (uses_spectrogram_bins()) {
+
+			if (is_constant_q()) {
+
+				SOUNDVIEW_PROFILE_SCOPE("constant_q");
+
+				constant_q_transform.process(fft0.fftw_complex_out, spectrogram_bin_amps);
+
+			}
+
+			else {
+
+				SOUNDVIEW_PROFILE_SCOPE("filterbank");
+
+				filterbank.process(fft0.fftw_complex_out, fft_amplitude_scaling_factor, spectrogram_bin_amps);
+
+			}
+
+			SOUNDVIEW_PROFILE_SCOPE("averaging_add");
+
+			fft_output_averager.add_new_samples(spectrogram_bin_amps);
+
+			return;
+
+		}
+
+		{
+			SOUNDVIEW_PROFILE_SCOPE("magnitude");
+
+			get_fft_amplitudes(fft0.fftw_complex_out, fft_bin_amps);
+		}
+
+		SOUNDVIEW_PROFILE_SCOPE("averaging_add");
+
+		fft_output_averager.add_new_samples(fft_bin_amps);
+
+	}
+
+	std::vector<float> get_rta_amplitudes() { //averaged and smoothed, linear
+
+		{
+			SOUNDVIEW_PROFILE_SCOPE("averaging_get");
+
+			averaged_amplitudes = fft_output_averager.get_average();
+		}
+
+		SOUNDVIEW_PROFILE_SCOPE("smoothing");
+
+		return sample_smoother.process_samples(averaged_amplitudes, smoothing_window_type, smoothing_window_size);
+
+	}
+
+	const std::vector<float>& update_spectrogram_amplitudes() { //latest frame in dBFS at each spectrogram frequency
+
+		SOUNDVIEW_PROFILE_SCOPE("spectrogram_resample");
+
+		if (uses_spectrogram_bins()) { //already one bin per spectrogram frequency
+
+			for (int frequency = 0; frequency < spectrogram_num_frequencies; frequency++) {
+
+				spectrogram_amplitudes[frequency] = amp_to_dBFS(spectrogram_bin_amps[frequency]);
+
+			}
+
+			return spectrogram_amplitudes;
+
+		}
+
+		std::copy(fft_bin_freqs.begin(), fft_bin_freqs.end(), interpolator_ref_freq.begin());
+		std::copy(fft_bin_amps.begin(), fft_bin_amps.end(), interpolator_ref_amp.begin());
+
+		cubic_interpolator.set_points(interpolator_ref_freq, interpolator_ref_amp);
+
+		for (int frequency = 0; frequency < spectrogram_num_frequencies; frequency++) {
+
+			spectrogram_amplitudes[frequency] = amp_to_dBFS(cubic_interpolator(spectrogram_frequencies[frequency]));
+
+		}
+
+		return spectrogram_amplitudes;
+
+	}
+
+	float amp_to_dBFS(double amp) const {
+
+		return amp > 0.0 ? std::max(dBFS_lower_limit, 20.0 * log10(amp)) : dBFS_lower_limit;
+
+	}
+
+private:
+
+	fft fft0;
+
+	double active_sample_rate = 44100.0;
+
+	double dBFS_lower_limit = -96.0;
+
+	int fft_amplitude_scaling_factor = 4.0;
+
+	std::vector<float> fft_bin_freqs;
+	std::vector<float> fft_bin_amps;
+	std::vector<float> averaged_amplitudes;
+
+	AveragingBuffer fft_output_averager;
+	MovingAverageSmoother sample_smoother;
+
+	int smoothing_window_type{ 0 };
+	int smoothing_window_size{ 1 };
+
+	int spectrogram_num_frequencies;
+	float spectrogram_lowest_frequency, spectrogram_highest_frequency;
+
+	std::vector<float> spectrogram_frequencies, spectrogram_amplitudes;
+
+	tk::spline cubic_interpolator;
+	std::vector<double> interpolator_ref_freq, interpolator_ref_amp;
+
+	FrequencyScale frequency_scale{ log_scale };
+
+	int constant_q_bins_per_octave{ 0 };
+	ConstantQTransform constant_q_transform;
+	Filterbank filterbank;
+	std::vector<float> spectrogram_bin_amps; //latest frame at the spectrogram frequencies, when those are the output bins
+
+	void configure_output_bins() { //the averager follows whichever bins the engine outputs
+
+		if (is_constant_q()) {
+
+			constant_q_transform.build(fft0.local_fft_size, active_sample_rate, spectrogram_frequencies, constant_q_bins_per_octave);
+
+		}
+
+		else if (frequency_scale != log_scale) {
+
+			filterbank.build(frequency_scale, fft0.local_fft_size, active_sample_rate, spectrogram_frequencies);
+
+		}
+
+		spectrogram_bin_amps.assign(spectrogram_num_frequencies, 0.0f);
+
+		fft_output_averager.set_num_samples(uses_spectrogram_bins() ? spectrogram_num_frequencies : (int)fft_bin_amps.size());
+		fft_output_averager.clear();
+
+	}
+
+	void generate_fft_bin_freq() {
+
+		int fft_size_N = fft0.local_fft_size;
+
+		fft_bin_freqs[0] = 0.0;
+
+		for (int x = 1; x < fft_size_N / 2; x++) {
+
+			fft_bin_freqs[x] = x * (active_sample_rate * 1.0 / fft_size_N * 1.0);
+
+		}
+
+	}
+
+	void generate_spectrogram_frequencies() {
+
+		//frequencies equally spaced on the frequency scale between the display limits at the resolution of the
+		//spectrogram, so the spectrogram texture lines up with the frequency axis of the display
+
+		double scaled_lowest_freq = frequency_to_scale(frequency_scale, spectrogram_lowest_frequency);
+		double scaled_highest_freq = frequency_to_scale(frequency_scale, spectrogram_highest_frequency);
+
+		double scaled_freq_range = scaled_highest_freq - scaled_lowest_freq;
+
+		int num_freq = spectrogram_num_frequencies;
+
+		for (int x = 0; x < num_freq; x++) {
+
+			spectrogram_frequencies[x] = scale_to_frequency(frequency_scale, scaled_lowest_freq + (scaled_freq_range)*((x*1.0) / (num_freq - 1.0)));
+
+		}
+
+	}
+
+	void get_fft_amplitudes(std::vector<std::vector<double>> &fft_output_complex, std::vector<float> &amplitude_vector)
+	{
+
+		for (int x = 0; x < amplitude_vector.size(); x++) {
+
+			amplitude_vector[x] =	(sqrtf((pow(fft_output_complex[0][x],2)) + (pow(fft_output_complex[1][x], 2))))
+
+									* fft_amplitude_scaling_factor;
+
+		}
+
+	}
+
+};
@@ -1,214 +1,270 @@
-
-#pragma once
-
-#include "../JuceLibraryCode/JuceHeader.h"
-
-#include <deque>
-
-struct AudioPerformanceTextIndicator
-{
-
-	juce::Rectangle<int> indicator_outline;
-	juce::Rectangle<int> indicator_active_area;
-	juce::Rectangle<int> indicator_label_area;
-	juce::Rectangle<int> indicator_value_area;
-
-	String indicator_label_text{ "NO_LABEL_TEXT" };
-	String indicator_value{ "" };
-
-	void set_indicator_outline(juce::Rectangle<int> outline_rectangle) {
-
-		indicator_outline = outline_rectangle;
-
-		indicator_active_area = indicator_outline.reduced(2);
-		indicator_label_area = indicator_active_area.removeFromLeft(indicator_active_area.getWidth()*0.75);
-		indicator_value_area = indicator_active_area;
-
-	}
-
-	void draw_indicator(Graphics& context) {
-
-		context.saveState();
-
-		context.setColour(Colours::white);
-
-		context.setFont(indicator_label_area.getHeight()*0.75);
-
-		context.drawText(indicator_label_text, indicator_label_area, Justification::centred, false);
-		context.drawText(String(indicator_value), indicator_value_area, Justification::centred, false);
-
-		context.restoreState();
-
-	}
-	
-};
-
-class AudioPerformanceComponent: public Component
-{
-public:
-	
-	AudioPerformanceComponent() {
-	
-		indicator_1.indicator_label_text = "Zeroed Samples";
-		indicator_2.indicator_label_text = "Clipped Samples";
-		indicator_3.indicator_label_text = "Invalid Samples";
-		indicator_4.indicator_label_text = "Audio Callback Time (ms)";
-		indicator_5.indicator_label_text = "Total Audio Over/Underruns";
-	
-	};
-	
-	~AudioPerformanceComponent() {};
-
-	void paint(Graphics& g) override
-	{
-
-		g.setColour(Colours::white);
-
-		indicator_1.indicator_value = String(ape_analysis_results[0]);
-		indicator_1.draw_indicator(g);
-		
-		indicator_2.indicator_value = String(ape_analysis_results[1]);
-		indicator_2.draw_indicator(g);
-		
-		indicator_3.indicator_value = String(ape_analysis_results[2]);
-		indicator_3.draw_indicator(g);
-
-		indicator_4.indicator_value = String(indicated_audio_callback_time);
-		indicator_4.draw_indicator(g);
-
-		indicator_5.indicator_value = String(indicated_xruns);
-		indicator_5.draw_indicator(g);
-
-	}
-
-	void resized() override
-	{
-
-		component_outline = getLocalBounds();
-		int component_height = component_outline.getHeight();
-
-		component_outline.removeFromTop(component_height*0.05);
-		
-		indicator_1.set_indicator_outline(component_outline.removeFromTop(component_height*0.18));
-		indicator_2.set_indicator_outline(component_outline.removeFromTop(component_height*0.18));
-		indicator_3.set_indicator_outline(component_outline.removeFromTop(component_height*0.18));
-		indicator_4.set_indicator_outline(component_outline.removeFromTop(component_height*0.18));
-		indicator_5.set_indicator_outline(component_outline.removeFromTop(component_height*0.18));
-
-		component_outline.removeFromTop(component_height*0.05);
-
-	}
-
-	void set_ape_analysis_results(std::vector<int> analysis_results) {
-
-		assert(analysis_results.size() == 3);
-
-		ape_analysis_results = analysis_results;
-
-	}
-
-	void set_indicated_callback_time(float callback_time) {
-
-		indicated_audio_callback_time = callback_time;
-
-	}
-
-	void set_indicated_xruns(int xruns) {
-
-		indicated_xruns = xruns;
-
-	}
-		
-private:
-
-	std::vector<int> ape_analysis_results{0,0,0};
-	float indicated_audio_callback_time{ 0.0 };
-	int indicated_xruns{ 0 };
-
-	juce::Rectangle<int> component_outline;
-	AudioPerformanceTextIndicator indicator_1;
-	AudioPerformanceTextIndicator indicator_2;
-	AudioPerformanceTextIndicator indicator_3;
-	AudioPerformanceTextIndicator indicator_4;
-	AudioPerformanceTextIndicator indicator_5;
-
-};
-
-class AudioPeformanceEngine
-{
-public:
-
-	AudioPeformanceEngine(int num_periods) {
-	
-		num_sampling_periods = num_periods;
-		zeroed_samples.resize(num_sampling_periods);
-		clipped_samples.resize(num_sampling_periods);
-		invalid_samples.resize(num_sampling_periods);
-	
-	};
-
-	~AudioPeformanceEngine() {};
-
-	std::vector<int> analyse_samples(std::vector<float> &input_samples) {
-
-		std::vector<int> sample_analysis_results;
-		sample_analysis_results.resize(3);
-
-		//sample_analysis_results[0] indicates sum of zeroed samples over all sampling periods 
-		//sample_analysis_results[1] indicates sum of clipped samples over all sampling periods
-		//sample_analysis_results[2] indicates sum of invalid samples over all sampling periods
-
-		check_samples(input_samples);
-
-		sample_analysis_results[0] = std::accumulate(zeroed_samples.begin(), zeroed_samples.end(), 0);
-		sample_analysis_results[1] = std::accumulate(clipped_samples.begin(), clipped_samples.end(), 0);
-		sample_analysis_results[2] = std::accumulate(invalid_samples.begin(), invalid_samples.end(), 0);
-
-		return sample_analysis_results;
-				
-	}
-
-private:
-
-	std::deque<int> zeroed_samples, clipped_samples, invalid_samples; //sum of all sampling periods;
-
-	int num_sampling_periods;
-
-	void check_samples(std::vector<float> samples) {
-
-		int sum_zeroed_samples{ 0 }, sum_clipped_samples{ 0 }, sum_invalid_samples{ 0 };
-
-		for (int x = 0; x < samples.size(); x++) {
-			
-			if (samples[x] == 0.0) {
-
-				sum_zeroed_samples++;
-
-			}
-
-			if (samples[x] == -1.0 || samples[x] == 1.0) {
-
-				sum_clipped_samples++;
-
-			}
-
-			if (samples[x] < -1.0 || samples[x] > 1.0) {
-
-				sum_invalid_samples++;
-
-			}
-
-		}
-
-		zeroed_samples.push_front(sum_zeroed_samples);
-		while (zeroed_samples.size() > num_sampling_periods) { zeroed_samples.pop_back(); }
-
-		clipped_samples.push_front(sum_clipped_samples);
-		while (clipped_samples.size() > num_sampling_periods) { clipped_samples.pop_back(); }
-
-		invalid_samples.push_front(sum_invalid_samples);
-		while (invalid_samples.size() > num_sampling_periods) { invalid_samples.pop_back(); }
-		
-	}
-
-};
\ No newline at end of file
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#include "sample_health.h"
+#include "latency_histogram.h"
+#include "display_latency.h"
+#include "spl_meter.h"
+#include "level_meter.h"
+
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <limits>
+#include <cmath>
+
+struct AudioPerformanceTextIndicator
+{
+
+	juce::Rectangle<int> indicator_outline;
+	juce::Rectangle<int> indicator_active_area;
+	juce::Rectangle<int> indicator_label_area;
+	juce::Rectangle<int> indicator_value_area;
+
+	String indicator_label_text{ "NO_LABEL_TEXT" };
+	String indicator_value{ "" };
+
+	void set_indicator_outline(juce::Rectangle<int> outline_rectangle) {
+
+		indicator_outline = outline_rectangle;
+
+		indicator_active_area = indicator_outline.reduced(2);
+		indicator_label_area = indicator_active_area.removeFromLeft(indicator_active_area.getWidth()*0.65);
+		indicator_value_area = indicator_active_area;
+
+	}
+
+	void draw_indicator(Graphics& context) {
+
+		context.saveState();
+
+		context.setColour(Colours::white);
+
+		context.setFont(indicator_label_area.getHeight()*0.75);
+
+		context.drawText(indicator_label_text, indicator_label_area, Justification::centred, false);
+		context.drawText(String(indicator_value), indicator_value_area, Justification::centred, false);
+
+		context.restoreState();
+
+	}
+	
+};
+
+class AudioPerformanceComponent: public Component
+{
+public:
+
+	enum IndicatorRow { zeroed_row = 0, overs_row, out_of_range_row, non_finite_row, peak_row, peak_hold_row, rms_row, true_peak_row,
+						spl_level_row, spl_leq_row, spl_range_row, callback_median_row, callback_tail_row, callback_load_row, jitter_row,
+						xruns_row, display_latency_row, display_latency_breakdown_row, num_indicator_rows };
+	
+	AudioPerformanceComponent() {
+
+		indicators.resize(num_indicator_rows);
+	
+		indicators[zeroed_row].indicator_label_text = "Zeroed Samples";
+		indicators[overs_row].indicator_label_text = "Overs Sample / True Peak";
+		indicators[out_of_range_row].indicator_label_text = "Out of Range Samples";
+		indicators[non_finite_row].indicator_label_text = "NaN/Inf Samples";
+		indicators[peak_row].indicator_label_text = "Peak Input 1 / 2 (dBFS)";
+		indicators[peak_hold_row].indicator_label_text = "Peak Hold Input 1 / 2 (dBFS)";
+		indicators[rms_row].indicator_label_text = "RMS Input 1 / 2 (dBFS)";
+		indicators[true_peak_row].indicator_label_text = "Max True Peak Input 1 / 2 (dBTP)";
+		indicators[callback_median_row].indicator_label_text = "Callback Time p50 / p99 (ms)";
+		indicators[callback_tail_row].indicator_label_text = "Callback Time p99.9 / max (ms)";
+		indicators[callback_load_row].indicator_label_text = "Callback p99.9 / max (% of buffer)";
+		indicators[jitter_row].indicator_label_text = "Callback Jitter p99 / max (ms)";
+		indicators[xruns_row].indicator_label_text = "Total Audio Over/Underruns";
+		indicators[display_latency_row].indicator_label_text = "Input to Display p50 / p99 (ms)";
+		indicators[display_latency_breakdown_row].indicator_label_text = "Ring Wait / Analysis / Render p50 (ms)";
+
+		update_spl_indicators(); //the SPL labels name the current weightings
+	
+	};
+	
+	~AudioPerformanceComponent() {};
+
+	void paint(Graphics& g) override
+	{
+
+		g.setColour(Colours::white);
+
+		for (int x = 0; x < indicators.size(); x++) {
+
+			indicators[x].draw_indicator(g);
+
+		}
+
+	}
+
+	void repaint_if_changed() { //formats the latest values and repaints only if any displayed text differs
+
+		std::vector<String> previous_values(indicators.size()), previous_labels(indicators.size());
+
+		for (int x = 0; x < indicators.size(); x++) {
+
+			previous_values[x] = indicators[x].indicator_value;
+			previous_labels[x] = indicators[x].indicator_label_text;
+
+		}
+
+		update_indicator_values();
+
+		for (int x = 0; x < indicators.size(); x++) {
+
+			if (indicators[x].indicator_value != previous_values[x] || indicators[x].indicator_label_text != previous_labels[x]) {
+
+				repaint();
+
+				return;
+
+			}
+
+		}
+
+	}
+
+	void resized() override
+	{
+
+		component_outline = getLocalBounds();
+		int component_height = component_outline.getHeight();
+
+		component_outline.removeFromTop(component_height*0.05);
+
+		for (int x = 0; x < indicators.size(); x++) {
+
+			indicators[x].set_indicator_outline(component_outline.removeFromTop(component_height * (0.9 / indicators.size())));
+
+		}
+
+		component_outline.removeFromTop(component_height*0.05);
+
+	}
+
+	void set_ape_analysis_results(SampleHealthCounts analysis_results) {
+
+		ape_analysis_results = analysis_results;
+
+	}
+
+	void set_callback_timing(CallbackTimingSummary timing_summary) {
+
+		callback_timing = timing_summary;
+
+	}
+
+	void set_display_latency(DisplayLatencySummary latency_summary) {
+
+		display_latency = latency_summary;
+
+	}
+
+	void set_indicated_xruns(int xruns) {
+
+		indicated_xruns = xruns;
+
+	}
+
+	void set_spl_readings(SPLReadings readings) {
+
+		spl_readings = readings;
+
+	}
+
+	void set_level_readings(LevelReadings readings) {
+
+		level_readings = readings;
+
+	}
+		
+private:
+
+	SampleHealthCounts ape_analysis_results;
+	CallbackTimingSummary callback_timing;
+	DisplayLatencySummary display_latency;
+	int indicated_xruns{ 0 };
+	SPLReadings spl_readings;
+	LevelReadings level_readings;
+
+	juce::Rectangle<int> component_outline;
+	std::vector<AudioPerformanceTextIndicator> indicators;
+
+	void update_indicator_values() {
+
+		indicators[zeroed_row].indicator_value = String(ape_analysis_results.zeroed);
+		indicators[out_of_range_row].indicator_value = String(ape_analysis_results.out_of_range);
+		indicators[non_finite_row].indicator_value = String(ape_analysis_results.non_finite);
+
+		update_level_indicators();
+
+		update_spl_indicators();
+
+		indicators[callback_median_row].indicator_value = format_pair(callback_timing.duration_p50 * 1000.0, callback_timing.duration_p99 * 1000.0, 3);
+		indicators[callback_tail_row].indicator_value = format_pair(callback_timing.duration_p999 * 1000.0, callback_timing.duration_max * 1000.0, 3);
+		indicators[callback_load_row].indicator_value = format_pair(callback_timing.get_percent_of_period(callback_timing.duration_p999),
+																	callback_timing.get_percent_of_period(callback_timing.duration_max), 1);
+		indicators[jitter_row].indicator_value = format_pair(callback_timing.jitter_p99 * 1000.0, callback_timing.jitter_max * 1000.0, 3);
+
+		indicators[xruns_row].indicator_value = String(indicated_xruns);
+
+		indicators[display_latency_row].indicator_value = format_pair(display_latency.total_p50 * 1000.0, display_latency.total_p99 * 1000.0, 1);
+		indicators[display_latency_breakdown_row].indicator_value = String(display_latency.ring_wait_p50 * 1000.0, 1) + " / " +
+																	format_pair(display_latency.analysis_p50 * 1000.0, display_latency.render_p50 * 1000.0, 1);
+
+	}
+
+	void update_level_indicators() { //overs of input 1 since the last F8, the levels of both inputs
+
+		indicators[overs_row].indicator_value = String(level_readings.sample_overs[0]) + " / " + String(level_readings.true_peak_overs[0]);
+
+		indicators[peak_row].indicator_value = format_level_pair(level_readings.peak);
+		indicators[peak_hold_row].indicator_value = format_level_pair(level_readings.peak_hold);
+		indicators[rms_row].indicator_value = format_level_pair(level_readings.rms);
+		indicators[true_peak_row].indicator_value = format_level_pair(level_readings.max_true_peak);
+
+	}
+
+	String format_level_pair(const float* levels) const {
+
+		return format_level(levels[0], level_readings.num_channels > 0) + " / " + format_level(levels[1], level_readings.num_channels > 1);
+
+	}
+
+	void update_spl_indicators() { //both channels' current level, then input 1 over the last interval
+
+		String weighting = spl_readings.frequency_weighting == a_weighting ? "A" : (spl_readings.frequency_weighting == c_weighting ? "C" : "Z");
+		String time_weighted = "L" + weighting + (spl_readings.time_weighting == fast_time_weighting ? "F" : "S");
+		String interval = String(spl_readings.interval_seconds, spl_readings.interval_seconds < 1.0 ? 1 : 0) + " s";
+
+		indicators[spl_level_row].indicator_label_text = time_weighted + " Input 1 / 2 (dB)";
+		indicators[spl_leq_row].indicator_label_text = "L" + weighting + "eq / L" + weighting + "peak " + interval + " (dB)";
+		indicators[spl_range_row].indicator_label_text = time_weighted + "max / " + time_weighted + "min " + interval + " (dB)";
+
+		indicators[spl_level_row].indicator_value = format_level(spl_readings.level[0], spl_readings.num_channels > 0) + " / " +
+													format_level(spl_readings.level[1], spl_readings.num_channels > 1);
+
+		indicators[spl_leq_row].indicator_value =	format_level(spl_readings.leq[0], spl_readings.interval_valid) + " / " +
+													format_level(spl_readings.lpeak[0], spl_readings.interval_valid);
+
+		indicators[spl_range_row].indicator_value = format_level(spl_readings.lmax[0], spl_readings.interval_valid) + " / " +
+													format_level(spl_readings.lmin[0], spl_readings.interval_valid);
+
+	}
+
+	static String format_level(float level, bool valid) {
+
+		return valid && level > SPLMeter::silence_dB ? String(level, 1) : String("--");
+
+	}
+
+	static String format_pair(double first, double second, int decimal_places) {
+
+		return String(first, decimal_places) + " / " + String(second, decimal_places);
+
+	}
+
+};
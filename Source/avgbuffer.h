@@ -1,68 +1,324 @@
-
-#pragma once
-#include <vector>
-#include <deque>
-#include <numeric>
-
-class AveragingBuffer
-{
-public:
-
-	AveragingBuffer() {};
-
-	~AveragingBuffer() {};
-
-	void set_num_averages(int num_averages) {
-
-		averages = num_averages;
-		
-	}
-
-	void set_num_samples(int num_samples) {
-
-		samples = num_samples;
-		averaging_buffer.resize(samples);
-
-	}
-	
-	void add_new_samples(std::vector<float> &input_samples) {
-
-		for (int x = 0; x < averaging_buffer.size(); x++) {
-
-			averaging_buffer[x].push_front(input_samples[x]);
-
-			while (averaging_buffer[x].size() > averages) {
-
-				averaging_buffer[x].pop_back();
-
-			}
-
-		}
-
-	}
-
-	std::vector<float> get_average() {
-
-		std::vector<float> output_buffer;
-
-		output_buffer.resize(samples);
-
-		for (int x = 0; x < output_buffer.size(); x++) {
-
-			output_buffer[x] = std::accumulate(averaging_buffer[x].begin(), averaging_buffer[x].end(), 0.0) / (averages*1.0);
-
-		}
-
-		return output_buffer;
-
-	}
-
-private:
-
-	std::vector<std::deque<float>> averaging_buffer;
-
-	int averages; //number of averages
-
-	int samples; //number of samples
-
-};
\ No newline at end of file
+#pragma once
+#include <vector>
+#include <deque>
+#include <numeric>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define SOUNDVIEW_AVERAGING_SSE 1
+#endif
+
+//Mean averaging keeps each bin's history in a deque. The median and trimmed mean (the mean of the middle half) modes
+//are robust to impulsive noise such as door slams and coughs. They keep the last N frames in a ring of rows, plus a
+//sorted array of those N values for every bin, all in one contiguous block. Each new frame replaces the oldest value
+//in every sorted array: one vectorised pass finds where the old value is and where the new one goes, then a
+//memmove closes the gap. Changing the mode or the number of averages starts the window again. Every mode averages
+//the frames it actually holds, so while a window fills the level is right rather than fading in from silence.
+
+enum AveragingMode { mean_averaging = 0, median_averaging, trimmed_mean_averaging, num_averaging_modes };
+
+class AveragingBuffer
+{
+public:
+
+	AveragingBuffer() {};
+
+	~AveragingBuffer() {};
+
+	void set_num_averages(int num_averages) {
+
+		averages = num_averages;
+
+		reset_order_statistics();
+
+	}
+
+	void set_num_samples(int num_samples) {
+
+		samples = num_samples;
+		averaging_buffer.resize(samples);
+
+		reset_order_statistics();
+
+	}
+
+	void set_averaging_mode(AveragingMode averaging_mode) {
+
+		if (averaging_mode != mode) {
+
+			mode = averaging_mode;
+
+			clear();
+
+		}
+
+	}
+
+	AveragingMode get_averaging_mode() const { return mode; }
+
+	void clear() {
+
+		for (int x = 0; x < averaging_buffer.size(); x++) {
+
+			averaging_buffer[x].clear();
+
+		}
+
+		reset_order_statistics();
+
+	}
+
+	void add_new_samples(std::vector<float> &input_samples) {
+
+		if (mode != mean_averaging) {
+
+			add_to_order_statistics(input_samples);
+
+			return;
+
+		}
+
+		for (int x = 0; x < averaging_buffer.size(); x++) {
+
+			averaging_buffer[x].push_front(input_samples[x]);
+
+			while (averaging_buffer[x].size() > averages) {
+
+				averaging_buffer[x].pop_back();
+
+			}
+
+		}
+
+	}
+
+	std::vector<float> get_average() {
+
+		std::vector<float> output_buffer;
+
+		output_buffer.resize(samples);
+
+		if (mode != mean_averaging) {
+
+			get_order_statistic(output_buffer);
+
+			return output_buffer;
+
+		}
+
+		for (int x = 0; x < output_buffer.size(); x++) { //over the frames held, like the median and trimmed mean while the window fills
+
+			size_t count = std::min(averaging_buffer[x].size(), (size_t)std::max(1, averages));
+
+			output_buffer[x] = count == 0 ? 0.0f : (float)(std::accumulate(averaging_buffer[x].begin(), averaging_buffer[x].begin() + count, 0.0) / count);
+
+		}
+
+		return output_buffer;
+
+	}
+
+private:
+
+	std::vector<std::deque<float>> averaging_buffer;
+
+	int averages; //number of averages
+
+	int samples; //number of samples
+
+	AveragingMode mode{ mean_averaging };
+
+	//median and trimmed mean
+
+	int window_size{ 0 }; //frames, the number of averages when the window was started
+	int frames_in_window{ 0 };
+	int next_row{ 0 };
+
+	std::vector<float> window_rows; //[row * samples + bin], the last window_size frames
+	std::vector<float> sorted_values; //[bin * window_size + rank]
+
+	void reset_order_statistics() {
+
+		window_size = 0;
+		frames_in_window = 0;
+		next_row = 0;
+
+	}
+
+	void add_to_order_statistics(const std::vector<float> &input_samples) {
+
+		if (window_size == 0) { //allocates when the window starts, not per frame
+
+			window_size = std::max(1, averages);
+
+			window_rows.assign((size_t)window_size * samples, 0.0f);
+			sorted_values.assign((size_t)samples * window_size, 0.0f);
+
+		}
+
+		bool window_full = frames_in_window == window_size;
+
+		float* row = window_rows.data() + (size_t)next_row * samples;
+
+		for (int x = 0; x < samples; x++) {
+
+			float value = std::max(0.0f, input_samples[x]); //a NaN would break the ordering, it becomes 0
+
+			float* sorted = sorted_values.data() + (size_t)x * window_size;
+
+			if (window_full) {
+
+				replace_value(sorted, window_size, row[x], value);
+
+			}
+			else {
+
+				insert_value(sorted, frames_in_window, value);
+
+			}
+
+			row[x] = value;
+
+		}
+
+		next_row = (next_row + 1) % window_size;
+
+		if (!window_full) {
+
+			frames_in_window++;
+
+		}
+
+	}
+
+	void get_order_statistic(std::vector<float> &output_buffer) const {
+
+		int count = frames_in_window;
+
+		if (count == 0) {
+
+			std::fill(output_buffer.begin(), output_buffer.end(), 0.0f);
+
+			return;
+
+		}
+
+		int trim = count / 4; //the trimmed mean drops the lowest and highest quarter
+
+		for (int x = 0; x < samples; x++) {
+
+			const float* sorted = sorted_values.data() + (size_t)x * window_size;
+
+			if (mode == median_averaging) {
+
+				output_buffer[x] = count % 2 == 1 ? sorted[count / 2] : 0.5f * (sorted[count / 2 - 1] + sorted[count / 2]);
+
+			}
+			else {
+
+				output_buffer[x] = std::accumulate(sorted + trim, sorted + count - trim, 0.0f) / (count - 2 * trim);
+
+			}
+
+		}
+
+	}
+
+	static void insert_value(float* sorted, int count, float value) {
+
+		int position = count_below(sorted, count, value);
+
+		memmove(sorted + position + 1, sorted + position, (count - position) * sizeof(float));
+
+		sorted[position] = value;
+
+	}
+
+	static void replace_value(float* sorted, int count, float old_value, float new_value) {
+
+		int old_position, new_position;
+
+		count_below(sorted, count, old_value, new_value, old_position, new_position);
+
+		if (new_position > old_position) { //old_value is one of the values below new_value
+
+			memmove(sorted + old_position, sorted + old_position + 1, (new_position - 1 - old_position) * sizeof(float));
+
+			sorted[new_position - 1] = new_value;
+
+		}
+		else {
+
+			memmove(sorted + new_position + 1, sorted + new_position, (old_position - new_position) * sizeof(float));
+
+			sorted[new_position] = new_value;
+
+		}
+
+	}
+
+	static int count_below(const float* sorted, int count, float value) {
+
+		int below, unused;
+
+		count_below(sorted, count, value, value, below, unused);
+
+		return below;
+
+	}
+
+	static void count_below(const float* sorted, int count, float first_value, float second_value, int &first_below, int &second_below) {
+
+		//a count rather than a search, so there are no unpredictable branches
+
+		first_below = 0;
+		second_below = 0;
+
+		int x = 0;
+
+#ifdef SOUNDVIEW_AVERAGING_SSE
+
+		const __m128 first_lanes = _mm_set1_ps(first_value);
+		const __m128 second_lanes = _mm_set1_ps(second_value);
+
+		__m128i first_counts = _mm_setzero_si128(), second_counts = _mm_setzero_si128();
+
+		for (; x + 4 <= count; x += 4) {
+
+			__m128 values = _mm_loadu_ps(sorted + x);
+
+			first_counts = _mm_sub_epi32(first_counts, _mm_castps_si128(_mm_cmplt_ps(values, first_lanes)));
+			second_counts = _mm_sub_epi32(second_counts, _mm_castps_si128(_mm_cmplt_ps(values, second_lanes)));
+
+		}
+
+		first_below = sum_lanes(first_counts);
+		second_below = sum_lanes(second_counts);
+
+#endif
+
+		for (; x < count; x++) {
+
+			first_below += sorted[x] < first_value;
+			second_below += sorted[x] < second_value;
+
+		}
+
+	}
+
+#ifdef SOUNDVIEW_AVERAGING_SSE
+
+	static int sum_lanes(__m128i lanes) {
+
+		lanes = _mm_add_epi32(lanes, _mm_shuffle_epi32(lanes, _MM_SHUFFLE(1, 0, 3, 2)));
+		lanes = _mm_add_epi32(lanes, _mm_shuffle_epi32(lanes, _MM_SHUFFLE(2, 3, 0, 1)));
+
+		return _mm_cvtsi128_si32(lanes);
+
+	}
+
+#endif
+
+};
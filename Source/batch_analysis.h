@@ -0,0 +1,541 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include "offline_analysis.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <iostream>
+
+//Parallel version of OfflineAnalyser for long recordings and sets of files. Each file is split into chunks of whole
+//analysis frames. Consecutive chunks overlap by fft_size - hop_size samples, so every frame is exactly the frame a
+//sequential run would produce. Each chunk also re-analyses num_averages - 1 frames before its first frame, so the
+//averager holds the same history it would have had sequentially. Each worker thread owns its own reader and
+//AnalysisEngine (and therefore its own FFTW plan). It formats its rows into memory, and the finished chunks are
+//appended to the output file in order by whichever worker finds the next one ready, outside the scheduler lock, so
+//the other workers never wait for file I/O. Only a bounded number of chunks may be waiting to be written, so memory
+//does not grow with the length of the recording. Loudness gating needs the whole programme in order, so with
+//--loudness one more thread streams the file through a LoudnessMeter while the workers analyse it.
+
+class BatchAnalyser : public OfflineAnalyser
+{
+public:
+
+	BatchAnalyser(OfflineAnalysisSettings analysis_settings, int threads, int frames_per_chunk) :
+		OfflineAnalyser(analysis_settings),
+		num_threads(jmax(1, threads)),
+		chunk_frames(jmax(1, frames_per_chunk))
+	{
+	};
+
+	~BatchAnalyser() {};
+
+	OfflineAnalysisReport analyse_file(const File &input_file, const File &output_file) {
+
+		settings.input_file = input_file;
+		settings.output_file = output_file;
+
+		return analyse_file_in_parallel(num_threads, true);
+
+	}
+
+	//Runs the current input file with 1, 2, 4 ... threads up to the maximum, without writing output, and prints
+	//the speed up and parallel efficiency of each run relative to a single thread. Returns false if any run falls
+	//below min_parallel_efficiency, or failed.
+
+	bool print_scaling_report(const File &input_file) {
+
+		settings.input_file = input_file;
+
+		std::cout << "threads, wall_s, audio_s_per_wall_s, speedup, efficiency, check" << std::endl;
+
+		std::vector<int> thread_counts;
+
+		for (int threads = 1; threads < num_threads; threads *= 2) {
+
+			thread_counts.push_back(threads);
+
+		}
+
+		thread_counts.push_back(num_threads);
+
+		double single_thread_seconds = 0.0;
+		double lowest_efficiency = 1.0;
+		int lowest_efficiency_threads = 1;
+
+		for (int x = 0; x < thread_counts.size(); x++) {
+
+			int threads = thread_counts[x];
+
+			OfflineAnalysisReport report = analyse_file_in_parallel(threads, false);
+
+			if (!report.success) {
+
+				std::cerr << report.error_message << std::endl;
+
+				return false;
+
+			}
+
+			if (threads == 1) {
+
+				single_thread_seconds = report.wall_seconds;
+
+			}
+
+			double speedup = single_thread_seconds / report.wall_seconds;
+			double efficiency = speedup / threads;
+
+			if (efficiency < lowest_efficiency) {
+
+				lowest_efficiency = efficiency;
+				lowest_efficiency_threads = threads;
+
+			}
+
+			std::cout	<< threads << ", " << report.wall_seconds << ", " << report.get_realtime_factor() << ", "
+						<< speedup << ", " << efficiency << ", " << (efficiency >= min_parallel_efficiency ? "ok" : "LOW") << std::endl;
+
+		}
+
+		bool scaling_ok = lowest_efficiency >= min_parallel_efficiency;
+
+		std::cout	<< "Parallel efficiency " << (scaling_ok ? "at or above " : "below ") << min_parallel_efficiency * 100.0
+					<< "% (lowest " << lowest_efficiency * 100.0 << "% at " << lowest_efficiency_threads << " threads)" << std::endl;
+
+		return scaling_ok;
+
+	}
+
+	static int run_from_command_line(const StringArray &arguments) { //returns the process exit code
+
+		OfflineAnalysisSettings settings;
+		String error_message;
+
+		parse_analysis_options(arguments, settings);
+
+		if (!validate_analysis_options(settings, error_message)) {
+
+			std::cerr << error_message << std::endl;
+
+			return 1;
+
+		}
+
+		Array<File> input_files;
+		File output_directory;
+		int threads = (int)std::thread::hardware_concurrency();
+		int frames_per_chunk = 64;
+		bool scaling_report = false;
+
+		for (int x = 0; x < arguments.size(); x++) {
+
+			String value = arguments[x + 1].unquoted();
+
+			if (arguments[x] == "--threads") { threads = value.getIntValue(); x++; }
+			else if (arguments[x] == "--chunk-frames") { frames_per_chunk = value.getIntValue(); x++; }
+			else if (arguments[x] == "--output-dir") { output_directory = File::getCurrentWorkingDirectory().getChildFile(value); x++; }
+			else if (arguments[x] == "--scaling-report") { scaling_report = true; }
+			else if (arguments[x] == "--batch") {
+
+				while (x + 1 < arguments.size() && !arguments[x + 1].startsWith("--")) { //every file or folder up to the next option
+
+					add_input_files(File::getCurrentWorkingDirectory().getChildFile(arguments[++x].unquoted()), input_files);
+
+				}
+
+			}
+
+		}
+
+		if (input_files.isEmpty()) {
+
+			std::cerr << "No input files given" << std::endl << get_usage() << std::endl;
+
+			return 1;
+
+		}
+
+		BatchAnalyser batch_analyser(settings, threads, frames_per_chunk);
+
+		if (scaling_report) {
+
+			return batch_analyser.print_scaling_report(input_files[0]) ? 0 : 1;
+
+		}
+
+		OfflineAnalysisReport total;
+		total.success = true;
+
+		for (int x = 0; x < input_files.size(); x++) {
+
+			File output_file = input_files[x].withFileExtension(settings.binary_output ? "sva" : "csv");
+
+			if (output_directory != File()) {
+
+				output_directory.createDirectory();
+
+				output_file = output_directory.getChildFile(output_file.getFileName());
+
+			}
+
+			OfflineAnalysisReport report = batch_analyser.analyse_file(input_files[x], output_file);
+
+			if (!report.success) {
+
+				std::cerr << report.error_message << std::endl;
+
+				total.success = false;
+
+				continue;
+
+			}
+
+			std::cout << input_files[x].getFileName() << ": ";
+
+			print_report(report);
+
+			total.audio_seconds += report.audio_seconds;
+			total.wall_seconds += report.wall_seconds;
+			total.frames_written += report.frames_written;
+
+		}
+
+		std::cout << "Total: ";
+
+		print_report(total);
+
+		return total.success ? 0 : 1;
+
+	}
+
+	static String get_usage() {
+
+		return	"Usage: SoundView --batch <audio files or folders...> [--output-dir <dir>] [--threads N] [--chunk-frames 64] [--scaling-report]\n"
+				"                 [analysis options as for --analyse]";
+
+	}
+
+private:
+
+	static void add_input_files(const File &file, Array<File> &input_files) { //a folder adds the audio files directly in it, by name
+
+		if (!file.isDirectory()) {
+
+			input_files.add(file);
+
+			return;
+
+		}
+
+		AudioFormatManager format_manager;
+		format_manager.registerBasicFormats();
+
+		Array<File> folder_files;
+
+		file.findChildFiles(folder_files, File::findFiles, false, format_manager.getWildcardForAllFormats());
+
+		folder_files.sort();
+
+		input_files.addArray(folder_files);
+
+	}
+
+	const double min_parallel_efficiency = 0.8; //speedup / threads, on physical cores
+
+	int num_threads;
+	int chunk_frames;
+
+	struct ChunkScheduler
+	{
+
+		std::mutex mtx;
+		std::condition_variable chunk_written;
+
+		int64 num_chunks{ 0 };
+		int64 next_chunk{ 0 }; //next chunk to hand to a worker
+		int64 next_chunk_to_write{ 0 };
+		int64 rows_written{ 0 };
+		int max_chunks_in_flight{ 1 };
+		bool writing{ false }; //a worker is appending chunks to the file
+
+		std::map<int64, std::unique_ptr<MemoryBlock>> finished_chunks; //formatted rows waiting for earlier chunks
+
+		bool failed{ false };
+		String error_message;
+
+	};
+
+	OfflineAnalysisReport analyse_file_in_parallel(int threads, bool write_output) {
+
+		OfflineAnalysisReport report;
+
+		auto start = std::chrono::steady_clock::now();
+
+		AudioFormatManager format_manager;
+		format_manager.registerBasicFormats();
+
+		std::unique_ptr<AudioFormatReader> reader(format_manager.createReaderFor(settings.input_file));
+
+		if (!check_reader(reader.get(), report)) {
+
+			return report;
+
+		}
+
+		double sample_rate = reader->sampleRate;
+		int64 total_frames = count_frames(reader->lengthInSamples);
+
+		std::unique_ptr<AnalysisOutputWriter> writer;
+
+		AnalysisEngine header_engine{ settings.fft_size, settings.spectrogram_num_frequencies, settings.lowest_frequency, settings.highest_frequency };
+
+		configure_engine(header_engine, sample_rate);
+
+		if (write_output) {
+
+			writer.reset(new AnalysisOutputWriter(settings.output_file, settings.binary_output));
+
+			if (!writer->opened_ok()) {
+
+				report.error_message = "Could not write " + settings.output_file.getFullPathName();
+
+				return report;
+
+			}
+
+			write_header(*writer, header_engine);
+
+		}
+
+		int num_columns = settings.spectrogram_rows ? settings.spectrogram_num_frequencies : (settings.fft_size / 2) - 1;
+
+		ChunkScheduler scheduler;
+		scheduler.num_chunks = (total_frames + chunk_frames - 1) / chunk_frames;
+		scheduler.max_chunks_in_flight = threads * 2;
+
+		std::vector<std::thread> workers;
+
+		std::unique_ptr<LoudnessMeter> loudness_meter;
+
+		if (write_output && settings.measure_loudness) {
+
+			loudness_meter.reset(new LoudnessMeter((int)reader->numChannels));
+
+			configure_loudness_meter(*loudness_meter, *reader);
+
+			workers.push_back(std::thread(&BatchAnalyser::run_loudness, this, std::ref(scheduler), loudness_meter.get()));
+
+		}
+
+		for (int x = 0; x < threads; x++) {
+
+			workers.push_back(std::thread(&BatchAnalyser::run_worker, this, std::ref(scheduler), writer.get(), sample_rate, total_frames, num_columns));
+
+		}
+
+		for (int x = 0; x < workers.size(); x++) {
+
+			workers[x].join();
+
+		}
+
+		if (scheduler.failed) {
+
+			report.error_message = scheduler.error_message;
+
+			return report;
+
+		}
+
+		if (writer != nullptr) {
+
+			writer->flush();
+
+		}
+
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		report.audio_seconds = reader->lengthInSamples / sample_rate;
+		report.wall_seconds = elapsed.count();
+		report.frames_written = scheduler.rows_written;
+		report.success = true;
+
+		if (loudness_meter != nullptr) {
+
+			report.loudness = loudness_meter->get_readings();
+			report.loudness_measured = true;
+
+		}
+
+		return report;
+
+	}
+
+	std::unique_ptr<AudioFormatReader> open_worker_reader(ChunkScheduler &scheduler) { //nullptr, with the scheduler failed, on error
+
+		std::lock_guard<std::mutex> scheduler_lock(scheduler.mtx);
+
+		AudioFormatManager format_manager;
+		format_manager.registerBasicFormats();
+
+		std::unique_ptr<AudioFormatReader> reader(format_manager.createReaderFor(settings.input_file)); //readers are not thread safe, so one each
+
+		if (reader == nullptr) {
+
+			scheduler.failed = true;
+			scheduler.error_message = "Could not reopen " + settings.input_file.getFullPathName();
+			scheduler.chunk_written.notify_all();
+
+		}
+
+		return reader;
+
+	}
+
+	void run_loudness(ChunkScheduler &scheduler, LoudnessMeter* loudness_meter) { //the whole file, in order
+
+		std::unique_ptr<AudioFormatReader> reader = open_worker_reader(scheduler);
+
+		if (reader != nullptr) {
+
+			measure_loudness(*reader, *loudness_meter, 0, reader->lengthInSamples);
+
+		}
+
+	}
+
+	void run_worker(ChunkScheduler &scheduler, AnalysisOutputWriter* writer, double sample_rate, int64 total_frames, int num_columns) {
+
+		std::unique_ptr<AudioFormatReader> reader = open_worker_reader(scheduler);
+
+		if (reader == nullptr) {
+
+			return;
+
+		}
+
+		AnalysisEngine analysis_engine{ settings.fft_size, settings.spectrogram_num_frequencies, settings.lowest_frequency, settings.highest_frequency };
+
+		configure_engine(analysis_engine, sample_rate);
+
+		while (true) {
+
+			int64 chunk;
+
+			{
+				std::unique_lock<std::mutex> scheduler_lock(scheduler.mtx);
+
+				scheduler.chunk_written.wait(scheduler_lock, [&scheduler] {
+
+					return	scheduler.failed ||
+							scheduler.next_chunk >= scheduler.num_chunks ||
+							scheduler.next_chunk < scheduler.next_chunk_to_write + scheduler.max_chunks_in_flight;
+
+				});
+
+				if (scheduler.failed || scheduler.next_chunk >= scheduler.num_chunks) {
+
+					return;
+
+				}
+
+				chunk = scheduler.next_chunk++;
+			}
+
+			int64 first_frame = chunk * chunk_frames;
+			int64 end_frame = jmin(first_frame + chunk_frames, total_frames);
+			int64 warm_up_frame = jmax((int64)0, first_frame - (settings.num_averages - 1));
+
+			std::unique_ptr<MemoryBlock> chunk_rows(new MemoryBlock());
+			int64 rows;
+
+			{
+				AnalysisOutputWriter chunk_writer(new MemoryOutputStream(*chunk_rows, false), settings.binary_output, num_columns);
+
+				analysis_engine.reset_averages();
+
+				rows = analyse_frames(*reader, analysis_engine, chunk_writer, warm_up_frame, end_frame, first_frame);
+			} //destroying the stream trims chunk_rows to the bytes written
+
+			{
+				std::lock_guard<std::mutex> scheduler_lock(scheduler.mtx);
+
+				scheduler.finished_chunks[chunk] = std::move(chunk_rows);
+				scheduler.rows_written += rows;
+			}
+
+			write_finished_chunks(scheduler, writer);
+
+		}
+
+	}
+
+	void write_finished_chunks(ChunkScheduler &scheduler, AnalysisOutputWriter* writer) { //caller does not hold the scheduler lock
+
+		//the chunks that are ready in order are taken under the lock and written after releasing it. Only one worker
+		//writes at a time, a worker that finds another one writing leaves its chunk for that one to pick up
+
+		std::vector<std::unique_ptr<MemoryBlock>> ready_chunks;
+
+		while (true) {
+
+			{
+				std::lock_guard<std::mutex> scheduler_lock(scheduler.mtx);
+
+				if (!ready_chunks.empty()) { //written on the last pass
+
+					scheduler.next_chunk_to_write += ready_chunks.size();
+					scheduler.chunk_written.notify_all();
+
+				}
+
+				else if (scheduler.writing) {
+
+					return;
+
+				}
+
+				ready_chunks.clear();
+
+				auto next = scheduler.finished_chunks.find(scheduler.next_chunk_to_write);
+
+				while (next != scheduler.finished_chunks.end()) {
+
+					ready_chunks.push_back(std::move(next->second));
+
+					scheduler.finished_chunks.erase(next);
+
+					next = scheduler.finished_chunks.find(scheduler.next_chunk_to_write + (int64)ready_chunks.size());
+
+				}
+
+				scheduler.writing = !ready_chunks.empty();
+
+				if (!scheduler.writing) {
+
+					return;
+
+				}
+			}
+
+			for (int x = 0; x < ready_chunks.size(); x++) {
+
+				if (writer != nullptr) {
+
+					writer->write_raw(ready_chunks[x]->getData(), ready_chunks[x]->getSize());
+
+				}
+
+			}
+
+		}
+
+	}
+
+};
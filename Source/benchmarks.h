@@ -0,0 +1,962 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include "analysis_engine.h"
+#include "multi_resolution_engine.h"
+#include "spectrogram_history.h"
+#include "sample_health.h"
+#include "zoom_fft.h"
+#include "octave_filter_bank.h"
+#include "loudness_meter.h"
+#include "spl_meter.h"
+#include "level_meter.h"
+#include "spectrum_holds.h"
+#include "percentile_spectrum.h"
+#include "spectrogram_auto_range.h"
+#include "spectral_peaks.h"
+#include "feedback_detector.h"
+#include "allocation_counter.h"
+#include "frame_profiler.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <random>
+
+//Micro-benchmarks for every per frame DSP and render preparation kernel. Each case reports the wall time and heap
+//traffic of one call (one "frame") of the kernel, so results can be compared between versions. Run with
+//SoundView --benchmark [--output results.json|results.csv] [--min-time 0.25] [--filter <kernel name substring>]
+
+struct BenchmarkResult
+{
+
+	String kernel;
+	String parameter;
+	int value;
+
+	int64 iterations;
+	double ns_per_frame;
+	double bytes_per_frame;
+	double allocations_per_frame;
+
+};
+
+class MicroBenchmarks
+{
+public:
+
+	MicroBenchmarks(double minimum_seconds_per_case, String kernel_filter) :
+		min_seconds(minimum_seconds_per_case),
+		filter(kernel_filter)
+	{
+	};
+
+	~MicroBenchmarks() {};
+
+	void run_all() {
+
+		benchmark_fft();
+		benchmark_analysis_frame();
+		benchmark_multi_resolution();
+		benchmark_profiler_overhead();
+		benchmark_constant_q();
+		benchmark_filterbank();
+		benchmark_averaging();
+		benchmark_spectrum_holds();
+		benchmark_spectral_peaks();
+		benchmark_smoothing();
+		benchmark_spline();
+		benchmark_sample_health();
+		benchmark_spl_meter();
+		benchmark_level_meter();
+		benchmark_feedback_detector();
+		benchmark_loudness_meter();
+		benchmark_spectrogram_row();
+		benchmark_percentile_spectrum();
+		benchmark_spectrogram_auto_range();
+		benchmark_zoom_fft();
+		benchmark_octave_bands();
+
+	}
+
+	const std::vector<BenchmarkResult>& get_results() const { return results; }
+
+	bool write_results(const File &output_file) { //JSON if the extension is .json, CSV otherwise
+
+		output_file.deleteFile();
+
+		FileOutputStream output_stream(output_file);
+
+		if (!output_stream.openedOk()) {
+
+			return false;
+
+		}
+
+		if (output_file.hasFileExtension("json")) {
+
+			output_stream << "{\n  \"version\": \"" << ProjectInfo::versionString << "\",\n  \"results\": [\n";
+
+			for (int x = 0; x < results.size(); x++) {
+
+				const BenchmarkResult &result = results[x];
+
+				output_stream	<< "    { \"kernel\": \"" << result.kernel << "\", \"parameter\": \"" << result.parameter
+								<< "\", \"value\": " << result.value << ", \"iterations\": " << result.iterations
+								<< ", \"ns_per_frame\": " << String(result.ns_per_frame, 1)
+								<< ", \"bytes_per_frame\": " << String(result.bytes_per_frame, 1)
+								<< ", \"allocations_per_frame\": " << String(result.allocations_per_frame, 2)
+								<< (x + 1 < results.size() ? " },\n" : " }\n");
+
+			}
+
+			output_stream << "  ]\n}\n";
+
+		}
+
+		else {
+
+			output_stream << "version,kernel,parameter,value,iterations,ns_per_frame,bytes_per_frame,allocations_per_frame\n";
+
+			for (int x = 0; x < results.size(); x++) {
+
+				const BenchmarkResult &result = results[x];
+
+				output_stream	<< ProjectInfo::versionString << "," << result.kernel << "," << result.parameter << ","
+								<< result.value << "," << result.iterations << "," << String(result.ns_per_frame, 1) << ","
+								<< String(result.bytes_per_frame, 1) << "," << String(result.allocations_per_frame, 2) << "\n";
+
+			}
+
+		}
+
+		return true;
+
+	}
+
+	static int run_from_command_line(const StringArray &arguments) { //returns the process exit code
+
+		double min_seconds = 0.25;
+		String filter;
+		File output_file;
+
+		for (int x = 0; x < arguments.size(); x++) {
+
+			String value = arguments[x + 1].unquoted();
+
+			if (arguments[x] == "--min-time") { min_seconds = value.getDoubleValue(); x++; }
+			else if (arguments[x] == "--filter") { filter = value; x++; }
+			else if (arguments[x] == "--output") { output_file = File::getCurrentWorkingDirectory().getChildFile(value); x++; }
+
+		}
+
+		MicroBenchmarks benchmarks(min_seconds, filter);
+
+		benchmarks.run_all();
+
+		if (output_file != File() && !benchmarks.write_results(output_file)) {
+
+			std::cerr << "Could not write " << output_file.getFullPathName() << std::endl;
+
+			return 1;
+
+		}
+
+		return 0;
+
+	}
+
+protected:
+
+	//Runs frame() until at least min_seconds have passed (after one untimed warm up call) and records the mean
+	//time and heap allocations per call
+
+	template <typename FrameFunction>
+	void measure(const String &kernel, const String &parameter, int value, FrameFunction frame) {
+
+		frame();
+
+		int64 iterations = 0;
+		int64 batch = 1;
+
+		size_t start_bytes = AllocationCounter::get_thread_bytes_allocated();
+		size_t start_allocations = AllocationCounter::get_thread_allocations();
+
+		auto start = std::chrono::steady_clock::now();
+		std::chrono::duration<double> elapsed(0.0);
+
+		while (elapsed.count() < min_seconds) {
+
+			for (int64 x = 0; x < batch; x++) {
+
+				frame();
+
+			}
+
+			iterations += batch;
+			batch *= 2;
+
+			elapsed = std::chrono::steady_clock::now() - start;
+
+		}
+
+		BenchmarkResult result;
+
+		result.kernel = kernel;
+		result.parameter = parameter;
+		result.value = value;
+		result.iterations = iterations;
+		result.ns_per_frame = (elapsed.count() * 1.0e9) / iterations;
+		result.bytes_per_frame = (AllocationCounter::get_thread_bytes_allocated() - start_bytes) / (iterations * 1.0);
+		result.allocations_per_frame = (AllocationCounter::get_thread_allocations() - start_allocations) / (iterations * 1.0);
+
+		results.push_back(result);
+
+		std::cout	<< kernel << " (" << parameter << " = " << value << "): " << String(result.ns_per_frame, 0) << " ns/frame, "
+					<< String(result.bytes_per_frame, 0) << " bytes/frame" << std::endl;
+
+	}
+
+	void consume(float value) { //results read here cannot be optimised away with the work that made them
+
+		sink_total = sink_total + value;
+
+	}
+
+	bool is_selected(const String &kernel) {
+
+		return filter.isEmpty() || kernel.contains(filter);
+
+	}
+
+	void fill_with_noise(double* samples, int num_samples) {
+
+		std::uniform_real_distribution<double> distribution(-0.5, 0.5);
+
+		for (int x = 0; x < num_samples; x++) {
+
+			samples[x] = distribution(random_generator);
+
+		}
+
+	}
+
+	std::vector<float> random_amplitudes(int num_values) {
+
+		std::uniform_real_distribution<float> distribution(0.0f, 0.1f);
+
+		std::vector<float> values(num_values);
+
+		for (int x = 0; x < num_values; x++) {
+
+			values[x] = distribution(random_generator);
+
+		}
+
+		return values;
+
+	}
+
+	std::vector<int> fft_sizes{ 1024, 2048, 4096, 8192, 16384, 32768, 65536, 131072 };
+	std::vector<int> averaging_depths{ 1, 10, 20, 50, 100 };
+	std::vector<int> smoothing_widths{ 1, 3, 15, 51, 99 };
+	std::vector<int> spectrogram_widths{ 256, 512, 1024, 2048, 4096 };
+	std::vector<int> audio_block_sizes{ 64, 512, 4096 };
+	std::vector<int> constant_q_resolutions{ 12, 24, 48, 96 }; //bins per octave
+	std::vector<int> octave_band_fractions{ 1, 3 }; //bands per octave
+	std::vector<std::pair<int, int>> zoom_bands{ { 20, 2000 }, { 20, 500 }, { 45, 55 } }; //Hz, decimate by 19, 80 and 1024 at 48 kHz
+
+	const int display_fft_size = 16384;
+
+private:
+
+	double min_seconds;
+	String filter;
+
+	std::vector<BenchmarkResult> results;
+
+	volatile float sink_total{ 0.0f };
+
+	std::mt19937 random_generator{ 12345 };
+
+	void benchmark_fft() {
+
+		if (!is_selected("fft_run_fft_analysis")) return;
+
+		for (int x = 0; x < fft_sizes.size(); x++) {
+
+			fft fft0{ fft_sizes[x] };
+
+			std::vector<double> input(fft_sizes[x]);
+
+			fill_with_noise(input.data(), fft_sizes[x]);
+
+			measure("fft_run_fft_analysis", "fft_size", fft_sizes[x], [&] {
+
+				std::copy(input.begin(), input.end(), fft0.fft_input_samples); //run_fft_analysis windows its input in place
+
+				fft0.run_fft_analysis();
+
+			});
+
+		}
+
+	}
+
+	void benchmark_analysis_frame() { //window, FFT, magnitude and averaging as run once per display frame
+
+		if (!is_selected("analysis_engine_analyse_frame")) return;
+
+		for (int x = 0; x < fft_sizes.size(); x++) {
+
+			AnalysisEngine analysis_engine{ fft_sizes[x], 1024, 20.0f, 20000.0f };
+
+			analysis_engine.set_num_averages(20);
+
+			std::vector<double> input(fft_sizes[x]);
+
+			fill_with_noise(input.data(), fft_sizes[x]);
+
+			measure("analysis_engine_analyse_frame", "fft_size", fft_sizes[x], [&] {
+
+				std::copy(input.begin(), input.end(), analysis_engine.get_input_samples());
+
+				analysis_engine.analyse_frame();
+
+			});
+
+		}
+
+	}
+
+	void benchmark_multi_resolution() { //one 256 sample display tick: the due bands' analysis, the stitched RTA and spectrogram row
+
+		if (!is_selected("multi_resolution_tick")) return;
+
+		std::vector<std::vector<AnalysisBand>> layouts{	MultiResolutionEngine::get_single_resolution_bands(display_fft_size, 256),
+														MultiResolutionEngine::get_single_resolution_bands(65536, 256),
+														MultiResolutionEngine::get_multi_resolution_bands() };
+
+		for (int x = 0; x < layouts.size(); x++) {
+
+			MultiResolutionEngine analysis_engine{ 1024, 20.0f, 20000.0f };
+
+			analysis_engine.set_sample_rate(48000.0);
+			analysis_engine.set_num_averages(20);
+			analysis_engine.set_bands(layouts[x]);
+
+			std::vector<double> input(analysis_engine.get_max_fft_size());
+
+			fill_with_noise(input.data(), (int)input.size());
+
+			int64 samples_received = 0;
+
+			bool single_band = analysis_engine.get_num_bands() == 1;
+
+			measure("multi_resolution_tick", single_band ? "fft_size" : "num_bands", single_band ? analysis_engine.get_max_fft_size() : analysis_engine.get_num_bands(), [&] {
+
+				samples_received += 256;
+
+				int num_samples_due = analysis_engine.get_num_samples_due(samples_received);
+
+				std::copy(input.begin(), input.begin() + num_samples_due, analysis_engine.get_input_samples());
+
+				analysis_engine.analyse_frame(samples_received);
+
+				analysis_engine.get_rta_amplitudes();
+				analysis_engine.update_spectrogram_amplitudes();
+
+			});
+
+		}
+
+	}
+
+	void benchmark_constant_q() { //the sparse kernel product alone, onto 1024 log spaced bins of a display sized FFT
+
+		if (!is_selected("constant_q_transform")) return;
+
+		AnalysisEngine analysis_engine{ display_fft_size, 1024, 20.0f, 20000.0f };
+
+		analysis_engine.set_sample_rate(48000.0);
+
+		std::vector<std::vector<double>> spectrum(2, std::vector<double>(display_fft_size / 2 + 1));
+
+		fill_with_noise(spectrum[0].data(), (int)spectrum[0].size());
+		fill_with_noise(spectrum[1].data(), (int)spectrum[1].size());
+
+		std::vector<float> amplitudes;
+
+		for (int x = 0; x < constant_q_resolutions.size(); x++) {
+
+			ConstantQTransform constant_q_transform;
+
+			constant_q_transform.build(display_fft_size, 48000.0, analysis_engine.get_spectrogram_frequencies(), constant_q_resolutions[x]);
+
+			std::cout << "constant_q_transform (bins_per_octave = " << constant_q_resolutions[x] << "): " << constant_q_transform.get_num_nonzero() << " kernel values" << std::endl;
+
+			measure("constant_q_transform", "bins_per_octave", constant_q_resolutions[x], [&] {
+
+				constant_q_transform.process(spectrum, amplitudes);
+
+			});
+
+		}
+
+	}
+
+	void benchmark_filterbank() { //mel triangles over a display sized FFT, at the spectrogram widths
+
+		if (!is_selected("filterbank_process")) return;
+
+		std::vector<std::vector<double>> spectrum(2, std::vector<double>(display_fft_size / 2 + 1));
+
+		fill_with_noise(spectrum[0].data(), (int)spectrum[0].size());
+		fill_with_noise(spectrum[1].data(), (int)spectrum[1].size());
+
+		std::vector<float> amplitudes;
+
+		for (int x = 0; x < spectrogram_widths.size(); x++) {
+
+			AnalysisEngine analysis_engine{ display_fft_size, spectrogram_widths[x], 20.0f, 20000.0f };
+
+			analysis_engine.set_sample_rate(48000.0);
+			analysis_engine.set_frequency_scale(mel_scale);
+
+			Filterbank filterbank;
+
+			filterbank.build(mel_scale, display_fft_size, 48000.0, analysis_engine.get_spectrogram_frequencies());
+
+			measure("filterbank_process", "num_bands", spectrogram_widths[x], [&] {
+
+				filterbank.process(spectrum, 4.0, amplitudes);
+
+			});
+
+		}
+
+	}
+
+	void benchmark_profiler_overhead() { //the multi-resolution display tick with the stage profiler off, then on
+
+		if (!is_selected("profiler_overhead")) return;
+
+		FrameProfiler &profiler = FrameProfiler::get_instance();
+
+		bool was_enabled = profiler.is_enabled();
+
+		MultiResolutionEngine analysis_engine{ 1024, 20.0f, 20000.0f };
+
+		analysis_engine.set_sample_rate(48000.0);
+		analysis_engine.set_num_averages(20);
+		analysis_engine.set_bands(MultiResolutionEngine::get_multi_resolution_bands());
+
+		std::vector<double> input(analysis_engine.get_max_fft_size());
+
+		fill_with_noise(input.data(), (int)input.size());
+
+		int64 samples_received = 0;
+
+		for (int enabled = 0; enabled < 2; enabled++) {
+
+			profiler.set_enabled(enabled == 1);
+
+			measure("profiler_overhead", "profiler_enabled", enabled, [&] {
+
+				SOUNDVIEW_PROFILE_SCOPE("frame");
+
+				samples_received += 256;
+
+				int num_samples_due = analysis_engine.get_num_samples_due(samples_received);
+
+				std::copy(input.begin(), input.begin() + num_samples_due, analysis_engine.get_input_samples());
+
+				analysis_engine.analyse_frame(samples_received);
+
+				analysis_engine.get_rta_amplitudes();
+				analysis_engine.update_spectrogram_amplitudes();
+
+			});
+
+		}
+
+		profiler.set_enabled(was_enabled);
+
+		double disabled_ns = results[results.size() - 2].ns_per_frame;
+		double enabled_ns = results.back().ns_per_frame;
+
+		double overhead_percent = disabled_ns > 0.0 ? 100.0 * (enabled_ns - disabled_ns) / disabled_ns : 0.0;
+
+		std::cout	<< "profiler_overhead: " << String(enabled_ns - disabled_ns, 0) << " ns/frame, " << String(overhead_percent, 2)
+					<< "% of the tick (target under 1%)" << std::endl;
+
+	}
+
+	void benchmark_averaging() {
+
+		int num_bins = display_fft_size / 2;
+
+		std::vector<float> amplitudes = random_amplitudes(num_bins);
+
+		for (int x = 0; x < averaging_depths.size(); x++) {
+
+			AveragingBuffer averaging_buffer;
+
+			averaging_buffer.set_num_averages(averaging_depths[x]);
+			averaging_buffer.set_num_samples(num_bins);
+
+			for (int frame = 0; frame < averaging_depths[x]; frame++) { //measure the steady state, with a full history
+
+				averaging_buffer.add_new_samples(amplitudes);
+
+			}
+
+			if (is_selected("averaging_add_new_samples")) {
+
+				measure("averaging_add_new_samples", "num_averages", averaging_depths[x], [&] {
+
+					averaging_buffer.add_new_samples(amplitudes);
+
+				});
+
+			}
+
+			if (is_selected("averaging_get_average")) {
+
+				float sink = 0.0f;
+
+				measure("averaging_get_average", "num_averages", averaging_depths[x], [&] {
+
+					sink += averaging_buffer.get_average()[1];
+
+				});
+
+				consume(sink);
+
+			}
+
+		}
+
+		for (int mode = median_averaging; mode < num_averaging_modes; mode++) { //the robust modes over a 64 frame window
+
+			String mode_name = mode == median_averaging ? "median" : "trimmed_mean";
+
+			if (!is_selected("averaging_" + mode_name)) continue;
+
+			std::vector<std::vector<float>> frames(8, std::vector<float>());
+
+			for (int frame = 0; frame < frames.size(); frame++) {
+
+				frames[frame] = random_amplitudes(num_bins);
+
+			}
+
+			AveragingBuffer averaging_buffer;
+
+			averaging_buffer.set_num_samples(num_bins);
+			averaging_buffer.set_num_averages(64);
+			averaging_buffer.set_averaging_mode((AveragingMode)mode);
+
+			for (int frame = 0; frame < 64; frame++) { //a full window, so every frame replaces a value
+
+				averaging_buffer.add_new_samples(frames[frame % frames.size()]);
+
+			}
+
+			int next_frame = 0;
+			float sink = 0.0f;
+
+			measure("averaging_" + mode_name, "num_averages", 64, [&] {
+
+				averaging_buffer.add_new_samples(frames[next_frame++ % frames.size()]);
+
+				sink += averaging_buffer.get_average()[1];
+
+			});
+
+			consume(sink);
+
+		}
+
+	}
+
+	void benchmark_spectrum_holds() { //peak, min and decaying holds over the RTA's averaged bins
+
+		if (!is_selected("spectrum_holds_update")) return;
+
+		int num_bins = display_fft_size / 2;
+
+		std::vector<float> amplitudes = random_amplitudes(num_bins);
+
+		SpectrumHolds spectrum_holds;
+
+		spectrum_holds.update(amplitudes, 0.0); //sizes the traces outside the measurement
+
+		measure("spectrum_holds_update", "num_bins", num_bins, [&] {
+
+			spectrum_holds.update(amplitudes, 1.0 / 60.0);
+
+		});
+
+	}
+
+	void benchmark_spectral_peaks() { //local maxima, interpolation and tracking of the 8 strongest peaks
+
+		if (!is_selected("spectral_peaks_update")) return;
+
+		int num_bins = display_fft_size / 2;
+
+		std::vector<float> amplitudes = random_amplitudes(num_bins);
+		std::vector<float> frequencies(num_bins);
+
+		for (int bin = 0; bin < num_bins; bin++) {
+
+			frequencies[bin] = bin * 48000.0f / (num_bins * 2);
+
+		}
+
+		SpectralPeakTracker peak_tracker;
+
+		measure("spectral_peaks_update", "num_bins", num_bins, [&] {
+
+			peak_tracker.update(amplitudes, frequencies);
+
+		});
+
+	}
+
+	void benchmark_smoothing() {
+
+		if (!is_selected("smoothing_process_samples")) return;
+
+		std::vector<float> amplitudes = random_amplitudes(display_fft_size / 2);
+
+		for (int x = 0; x < smoothing_widths.size(); x++) {
+
+			MovingAverageSmoother smoother;
+
+			float sink = 0.0f;
+
+			measure("smoothing_process_samples", "window_size", smoothing_widths[x], [&] {
+
+				sink += smoother.process_samples(amplitudes, 2, smoothing_widths[x])[1];
+
+			});
+
+			consume(sink);
+
+		}
+
+	}
+
+	void benchmark_spline() {
+
+		if (!is_selected("spline_set_points")) return;
+
+		for (int x = 0; x < fft_sizes.size(); x++) {
+
+			int num_bins = fft_sizes[x] / 2;
+
+			std::vector<double> frequencies(num_bins), amplitudes(num_bins);
+
+			for (int bin = 0; bin < num_bins; bin++) {
+
+				frequencies[bin] = bin * (48000.0 / fft_sizes[x]);
+				amplitudes[bin] = (bin % 7) * 0.01;
+
+			}
+
+			tk::spline cubic_interpolator;
+
+			measure("spline_set_points", "num_points", num_bins, [&] {
+
+				cubic_interpolator.set_points(frequencies, amplitudes);
+
+			});
+
+		}
+
+	}
+
+	void benchmark_sample_health() {
+
+		if (!is_selected("sample_health_process_block")) return;
+
+		AudioPeformanceEngine audio_performance_engine{ 1 };
+
+		audio_performance_engine.set_sample_rate(48000.0);
+
+		for (int x = 0; x < audio_block_sizes.size(); x++) {
+
+			std::vector<float> samples = random_amplitudes(audio_block_sizes[x]);
+
+			measure("sample_health_process_block", "block_size", audio_block_sizes[x], [&] {
+
+				audio_performance_engine.process_block(samples.data(), audio_block_sizes[x]);
+
+			});
+
+		}
+
+	}
+
+	void benchmark_spl_meter() { //A weighting, time weighting and interval statistics on two inputs, in the audio callback
+
+		if (!is_selected("spl_meter_process_block")) return;
+
+		SPLMeter spl_meter;
+
+		spl_meter.set_sample_rate(48000.0);
+
+		for (int x = 0; x < audio_block_sizes.size(); x++) {
+
+			std::vector<float> samples = random_amplitudes(audio_block_sizes[x]);
+
+			const float* channels[2] = { samples.data(), samples.data() };
+
+			measure("spl_meter_process_block", "block_size", audio_block_sizes[x], [&] {
+
+				spl_meter.process_block(channels, 2, audio_block_sizes[x]);
+
+			});
+
+		}
+
+	}
+
+	void benchmark_level_meter() { //sample peak, RMS and 4x oversampled true peak on two inputs, in the audio callback
+
+		if (!is_selected("level_meter_process_block")) return;
+
+		LevelMeter level_meter;
+
+		level_meter.set_sample_rate(48000.0);
+
+		for (int x = 0; x < audio_block_sizes.size(); x++) {
+
+			std::vector<float> samples = random_amplitudes(audio_block_sizes[x]);
+
+			const float* channels[2] = { samples.data(), samples.data() };
+
+			measure("level_meter_process_block", "block_size", audio_block_sizes[x], [&] {
+
+				level_meter.process_block(channels, 2, audio_block_sizes[x]);
+
+			});
+
+		}
+
+	}
+
+	void benchmark_feedback_detector() { //the Goertzel filters of 4 feedback candidates, in the audio callback
+
+		if (!is_selected("feedback_detector_process_block")) return;
+
+		FeedbackDetector feedback_detector;
+
+		feedback_detector.set_sample_rate(48000.0);
+
+		const float candidates[4] = { 125.0f, 630.0f, 2500.0f, 8000.0f };
+
+		feedback_detector.set_candidates(candidates, 4);
+
+		for (int x = 0; x < audio_block_sizes.size(); x++) {
+
+			std::vector<float> samples = random_amplitudes(audio_block_sizes[x]);
+
+			measure("feedback_detector_process_block", "block_size", audio_block_sizes[x], [&] {
+
+				feedback_detector.process_block(samples.data(), audio_block_sizes[x]);
+
+			});
+
+		}
+
+	}
+
+	void benchmark_loudness_meter() { //K-weighting and 100 ms sub-blocks for a stereo programme, including the gating updates
+
+		if (!is_selected("loudness_meter_process_block")) return;
+
+		LoudnessMeter loudness_meter{ 2 };
+
+		loudness_meter.set_sample_rate(48000.0);
+
+		for (int x = 0; x < audio_block_sizes.size(); x++) {
+
+			std::vector<float> samples = random_amplitudes(audio_block_sizes[x]);
+
+			const float* channels[2] = { samples.data(), samples.data() };
+
+			measure("loudness_meter_process_block", "block_size", audio_block_sizes[x], [&] {
+
+				loudness_meter.process_block(channels, 2, audio_block_sizes[x]);
+
+			});
+
+		}
+
+	}
+
+	void benchmark_spectrogram_row() { //update_spectrogram_texture: resample onto the log axis, then build the pixel row
+
+		if (!is_selected("spectrogram_update_texture")) return;
+
+		for (int x = 0; x < spectrogram_widths.size(); x++) {
+
+			AnalysisEngine analysis_engine{ display_fft_size, spectrogram_widths[x], 20.0f, 20000.0f };
+
+			fill_with_noise(analysis_engine.get_input_samples(), display_fft_size);
+
+			analysis_engine.analyse_frame();
+
+			SpectrogramHistory spectrogram_history;
+
+			spectrogram_history.set_size(spectrogram_widths[x], 256);
+
+			std::vector<unsigned char> texture_pixels(spectrogram_history.get_num_pixels());
+
+			measure("spectrogram_update_texture", "spectrogram_width", spectrogram_widths[x], [&] {
+
+				spectrogram_history.add_row(analysis_engine.update_spectrogram_amplitudes());
+
+				spectrogram_history.copy_pixels(texture_pixels.data());
+
+			});
+
+		}
+
+	}
+
+	void benchmark_percentile_spectrum() { //one spectrogram row into the L10 / L50 / L90 histograms, after 10 minutes at 60 rows/s
+
+		if (!is_selected("percentile_spectrum_update")) return;
+
+		std::normal_distribution<float> distribution(-60.0f, 6.0f);
+
+		for (int x = 0; x < spectrogram_widths.size(); x++) {
+
+			PercentileSpectrum percentile_spectrum;
+
+			std::vector<std::vector<float>> rows(64, std::vector<float>(spectrogram_widths[x]));
+
+			for (int row = 0; row < rows.size(); row++) {
+
+				for (int column = 0; column < spectrogram_widths[x]; column++) {
+
+					rows[row][column] = distribution(random_generator);
+
+				}
+
+			}
+
+			for (int frame = 0; frame < 36000; frame++) { //full histograms, so the percentiles move as they would late in a measurement
+
+				percentile_spectrum.update(rows[frame % rows.size()]);
+
+			}
+
+			int next_row = 0;
+
+			measure("percentile_spectrum_update", "spectrogram_width", spectrogram_widths[x], [&] {
+
+				percentile_spectrum.update(rows[next_row++ % rows.size()]);
+
+			});
+
+		}
+
+	}
+
+	void benchmark_spectrogram_auto_range() { //one spectrogram row into the noise floors and level histogram, at 60 rows/s
+
+		if (!is_selected("spectrogram_auto_range_update")) return;
+
+		std::normal_distribution<float> distribution(-60.0f, 6.0f);
+
+		for (int x = 0; x < spectrogram_widths.size(); x++) {
+
+			SpectrogramAutoRange auto_range;
+
+			std::vector<std::vector<float>> rows(64, std::vector<float>(spectrogram_widths[x]));
+
+			for (int row = 0; row < rows.size(); row++) {
+
+				for (int column = 0; column < spectrogram_widths[x]; column++) {
+
+					rows[row][column] = distribution(random_generator);
+
+				}
+
+			}
+
+			int next_row = 0;
+
+			measure("spectrogram_auto_range_update", "spectrogram_width", spectrogram_widths[x], [&] {
+
+				auto_range.update(rows[next_row++ % rows.size()], 1.0 / 60.0); //includes the sub-window ends, every 30th row
+
+			});
+
+		}
+
+	}
+
+	void benchmark_zoom_fft() { //mix, filter and decimate one 512 sample block, including its share of the zoom FFTs
+
+		if (!is_selected("zoom_fft_process_block")) return;
+
+		const int block_size = 512;
+
+		std::vector<float> samples = random_amplitudes(block_size);
+
+		for (int x = 0; x < zoom_bands.size(); x++) {
+
+			ZoomFFT zoom_fft{ 8192 };
+
+			zoom_fft.set_sample_rate(48000.0);
+			zoom_fft.set_band(zoom_bands[x].first, zoom_bands[x].second);
+
+			ZoomSpectrum spectrum;
+			int64_t frame_index = -1;
+
+			zoom_fft.process_samples(samples.data(), block_size); //applies the band before the decimation is read
+			zoom_fft.get_spectrum(spectrum, frame_index);
+
+			measure("zoom_fft_process_block", "decimation", spectrum.decimation, [&] {
+
+				zoom_fft.process_samples(samples.data(), block_size);
+
+			});
+
+		}
+
+	}
+
+	void benchmark_octave_bands() { //one 512 sample block at 96 kHz through the whole multirate filter bank
+
+		if (!is_selected("octave_bands_process_block")) return;
+
+		const int block_size = 512;
+
+		std::vector<float> samples = random_amplitudes(block_size);
+
+		for (int x = 0; x < octave_band_fractions.size(); x++) {
+
+			OctaveFilterBank octave_filter_bank;
+
+			octave_filter_bank.set_sample_rate(96000.0);
+			octave_filter_bank.set_bands_per_octave(octave_band_fractions[x]);
+
+			measure("octave_bands_process_block", "bands_per_octave", octave_band_fractions[x], [&] {
+
+				octave_filter_bank.process_samples(samples.data(), block_size);
+
+			});
+
+		}
+
+	}
+
+};
@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    Entry point of soundview-cli, the console build of the headless modes. It is
+    built from Cli/SoundViewCli.jucer with juce_core and the audio modules only,
+    so file analysis, batch analysis and the benchmarks run on build and test
+    servers without a display, OpenGL, GLFW or nanovg.
+
+  ==============================================================================
+*/
+
+#include "JuceHeader.h"
+#include "batch_analysis.h"
+#include "benchmarks.h"
+
+#include <iostream>
+
+int main(int argc, char* argv[])
+{
+
+	StringArray arguments;
+
+	for (int x = 1; x < argc; x++) {
+
+		arguments.add(String::fromUTF8(argv[x]));
+
+	}
+
+	//the same arguments as the GUI executable's command line modes
+
+	if (arguments.contains("--analyse")) {
+
+		return OfflineAnalyser::run_from_command_line(arguments);
+
+	}
+
+	if (arguments.contains("--batch")) {
+
+		return BatchAnalyser::run_from_command_line(arguments);
+
+	}
+
+	if (arguments.contains("--benchmark")) {
+
+		return MicroBenchmarks::run_from_command_line(arguments);
+
+	}
+
+	std::cerr << "Usage: soundview-cli --analyse <file> [options]" << std::endl
+		<< "       soundview-cli --batch <files or folder> [options]" << std::endl
+		<< "       soundview-cli --benchmark [--output results.json|results.csv] [--min-time 0.25] [--filter <kernel>]" << std::endl;
+
+	return 1;
+
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+ #include <xmmintrin.h>
+ #define SOUNDVIEW_CONSTANT_Q_SSE 1
+#endif
+
+//Constant-Q transform by the Brown-Puckette method, run on the spectrum the FFT has already produced. Each output
+//bin is the inner product of that spectrum with the spectrum of the bin's temporal kernel. The temporal kernel is a
+//Hann window Q periods long, centred in the frame, times a complex exponential at the bin's frequency. Kernel spectra
+//are nearly all zero, so they are thresholded once and stored as a sparse matrix in CSR form. Each frame then costs
+//one sparse matrix-vector product. Where Q periods would not fit in the frame (the lowest bins), the kernel is
+//clamped to the frame length, so those bins are variable-Q at the FFT's own resolution. The kernel spectra are
+//evaluated in closed form, so rebuilding for new bins needs no extra FFTs.
+
+class ConstantQTransform
+{
+public:
+
+	ConstantQTransform() {};
+
+	~ConstantQTransform() {};
+
+	//centre_frequencies in Hz, ascending. Q comes from bins_per_octave, independent of how the centres are spaced.
+
+	void build(int fft_size, double sample_rate, const std::vector<float> &centre_frequencies, double bins_per_octave) {
+
+		num_bins = (int)centre_frequencies.size();
+		num_fft_bins = fft_size / 2 + 1;
+		q = 1.0 / (pow(2.0, 1.0 / bins_per_octave) - 1.0);
+
+		row_offsets.assign(1, 0);
+		column_indices.clear();
+		values_re.clear();
+		values_im.clear();
+
+		spectrum_re.resize(num_fft_bins);
+		spectrum_im.resize(num_fft_bins);
+
+		std::vector<std::complex<double>> row;
+
+		for (int bin = 0; bin < num_bins; bin++) {
+
+			double frequency = centre_frequencies[bin];
+			int kernel_length = std::max(16, std::min(fft_size, (int)ceil(q * sample_rate / frequency)));
+			int kernel_offset = (fft_size - kernel_length) / 2;
+
+			double omega = 2.0 * pi * frequency / sample_rate;
+			double centre_fft_bin = frequency * fft_size / sample_rate;
+			int reach = (int)ceil(search_width * fft_size / kernel_length) + 2; //the main lobe and the first few sidelobes
+
+			int first_column = std::max(0, (int)floor(centre_fft_bin) - reach);
+			int last_column = std::min(num_fft_bins - 1, (int)ceil(centre_fft_bin) + reach);
+
+			row.resize(std::max(0, last_column - first_column + 1));
+
+			double peak = 0.0;
+
+			for (int column = first_column; column <= last_column; column++) {
+
+				row[column - first_column] = get_kernel_spectrum(omega - (2.0 * pi * column) / fft_size, kernel_length, kernel_offset);
+
+				peak = std::max(peak, std::abs(row[column - first_column]));
+
+			}
+
+			//trim the ends below the threshold, keeping the row contiguous so it can be applied without a gather
+
+			int kept_first = 0, kept_last = (int)row.size() - 1;
+
+			while (kept_first < kept_last && std::abs(row[kept_first]) < threshold * peak) kept_first++;
+			while (kept_last > kept_first && std::abs(row[kept_last]) < threshold * peak) kept_last--;
+
+			double gain = 2.0 / get_window_overlap(fft_size, kernel_length, kernel_offset); //a full scale cosine at the centre reads 1.0
+
+			for (int x = kept_first; x <= kept_last && row.size() > 0; x++) {
+
+				column_indices.push_back(first_column + x);
+				values_re.push_back((float)(row[x].real() * gain));
+				values_im.push_back((float)(row[x].imag() * gain));
+
+			}
+
+			row_offsets.push_back((int)column_indices.size());
+
+		}
+
+	}
+
+	int get_num_bins() const { return num_bins; }
+
+	int get_num_nonzero() const { return (int)column_indices.size(); }
+
+	double get_q() const { return q; }
+
+	//spectrum is fft::fftw_complex_out (normalised by the FFT size), amplitudes receives one linear value per bin
+
+	void process(const std::vector<std::vector<double>> &spectrum, std::vector<float> &amplitudes) {
+
+		for (int column = 0; column < num_fft_bins; column++) {
+
+			spectrum_re[column] = (float)spectrum[0][column];
+			spectrum_im[column] = (float)spectrum[1][column];
+
+		}
+
+		amplitudes.resize(num_bins);
+
+		for (int bin = 0; bin < num_bins; bin++) {
+
+			int start = row_offsets[bin];
+			int length = row_offsets[bin + 1] - start;
+
+			if (length == 0) {
+
+				amplitudes[bin] = 0.0f;
+
+				continue;
+
+			}
+
+			float re, im;
+
+			multiply_row(&values_re[start], &values_im[start], &spectrum_re[column_indices[start]], &spectrum_im[column_indices[start]], length, re, im);
+
+			amplitudes[bin] = sqrtf(re * re + im * im);
+
+		}
+
+	}
+
+	//sum of spectrum * conj(kernel) over one contiguous row
+
+	static void multiply_row(	const float* kernel_re, const float* kernel_im, const float* spectrum_re, const float* spectrum_im,
+								int length, float &result_re, float &result_im) {
+
+		int x = 0;
+
+		result_re = 0.0f;
+		result_im = 0.0f;
+
+#if SOUNDVIEW_CONSTANT_Q_SSE
+
+		__m128 sum_re = _mm_setzero_ps();
+		__m128 sum_im = _mm_setzero_ps();
+
+		for (; x + 4 <= length; x += 4) {
+
+			__m128 k_re = _mm_loadu_ps(kernel_re + x);
+			__m128 k_im = _mm_loadu_ps(kernel_im + x);
+			__m128 s_re = _mm_loadu_ps(spectrum_re + x);
+			__m128 s_im = _mm_loadu_ps(spectrum_im + x);
+
+			sum_re = _mm_add_ps(sum_re, _mm_add_ps(_mm_mul_ps(s_re, k_re), _mm_mul_ps(s_im, k_im)));
+			sum_im = _mm_add_ps(sum_im, _mm_sub_ps(_mm_mul_ps(s_im, k_re), _mm_mul_ps(s_re, k_im)));
+
+		}
+
+		float lanes_re[4], lanes_im[4];
+
+		_mm_storeu_ps(lanes_re, sum_re);
+		_mm_storeu_ps(lanes_im, sum_im);
+
+		result_re = (lanes_re[0] + lanes_re[1]) + (lanes_re[2] + lanes_re[3]);
+		result_im = (lanes_im[0] + lanes_im[1]) + (lanes_im[2] + lanes_im[3]);
+
+#endif
+
+		for (; x < length; x++) {
+
+			result_re += spectrum_re[x] * kernel_re[x] + spectrum_im[x] * kernel_im[x];
+			result_im += spectrum_im[x] * kernel_re[x] - spectrum_re[x] * kernel_im[x];
+
+		}
+
+	}
+
+private:
+
+	const double pi = 3.141592653589793;
+	const double threshold = 0.0054; //relative to the row's peak, as in Brown and Puckette
+	const double search_width = 6.0; //Hann main lobe is 2 kernel bins wide each side, sidelobes fall below the threshold by 6
+
+	int num_bins{ 0 };
+	int num_fft_bins{ 0 };
+	double q{ 1.0 };
+
+	std::vector<int> row_offsets; //num_bins + 1, row b is [row_offsets[b], row_offsets[b + 1])
+	std::vector<int> column_indices; //FFT bins, contiguous within a row
+	std::vector<float> values_re, values_im;
+
+	std::vector<float> spectrum_re, spectrum_im;
+
+	static std::complex<double> geometric_sum(double theta, int length) { //sum of e^(i theta m) for m = 0..length-1
+
+		double half_sine = sin(theta * 0.5);
+
+		if (fabs(half_sine) < 1.0e-12) {
+
+			return std::complex<double>(length, 0.0);
+
+		}
+
+		double phase = theta * (length - 1) * 0.5;
+
+		return std::complex<double>(cos(phase), sin(phase)) * (sin(theta * length * 0.5) / half_sine); //the magnitude can be negative, so not std::polar
+
+	}
+
+	//DFT at angular offset delta from the kernel frequency of a Hann window of kernel_length starting at kernel_offset
+
+	std::complex<double> get_kernel_spectrum(double delta, int kernel_length, int kernel_offset) const {
+
+		double phi = 2.0 * pi / (kernel_length - 1);
+
+		std::complex<double> window_sum =	0.5 * geometric_sum(delta, kernel_length)
+											- 0.25 * geometric_sum(delta + phi, kernel_length)
+											- 0.25 * geometric_sum(delta - phi, kernel_length);
+
+		return std::polar(1.0, delta * kernel_offset) * window_sum;
+
+	}
+
+	double get_window_overlap(int fft_size, int kernel_length, int kernel_offset) const { //sum of the frame's Hann window times the kernel's
+
+		//(0.5 - 0.5 cos(alpha n)) (0.5 - 0.5 cos(phi m)) with n = m + kernel_offset, summed as geometric series
+
+		double alpha = 2.0 * pi / (fft_size - 1);
+		double phi = 2.0 * pi / (kernel_length - 1);
+
+		std::complex<double> frame_phase = std::polar(1.0, alpha * kernel_offset);
+
+		return	0.25 * kernel_length
+				- 0.25 * (frame_phase * geometric_sum(alpha, kernel_length)).real()
+				- 0.25 * geometric_sum(phi, kernel_length).real()
+				+ 0.125 * (frame_phase * (geometric_sum(alpha + phi, kernel_length) + geometric_sum(alpha - phi, kernel_length))).real();
+
+	}
+
+};
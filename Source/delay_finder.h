@@ -0,0 +1,365 @@
+#pragma once
+
+#include "fft.h"
+#include "sample_fifo.h"
+#include "frame_profiler.h"
+
+#include <fftw3.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+
+//Finds the propagation delay between a reference input and a measurement input using generalised cross correlation
+//with phase transform (GCC-PHAT). The audio thread only pushes samples into a SampleFifo, all of the FFT work is done
+//on a background thread which re-estimates the delay every hop over the most recent analysis window.
+
+struct DelayFinderResult
+{
+
+	double delay_samples{ 0.0 }; //positive when the measurement lags the reference
+	double delay_ms{ 0.0 };
+	double confidence{ 0.0 }; //height of the whitened correlation peak, 0 = no coherence, 1 = pure delay
+	bool polarity_inverted{ false };
+	bool valid{ false };
+
+};
+
+class DelayFinder
+{
+public:
+
+	//window_size is the analysis length in samples (several seconds is fine), hop_size is how often the delay is re-estimated
+
+	DelayFinder(int window_size_samples, int hop_size_samples) :
+		window_size(window_size_samples),
+		hop_size(hop_size_samples),
+		correlation_size(window_size_samples * 2), //zero padded to twice the window so the correlation is linear, not circular
+		correlation_bins(window_size_samples + 1),
+		input_fifo(2, window_size_samples)
+	{
+
+		max_lag = window_size / 2;
+
+		measurement_history.resize(window_size, 0.0);
+		reference_history.resize(window_size, 0.0);
+
+		measurement_hop.resize(hop_size);
+		reference_hop.resize(hop_size);
+
+		correlation_input = fftw_alloc_real(correlation_size);
+		correlation_output = fftw_alloc_real(correlation_size);
+
+		measurement_spectrum = fftw_alloc_complex(correlation_bins);
+		reference_spectrum = fftw_alloc_complex(correlation_bins);
+		cross_spectrum = fftw_alloc_complex(correlation_bins);
+
+		std::lock_guard<std::mutex> planner_lock(fftw_planner_mutex());
+
+		//FFTW_ESTIMATE keeps start up fast for multi second windows, FFTW_MEASURE can take seconds at these sizes
+
+		forward_plan = fftw_plan_dft_r2c_1d(correlation_size, correlation_input, measurement_spectrum, FFTW_ESTIMATE);
+		inverse_plan = fftw_plan_dft_c2r_1d(correlation_size, cross_spectrum, correlation_output, FFTW_ESTIMATE);
+
+	};
+
+	~DelayFinder() {
+
+		stop();
+
+		std::unique_lock<std::mutex> planner_lock(fftw_planner_mutex());
+		fftw_destroy_plan(forward_plan);
+		fftw_destroy_plan(inverse_plan);
+		planner_lock.unlock();
+
+		fftw_free(correlation_input);
+		fftw_free(correlation_output);
+		fftw_free(measurement_spectrum);
+		fftw_free(reference_spectrum);
+		fftw_free(cross_spectrum);
+
+	};
+
+	void start() {
+
+		if (worker_thread.joinable()) {
+
+			return;
+
+		}
+
+		stop_requested.store(false);
+
+		worker_thread = std::thread(&DelayFinder::run, this);
+
+	}
+
+	void stop() {
+
+		stop_requested.store(true);
+
+		if (worker_thread.joinable()) {
+
+			worker_thread.join();
+
+		}
+
+	}
+
+	void push_samples(const float* measurement_samples, const float* reference_samples, int num_samples) { //audio thread
+
+		const float* channels[2] = { measurement_samples, reference_samples };
+
+		input_fifo.push(channels, num_samples);
+
+	}
+
+	void set_sample_rate(double sample_rate) {
+
+		active_sample_rate.store(sample_rate);
+
+	}
+
+	void reset() { //discards the current window, e.g. after the device or sample rate changes
+
+		reset_requested.store(true);
+
+	}
+
+	void set_confidence_threshold(double threshold) {
+
+		confidence_threshold.store(threshold);
+
+	}
+
+	DelayFinderResult get_latest_result() {
+
+		std::lock_guard<std::mutex> result_lock(result_mtx);
+
+		return latest_result;
+
+	}
+
+	DelayFinderResult get_tracked_result() { //the most recent estimate whose confidence was above the threshold
+
+		std::lock_guard<std::mutex> result_lock(result_mtx);
+
+		return tracked_result;
+
+	}
+
+	int get_window_size() const { return window_size; }
+
+	int get_dropped_samples() const { return input_fifo.get_dropped_samples(); }
+
+private:
+
+	const int window_size;
+	const int hop_size;
+	const int correlation_size;
+	const int correlation_bins;
+
+	int max_lag;
+	int samples_in_history{ 0 };
+
+	SampleFifo input_fifo; //channel 0 = measurement, channel 1 = reference
+
+	std::vector<double> measurement_history, reference_history;
+	std::vector<float> measurement_hop, reference_hop;
+
+	double *correlation_input, *correlation_output;
+	fftw_complex *measurement_spectrum, *reference_spectrum, *cross_spectrum;
+	fftw_plan forward_plan, inverse_plan;
+
+	std::thread worker_thread;
+	std::atomic<bool> stop_requested{ false };
+	std::atomic<bool> reset_requested{ false };
+	std::atomic<double> active_sample_rate{ 44100.0 };
+	std::atomic<double> confidence_threshold{ 0.1 };
+
+	std::mutex result_mtx;
+	DelayFinderResult latest_result, tracked_result;
+
+	void run() {
+
+		FrameProfiler::get_instance().set_thread_name("Delay finder");
+
+		while (!stop_requested.load()) {
+
+			if (reset_requested.exchange(false)) {
+
+				discard_history();
+
+			}
+
+			if (input_fifo.get_num_ready() < hop_size) {
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+				continue;
+
+			}
+
+			float* hop_channels[2] = { measurement_hop.data(), reference_hop.data() };
+
+			input_fifo.pop(hop_channels, hop_size);
+
+			append_hop();
+
+			if (samples_in_history < window_size) {
+
+				continue;
+
+			}
+
+			DelayFinderResult result;
+
+			{
+				SOUNDVIEW_PROFILE_SCOPE("delay_finder_gcc_phat");
+
+				result = find_delay();
+			}
+
+			std::lock_guard<std::mutex> result_lock(result_mtx);
+
+			latest_result = result;
+
+			if (result.confidence >= confidence_threshold.load()) {
+
+				tracked_result = result;
+
+			}
+
+		}
+
+	}
+
+	void discard_history() {
+
+		float* hop_channels[2] = { measurement_hop.data(), reference_hop.data() };
+
+		while (input_fifo.get_num_ready() > 0) {
+
+			input_fifo.pop(hop_channels, hop_size);
+
+		}
+
+		std::fill(measurement_history.begin(), measurement_history.end(), 0.0);
+		std::fill(reference_history.begin(), reference_history.end(), 0.0);
+
+		samples_in_history = 0;
+
+		std::lock_guard<std::mutex> result_lock(result_mtx);
+
+		latest_result = DelayFinderResult();
+		tracked_result = DelayFinderResult();
+
+	}
+
+	void append_hop() {
+
+		std::copy(measurement_history.begin() + hop_size, measurement_history.end(), measurement_history.begin());
+		std::copy(reference_history.begin() + hop_size, reference_history.end(), reference_history.begin());
+
+		std::copy(measurement_hop.begin(), measurement_hop.end(), measurement_history.end() - hop_size);
+		std::copy(reference_hop.begin(), reference_hop.end(), reference_history.end() - hop_size);
+
+		samples_in_history = std::min(samples_in_history + hop_size, window_size);
+
+	}
+
+	void transform_history(std::vector<double> &history, fftw_complex *spectrum) {
+
+		std::copy(history.begin(), history.end(), correlation_input);
+		std::fill(correlation_input + window_size, correlation_input + correlation_size, 0.0);
+
+		fftw_execute_dft_r2c(forward_plan, correlation_input, spectrum);
+
+	}
+
+	DelayFinderResult find_delay() {
+
+		transform_history(measurement_history, measurement_spectrum);
+		transform_history(reference_history, reference_spectrum);
+
+		//cross spectrum M * conj(R), whitened so that only phase (i.e. delay) information remains
+
+		for (int bin = 0; bin < correlation_bins; bin++) {
+
+			double re = measurement_spectrum[bin][0] * reference_spectrum[bin][0] + measurement_spectrum[bin][1] * reference_spectrum[bin][1];
+			double im = measurement_spectrum[bin][1] * reference_spectrum[bin][0] - measurement_spectrum[bin][0] * reference_spectrum[bin][1];
+
+			double magnitude = sqrt(re * re + im * im);
+
+			if (magnitude > 1e-20) {
+
+				cross_spectrum[bin][0] = re / magnitude;
+				cross_spectrum[bin][1] = im / magnitude;
+
+			}
+
+			else {
+
+				cross_spectrum[bin][0] = 0.0;
+				cross_spectrum[bin][1] = 0.0;
+
+			}
+
+		}
+
+		fftw_execute(inverse_plan);
+
+		//negative lags wrap around to the end of the correlation
+
+		int peak_lag = 0;
+		double peak_value = 0.0;
+
+		for (int lag = -max_lag; lag <= max_lag; lag++) {
+
+			double value = correlation_output[lag_to_index(lag)];
+
+			if (fabs(value) > fabs(peak_value)) {
+
+				peak_value = value;
+				peak_lag = lag;
+
+			}
+
+		}
+
+		double polarity = peak_value < 0.0 ? -1.0 : 1.0;
+
+		double y_minus = polarity * correlation_output[lag_to_index(peak_lag - 1)];
+		double y_zero = polarity * peak_value;
+		double y_plus = polarity * correlation_output[lag_to_index(peak_lag + 1)];
+
+		double parabola_denominator = y_minus - (2.0 * y_zero) + y_plus;
+		double fractional_lag = 0.0;
+
+		if (parabola_denominator < 0.0) { //only a maximum gives a meaningful vertex
+
+			fractional_lag = 0.5 * (y_minus - y_plus) / parabola_denominator;
+
+		}
+
+		DelayFinderResult result;
+
+		result.delay_samples = peak_lag + fractional_lag;
+		result.delay_ms = (result.delay_samples / active_sample_rate.load()) * 1000.0;
+		result.confidence = std::min(1.0, y_zero / correlation_size); //unnormalised c2r output of a flat unit spectrum peaks at correlation_size
+		result.polarity_inverted = polarity < 0.0;
+		result.valid = true;
+
+		return result;
+
+	}
+
+	int lag_to_index(int lag) {
+
+		return lag >= 0 ? lag : correlation_size + lag;
+
+	}
+
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "latency_histogram.h"
+#include "frame_profiler.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iomanip>
+
+//How stale the display is. Audio blocks are stamped when they enter getNextAudioBlock. Each display frame carries
+//the stamp of the newest block it analysed through to the buffer swap. At the swap, the age of that block is split
+//into ring wait (from block arrival to the frame's ring copy), analysis (from the ring copy to the end of the
+//analysis) and render (from the end of the analysis to the return from glfwSwapBuffers). All times use the
+//FrameProfiler clock, so they line up with the profiler's trace.
+
+struct DisplayLatencyFrame
+{
+
+	int64_t newest_sample_ns{ 0 }; //arrival of the newest block in the frame, 0 = no audio yet
+	int64_t ring_copy_ns{ 0 };
+	int64_t analysis_done_ns{ 0 };
+	int64_t presented_ns{ 0 };
+
+	bool is_valid() const { return newest_sample_ns > 0 && presented_ns >= analysis_done_ns && analysis_done_ns >= ring_copy_ns && ring_copy_ns >= newest_sample_ns; }
+
+	double get_ring_wait() const { return (ring_copy_ns - newest_sample_ns) * 1.0e-9; }
+	double get_analysis() const { return (analysis_done_ns - ring_copy_ns) * 1.0e-9; }
+	double get_render() const { return (presented_ns - analysis_done_ns) * 1.0e-9; }
+	double get_total() const { return (presented_ns - newest_sample_ns) * 1.0e-9; }
+
+};
+
+struct DisplayLatencySummary
+{
+
+	int64_t num_frames{ 0 };
+
+	double total_p50{ 0.0 }, total_p99{ 0.0 }, total_max{ 0.0 };
+	double ring_wait_p50{ 0.0 }, analysis_p50{ 0.0 }, render_p50{ 0.0 };
+
+};
+
+class DisplayLatencyTracker
+{
+public:
+
+	DisplayLatencyTracker() {};
+
+	~DisplayLatencyTracker() {};
+
+	void reset() {
+
+		total_histogram.reset();
+		ring_wait_histogram.reset();
+		analysis_histogram.reset();
+		render_histogram.reset();
+
+		recent_frames.clear();
+
+	}
+
+	void add_frame(const DisplayLatencyFrame &frame) { //render thread only
+
+		if (!frame.is_valid()) {
+
+			return;
+
+		}
+
+		total_histogram.record(frame.get_total());
+		ring_wait_histogram.record(frame.get_ring_wait());
+		analysis_histogram.record(frame.get_analysis());
+		render_histogram.record(frame.get_render());
+
+		recent_frames.push_back(frame);
+
+		while (recent_frames.size() > max_recent_frames) { recent_frames.pop_front(); }
+
+	}
+
+	DisplayLatencySummary get_summary() const {
+
+		DisplayLatencySummary summary;
+
+		summary.num_frames = total_histogram.get_count();
+
+		summary.total_p50 = total_histogram.get_percentile(50.0);
+		summary.total_p99 = total_histogram.get_percentile(99.0);
+		summary.total_max = total_histogram.get_max();
+
+		summary.ring_wait_p50 = ring_wait_histogram.get_percentile(50.0);
+		summary.analysis_p50 = analysis_histogram.get_percentile(50.0);
+		summary.render_p50 = render_histogram.get_percentile(50.0);
+
+		return summary;
+
+	}
+
+	//Chrome trace counter events (one per recent frame, at its present time) for FrameProfiler::write_chrome_trace
+
+	std::vector<std::string> get_trace_counter_events() const {
+
+		std::vector<std::string> events;
+
+		for (int x = 0; x < recent_frames.size(); x++) {
+
+			const DisplayLatencyFrame &frame = recent_frames[x];
+
+			std::ostringstream event;
+
+			event	<< std::fixed << std::setprecision(3)
+					<< "{\"name\":\"input_to_photon_ms\",\"ph\":\"C\",\"pid\":1,\"ts\":" << frame.presented_ns / 1000.0
+					<< ",\"args\":{\"ring_wait\":" << frame.get_ring_wait() * 1000.0 << ",\"analysis\":" << frame.get_analysis() * 1000.0
+					<< ",\"render\":" << frame.get_render() * 1000.0 << "}}";
+
+			events.push_back(event.str());
+
+		}
+
+		return events;
+
+	}
+
+private:
+
+	static const int max_recent_frames = 8192;
+
+	LatencyHistogram total_histogram, ring_wait_histogram, analysis_histogram, render_histogram;
+
+	std::deque<DisplayLatencyFrame> recent_frames;
+
+};
@@ -0,0 +1,918 @@
+#pragma once
+
+#include "spectral_peaks.h"
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+ #include <xmmintrin.h>
+ #define SOUNDVIEW_FEEDBACK_SSE 1
+#endif
+
+//Early warning of acoustic feedback. FeedbackMonitor picks candidates from the analysis frames: tracked spectral peaks
+//that stand well above the bins around them and whose level has been rising. Up to four candidates are handed to
+//FeedbackDetector, which runs one Goertzel filter per candidate on the input in the audio callback. The four filters
+//are the four lanes of one SSE register, so each sample costs one multiply-add per candidate whatever the FFT size.
+//Every 20 ms window gives each candidate a level and a tonality: the filter's power relative to the power white noise
+//of the same total level would give it. The windows go into a ring of atomics. A candidate is confirmed when, over
+//the last 0.2 s of windows, its level rises steadily (a straight line fit in dB with a good fit) and it is clearly
+//tonal. Each candidate reports its frequency, growth rate and the time left until it reaches the threshold level at
+//that rate. process_block() never allocates or locks.
+
+class FeedbackDetector
+{
+public:
+
+	static const int max_candidates = 4;
+	static const int ring_windows = 128; //2.56 s of windows
+
+	FeedbackDetector() {
+
+		for (int x = 0; x < ring_windows * max_candidates; x++) {
+
+			window_amplitudes[x].store(0.0f);
+			window_frequencies[x].store(0.0f);
+
+		}
+
+		for (int x = 0; x < ring_windows; x++) {
+
+			window_mean_squares[x].store(0.0f);
+			window_end_samples[x].store(0);
+
+		}
+
+		for (int candidate = 0; candidate < max_candidates; candidate++) {
+
+			candidate_frequencies[candidate].store(0.0f);
+
+		}
+
+		reset();
+
+	};
+
+	~FeedbackDetector() {};
+
+	void set_sample_rate(double sample_rate) { //call while the audio callback is stopped, e.g. from prepareToPlay
+
+		window_size = std::max(64, (int)(sample_rate * 0.02 + 0.5));
+
+		detector_sample_rate.store(sample_rate);
+
+		reset();
+
+	}
+
+	void set_candidates(const float* frequencies, int num_candidates) { //reader thread, applied from the next window
+
+		for (int candidate = 0; candidate < max_candidates; candidate++) {
+
+			candidate_frequencies[candidate].store(candidate < num_candidates ? frequencies[candidate] : 0.0f, std::memory_order_relaxed);
+
+		}
+
+		candidate_generation.fetch_add(1, std::memory_order_release);
+
+	}
+
+	void process_block(const float* samples, int num_samples) { //audio thread only
+
+		int offset = 0;
+
+		while (offset < num_samples) {
+
+			if (samples_in_window == 0) {
+
+				start_window();
+
+			}
+
+			int samples_to_process = std::min(num_samples - offset, window_size - samples_in_window);
+
+			if (num_active_candidates > 0) {
+
+				run_filters(samples + offset, samples_to_process);
+
+			}
+
+			offset += samples_to_process;
+			samples_in_window += samples_to_process;
+			samples_processed += samples_to_process;
+
+			if (samples_in_window == window_size) {
+
+				publish_window();
+
+				samples_in_window = 0;
+
+			}
+
+		}
+
+	}
+
+	//reader side, any single thread
+
+	int64_t get_completed_windows() const { return completed_windows.load(std::memory_order_acquire); }
+
+	void get_window(int64_t window, int candidate, float &frequency, float &amplitude) const {
+
+		int slot = (int)(window % ring_windows) * max_candidates + candidate;
+
+		frequency = window_frequencies[slot].load(std::memory_order_relaxed);
+		amplitude = window_amplitudes[slot].load(std::memory_order_relaxed);
+
+	}
+
+	float get_window_mean_square(int64_t window) const { return window_mean_squares[window % ring_windows].load(std::memory_order_relaxed); }
+
+	int64_t get_window_end_sample(int64_t window) const { return window_end_samples[window % ring_windows].load(std::memory_order_relaxed); }
+
+	int get_window_size() const { return window_size; }
+
+	double get_sample_rate() const { return detector_sample_rate.load(); }
+
+private:
+
+	int window_size{ 960 };
+	std::atomic<double> detector_sample_rate{ 48000.0 };
+
+	std::atomic<float> candidate_frequencies[max_candidates];
+	std::atomic<int> candidate_generation{ 0 };
+
+	//audio thread state
+
+	int applied_generation{ -1 };
+	int num_active_candidates{ 0 };
+	int samples_in_window{ 0 };
+	int64_t samples_processed{ 0 };
+
+	float lane_frequencies[max_candidates];
+	float lane_coefficients[max_candidates]; //2 cos(w)
+	float lane_state_1[max_candidates], lane_state_2[max_candidates];
+	double window_energy{ 0.0 };
+
+	//published windows
+
+	std::atomic<float> window_amplitudes[ring_windows * max_candidates];
+	std::atomic<float> window_frequencies[ring_windows * max_candidates];
+	std::atomic<float> window_mean_squares[ring_windows];
+	std::atomic<int64_t> window_end_samples[ring_windows];
+	std::atomic<int64_t> completed_windows{ 0 };
+
+	void reset() {
+
+		applied_generation = -1;
+		samples_in_window = 0;
+		samples_processed = 0;
+		num_active_candidates = 0;
+
+		std::fill(lane_frequencies, lane_frequencies + max_candidates, 0.0f);
+		std::fill(lane_coefficients, lane_coefficients + max_candidates, 0.0f);
+
+		completed_windows.store(0, std::memory_order_release);
+
+	}
+
+	void start_window() {
+
+		int generation = candidate_generation.load(std::memory_order_acquire);
+
+		if (generation != applied_generation) {
+
+			applied_generation = generation;
+
+			double sample_rate = detector_sample_rate.load();
+
+			num_active_candidates = 0;
+
+			for (int candidate = 0; candidate < max_candidates; candidate++) {
+
+				float frequency = candidate_frequencies[candidate].load(std::memory_order_relaxed);
+
+				lane_frequencies[candidate] = frequency > 0.0f && frequency < sample_rate * 0.5 ? frequency : 0.0f;
+				lane_coefficients[candidate] = (float)(2.0 * cos(2.0 * 3.14159265358979 * lane_frequencies[candidate] / sample_rate));
+
+				num_active_candidates += lane_frequencies[candidate] > 0.0f;
+
+			}
+
+		}
+
+		std::fill(lane_state_1, lane_state_1 + max_candidates, 0.0f);
+		std::fill(lane_state_2, lane_state_2 + max_candidates, 0.0f);
+
+		window_energy = 0.0;
+
+	}
+
+	void run_filters(const float* samples, int num_samples) {
+
+		float energy = 0.0f;
+
+#ifdef SOUNDVIEW_FEEDBACK_SSE
+
+		__m128 coefficients = _mm_loadu_ps(lane_coefficients);
+		__m128 state_1 = _mm_loadu_ps(lane_state_1);
+		__m128 state_2 = _mm_loadu_ps(lane_state_2);
+
+		for (int sample = 0; sample < num_samples; sample++) {
+
+			__m128 state_0 = _mm_sub_ps(_mm_add_ps(_mm_set1_ps(samples[sample]), _mm_mul_ps(coefficients, state_1)), state_2);
+
+			state_2 = state_1;
+			state_1 = state_0;
+
+			energy += samples[sample] * samples[sample];
+
+		}
+
+		_mm_storeu_ps(lane_state_1, state_1);
+		_mm_storeu_ps(lane_state_2, state_2);
+
+#else
+
+		for (int sample = 0; sample < num_samples; sample++) {
+
+			for (int lane = 0; lane < max_candidates; lane++) {
+
+				float state_0 = samples[sample] + lane_coefficients[lane] * lane_state_1[lane] - lane_state_2[lane];
+
+				lane_state_2[lane] = lane_state_1[lane];
+				lane_state_1[lane] = state_0;
+
+			}
+
+			energy += samples[sample] * samples[sample];
+
+		}
+
+#endif
+
+		window_energy += energy;
+
+	}
+
+	void publish_window() {
+
+		int64_t window = completed_windows.load(std::memory_order_relaxed);
+
+		int slot = (int)(window % ring_windows);
+
+		for (int candidate = 0; candidate < max_candidates; candidate++) {
+
+			float power = lane_state_1[candidate] * lane_state_1[candidate] + lane_state_2[candidate] * lane_state_2[candidate]
+						- lane_coefficients[candidate] * lane_state_1[candidate] * lane_state_2[candidate];
+
+			float amplitude = lane_frequencies[candidate] > 0.0f ? 2.0f * sqrtf(std::max(0.0f, power)) / window_size : 0.0f; //of a sine
+
+			window_amplitudes[slot * max_candidates + candidate].store(amplitude, std::memory_order_relaxed);
+			window_frequencies[slot * max_candidates + candidate].store(lane_frequencies[candidate], std::memory_order_relaxed);
+
+		}
+
+		window_mean_squares[slot].store((float)(window_energy / window_size), std::memory_order_relaxed);
+		window_end_samples[slot].store(samples_processed, std::memory_order_relaxed);
+
+		completed_windows.store(window + 1, std::memory_order_release);
+
+	}
+
+};
+
+struct FeedbackReport
+{
+
+	float frequency{ 0.0f }; //Hz
+	float level_dB{ -200.0f }; //dBFS of a sine at the frequency
+	float growth_dB_per_second{ 0.0f };
+	float seconds_to_threshold{ -1.0f }; //-1 while the level is not rising
+	bool confirmed{ false };
+
+};
+
+struct FeedbackConfirmation
+{
+
+	float frequency{ 0.0f };
+	int64_t sample{ 0 }; //input samples since the detector started, at the end of the confirming window
+
+};
+
+class FeedbackMonitor
+{
+public:
+
+	static const int max_candidates = FeedbackDetector::max_candidates;
+	static const int max_confirmations = 64;
+
+	FeedbackMonitor() {
+
+		peak_tracker.set_max_peaks(8);
+		peak_tracker.set_min_level(-80.0f);
+
+		track_histories.reserve(32);
+		reports.reserve(max_candidates);
+
+	};
+
+	~FeedbackMonitor() {};
+
+	void set_threshold(float threshold_dBFS) { threshold = threshold_dBFS; }
+
+	float get_threshold() const { return threshold; }
+
+	void add_frame(FeedbackDetector &detector, const std::vector<float> &amplitudes, const std::vector<float> &frequencies, double frame_seconds) {
+
+		//one unaveraged analysis frame, linear amplitudes, at the time of its newest sample
+
+		peak_tracker.update(amplitudes, frequencies);
+
+		update_track_histories(amplitudes, frequencies, frame_seconds);
+
+		if (update_candidates()) {
+
+			float candidate_frequencies[max_candidates];
+
+			for (int candidate = 0; candidate < max_candidates; candidate++) {
+
+				candidate_frequencies[candidate] = candidates[candidate].track_id != 0 ? candidates[candidate].frequency : 0.0f;
+
+			}
+
+			detector.set_candidates(candidate_frequencies, max_candidates);
+
+		}
+
+	}
+
+	void update(const FeedbackDetector &detector) { //consumes the windows completed since the last call
+
+		int64_t completed = detector.get_completed_windows();
+
+		if (completed < next_window) { //the detector was reset by a device change
+
+			next_window = 0;
+
+		}
+
+		next_window = std::max(next_window, completed - (FeedbackDetector::ring_windows - 1));
+
+		double sample_rate = detector.get_sample_rate();
+
+		goertzel_bandwidth = sample_rate / detector.get_window_size();
+
+		//the power white noise of the same level would put through a Goertzel filter of this length
+
+		double noise_share = 2.0 / detector.get_window_size();
+
+		for (; next_window < completed; next_window++) {
+
+			float mean_square = detector.get_window_mean_square(next_window);
+			int64_t end_sample = detector.get_window_end_sample(next_window);
+
+			for (int candidate = 0; candidate < max_candidates; candidate++) {
+
+				Candidate &state = candidates[candidate];
+
+				float frequency, amplitude;
+
+				detector.get_window(next_window, candidate, frequency, amplitude);
+
+				if (state.track_id == 0 || frequency != state.detector_frequency) { //not yet measuring this candidate
+
+					continue;
+
+				}
+
+				WindowLevel &level = state.windows[state.next_window_slot];
+
+				level.seconds = end_sample / sample_rate;
+				level.level_dB = amplitude_to_dB(amplitude);
+				level.tonality_dB = mean_square > 0.0f ? (float)(10.0 * log10((0.5 * amplitude * amplitude) / (mean_square * noise_share) + 1e-12)) : 0.0f;
+
+				state.next_window_slot = (state.next_window_slot + 1) % window_history;
+				state.num_windows = std::min(state.num_windows + 1, (int)window_history);
+				state.windows_measured++;
+
+				check_confirmation(state, end_sample);
+
+			}
+
+		}
+
+		update_reports();
+
+	}
+
+	void reset(FeedbackDetector &detector) {
+
+		peak_tracker.reset();
+
+		track_histories.clear();
+
+		for (int candidate = 0; candidate < max_candidates; candidate++) {
+
+			candidates[candidate] = Candidate();
+
+		}
+
+		float no_candidates[max_candidates] = {};
+
+		detector.set_candidates(no_candidates, max_candidates);
+
+		reports.clear();
+
+	}
+
+	const std::vector<FeedbackReport>& get_reports() const { return reports; } //one per candidate
+
+	int64_t get_num_confirmations() const { return num_confirmations; }
+
+	FeedbackConfirmation get_confirmation(int64_t confirmation) const { return confirmations[confirmation % max_confirmations]; } //the last 64 are kept
+
+private:
+
+	static const int frame_history = 16;
+	static const int max_missed_frames = 3; //the peak tracker keeps a track as long
+	static const int window_history = 32; //0.64 s, slow growth needs the longer fit to stand out from the noise
+	static const int confirmation_windows = 10; //0.2 s, the shortest fit
+	static const int give_up_windows = 100; //2 s measured without growing
+
+	const float min_peak_to_average_dB = 15.0f; //to become a candidate
+	const float keep_peak_to_average_dB = 10.0f; //to stay one
+	const float min_growth = 3.0f; //dB per second
+	const float min_fit = 0.7f; //r squared of the growth line
+	const float min_tonality_dB = 10.0f;
+	const float retune_fraction = 0.25f; //of the Goertzel bandwidth
+
+	float threshold{ -3.0f }; //dBFS
+
+	SpectralPeakTracker peak_tracker;
+
+	struct TrackHistory
+	{
+
+		int track_id{ 0 };
+		double seconds[frame_history] = {};
+		float levels_dB[frame_history] = {};
+		int num_frames{ 0 };
+		int next_slot{ 0 };
+		float peak_to_average_dB{ 0.0f };
+		float growth{ 0.0f };
+		float rejected_level_dB{ -1000.0f }; //a steady tone is only a candidate again once it is 6 dB louder
+		int missed_frames{ 0 };
+		bool seen{ false };
+
+	};
+
+	struct WindowLevel
+	{
+
+		double seconds{ 0.0 };
+		float level_dB{ -200.0f };
+		float tonality_dB{ 0.0f };
+
+	};
+
+	struct Candidate
+	{
+
+		int track_id{ 0 }; //0 = free
+		float frequency{ 0.0f };
+		float detector_frequency{ 0.0f }; //the frequency the detector was last given
+		WindowLevel windows[window_history];
+		int num_windows{ 0 };
+		int windows_measured{ 0 };
+		int next_window_slot{ 0 };
+		float growth{ 0.0f };
+		float fit{ 0.0f };
+		bool confirmed{ false };
+
+	};
+
+	std::vector<TrackHistory> track_histories;
+	Candidate candidates[max_candidates];
+	int64_t next_window{ 0 };
+	double goertzel_bandwidth{ 50.0 }; //Hz, one bin of the detector's window
+
+	std::vector<FeedbackReport> reports;
+
+	FeedbackConfirmation confirmations[max_confirmations];
+	int64_t num_confirmations{ 0 };
+
+	void update_track_histories(const std::vector<float> &amplitudes, const std::vector<float> &frequencies, double frame_seconds) {
+
+		const std::vector<SpectralPeakTrack> &tracks = peak_tracker.get_tracks();
+
+		for (int history = 0; history < track_histories.size(); history++) {
+
+			track_histories[history].seen = false;
+
+		}
+
+		for (int track = 0; track < tracks.size(); track++) {
+
+			if (!tracks[track].matched) {
+
+				continue;
+
+			}
+
+			TrackHistory* history = find_history(tracks[track].id);
+
+			if (history == nullptr) {
+
+				TrackHistory new_history;
+
+				new_history.track_id = tracks[track].id;
+
+				track_histories.push_back(new_history);
+
+				history = &track_histories.back();
+
+			}
+
+			history->seconds[history->next_slot] = frame_seconds;
+			history->levels_dB[history->next_slot] = tracks[track].level_dB;
+			history->next_slot = (history->next_slot + 1) % frame_history;
+			history->num_frames = std::min(history->num_frames + 1, (int)frame_history);
+			history->missed_frames = 0;
+			history->seen = true;
+
+			history->peak_to_average_dB = get_peak_to_average(amplitudes, frequencies, tracks[track].frequency, tracks[track].level_dB);
+
+			float fit;
+
+			history->growth = fit_growth(history->seconds, history->levels_dB, history->num_frames, history->next_slot, frame_history, fit);
+
+		}
+
+		//a peak that drops below the others for a frame or two keeps its history, tracks that have ended drop it
+
+		int kept = 0;
+
+		for (int history = 0; history < track_histories.size(); history++) {
+
+			if (!track_histories[history].seen) {
+
+				track_histories[history].missed_frames++;
+
+			}
+
+			if (track_histories[history].missed_frames <= max_missed_frames && find_track(track_histories[history].track_id) != nullptr) {
+
+				track_histories[kept++] = track_histories[history];
+
+			}
+
+		}
+
+		track_histories.resize(kept);
+
+	}
+
+	TrackHistory* find_history(int track_id) {
+
+		for (int history = 0; history < track_histories.size(); history++) {
+
+			if (track_histories[history].track_id == track_id) {
+
+				return &track_histories[history];
+
+			}
+
+		}
+
+		return nullptr;
+
+	}
+
+	const SpectralPeakTrack* find_track(int track_id) const {
+
+		const std::vector<SpectralPeakTrack> &tracks = peak_tracker.get_tracks();
+
+		for (int track = 0; track < tracks.size(); track++) {
+
+			if (tracks[track].id == track_id) {
+
+				return &tracks[track];
+
+			}
+
+		}
+
+		return nullptr;
+
+	}
+
+	bool update_candidates() { //returns true if the detector needs new frequencies
+
+		bool changed = false;
+
+		//candidates whose peak has gone, or no longer stands out, are dropped
+
+		for (int candidate = 0; candidate < max_candidates; candidate++) {
+
+			Candidate &state = candidates[candidate];
+
+			if (state.track_id == 0) {
+
+				continue;
+
+			}
+
+			const SpectralPeakTrack* track = find_track(state.track_id);
+			TrackHistory* history = find_history(state.track_id);
+
+			if (track == nullptr || history == nullptr || history->peak_to_average_dB < keep_peak_to_average_dB) {
+
+				state = Candidate();
+
+				changed = true;
+
+				continue;
+
+			}
+
+			if (!state.confirmed && state.windows_measured >= give_up_windows && state.num_windows >= confirmation_windows && state.growth < min_growth) { //a steady tone
+
+				history->rejected_level_dB = track->level_dB;
+
+				state = Candidate();
+
+				changed = true;
+
+				continue;
+
+			}
+
+			state.frequency = track->frequency;
+
+			if (std::abs(state.frequency - state.detector_frequency) > goertzel_bandwidth * retune_fraction) { //drifted
+
+				state.detector_frequency = state.frequency;
+
+				//windows at the old frequency read lower the further it drifted, so the fit starts again at the new one
+
+				state.num_windows = 0;
+				state.next_window_slot = 0;
+				state.growth = 0.0f;
+				state.fit = 0.0f;
+
+				changed = true;
+
+			}
+
+		}
+
+		//then free slots take the fastest growing new peaks
+
+		while (true) {
+
+			int free_slot = -1;
+
+			for (int candidate = 0; candidate < max_candidates && free_slot < 0; candidate++) {
+
+				if (candidates[candidate].track_id == 0) { free_slot = candidate; }
+
+			}
+
+			if (free_slot < 0) {
+
+				break;
+
+			}
+
+			const TrackHistory* best = nullptr;
+
+			for (int history = 0; history < track_histories.size(); history++) {
+
+				const TrackHistory &track_history = track_histories[history];
+
+				float level_dB = track_history.levels_dB[(track_history.next_slot - 1 + frame_history) % frame_history];
+
+				if (track_history.missed_frames > 0 || track_history.num_frames < 4 || track_history.peak_to_average_dB < min_peak_to_average_dB || track_history.growth < min_growth
+					|| level_dB < track_history.rejected_level_dB + 6.0f || is_candidate(track_history.track_id)) {
+
+					continue;
+
+				}
+
+				if (best == nullptr || track_history.growth > best->growth) {
+
+					best = &track_history;
+
+				}
+
+			}
+
+			if (best == nullptr) {
+
+				break;
+
+			}
+
+			Candidate &state = candidates[free_slot];
+
+			state = Candidate();
+
+			state.track_id = best->track_id;
+			state.frequency = find_track(best->track_id)->frequency;
+			state.detector_frequency = state.frequency;
+
+			changed = true;
+
+		}
+
+		return changed;
+
+	}
+
+	bool is_candidate(int track_id) const {
+
+		for (int candidate = 0; candidate < max_candidates; candidate++) {
+
+			if (candidates[candidate].track_id == track_id) {
+
+				return true;
+
+			}
+
+		}
+
+		return false;
+
+	}
+
+	void check_confirmation(Candidate &state, int64_t end_sample) {
+
+		if (state.num_windows < confirmation_windows) {
+
+			return;
+
+		}
+
+		double seconds[window_history];
+		float levels_dB[window_history];
+		float tonality_dB = 0.0f;
+
+		for (int window = 0; window < state.num_windows; window++) {
+
+			const WindowLevel &level = state.windows[(state.next_window_slot - state.num_windows + window + window_history) % window_history];
+
+			seconds[window] = level.seconds;
+			levels_dB[window] = level.level_dB;
+
+			tonality_dB += level.tonality_dB / state.num_windows;
+
+		}
+
+		state.growth = fit_growth(seconds, levels_dB, state.num_windows, state.num_windows, window_history, state.fit);
+
+		if (!state.confirmed && state.growth >= min_growth && state.fit >= min_fit && tonality_dB >= min_tonality_dB) {
+
+			state.confirmed = true;
+
+			FeedbackConfirmation &confirmation = confirmations[num_confirmations % max_confirmations];
+
+			confirmation.frequency = state.frequency;
+			confirmation.sample = end_sample;
+
+			num_confirmations++;
+
+		}
+
+	}
+
+	void update_reports() {
+
+		reports.clear();
+
+		for (int candidate = 0; candidate < max_candidates; candidate++) {
+
+			const Candidate &state = candidates[candidate];
+
+			if (state.track_id == 0) {
+
+				continue;
+
+			}
+
+			FeedbackReport report;
+
+			report.frequency = state.frequency;
+			report.confirmed = state.confirmed;
+
+			if (state.num_windows > 0) {
+
+				report.level_dB = state.windows[(state.next_window_slot - 1 + window_history) % window_history].level_dB;
+
+			}
+
+			else { //the detector has not measured it yet, the analysis frames say how it is growing
+
+				const TrackHistory* history = find_history(state.track_id);
+				const SpectralPeakTrack* track = find_track(state.track_id);
+
+				report.level_dB = track != nullptr ? track->level_dB : report.level_dB;
+				report.growth_dB_per_second = history != nullptr ? history->growth : 0.0f;
+
+			}
+
+			if (state.num_windows >= confirmation_windows) {
+
+				report.growth_dB_per_second = state.growth;
+
+			}
+
+			if (report.growth_dB_per_second > 0.0f) {
+
+				report.seconds_to_threshold = std::max(0.0f, (threshold - report.level_dB) / report.growth_dB_per_second);
+
+			}
+
+			reports.push_back(report);
+
+		}
+
+	}
+
+	static float get_peak_to_average(const std::vector<float> &amplitudes, const std::vector<float> &frequencies, float frequency, float level_dB) {
+
+		//against the mean power of the bins 4 to 20 either side, clear of a Hann window's main lobe
+
+		int bin = (int)(std::lower_bound(frequencies.begin(), frequencies.end(), frequency) - frequencies.begin());
+
+		double power = 0.0;
+		int count = 0;
+
+		for (int offset = 4; offset <= 20; offset++) {
+
+			if (bin - offset >= 0) { power += amplitudes[bin - offset] * amplitudes[bin - offset]; count++; }
+			if (bin + offset < (int)amplitudes.size()) { power += amplitudes[bin + offset] * amplitudes[bin + offset]; count++; }
+
+		}
+
+		return count > 0 && power > 0.0 ? level_dB - (float)(10.0 * log10(power / count)) : 0.0f;
+
+	}
+
+	static float fit_growth(const double* seconds, const float* levels_dB, int count, int next_slot, int ring_size, float &fit) {
+
+		//least squares slope of level against time, over the last count entries of a ring, with its r squared
+
+		fit = 0.0f;
+
+		if (count < 3) {
+
+			return 0.0f;
+
+		}
+
+		double mean_time = 0.0, mean_level = 0.0;
+
+		for (int entry = 0; entry < count; entry++) {
+
+			int slot = (next_slot - count + entry + ring_size) % ring_size;
+
+			mean_time += seconds[slot] / count;
+			mean_level += levels_dB[slot] / count;
+
+		}
+
+		double covariance = 0.0, time_variance = 0.0, level_variance = 0.0;
+
+		for (int entry = 0; entry < count; entry++) {
+
+			int slot = (next_slot - count + entry + ring_size) % ring_size;
+
+			double time = seconds[slot] - mean_time;
+			double level = levels_dB[slot] - mean_level;
+
+			covariance += time * level;
+			time_variance += time * time;
+			level_variance += level * level;
+
+		}
+
+		if (time_variance <= 0.0) {
+
+			return 0.0f;
+
+		}
+
+		fit = level_variance > 0.0 ? (float)((covariance * covariance) / (time_variance * level_variance)) : 0.0f;
+
+		return (float)(covariance / time_variance);
+
+	}
+
+	static float amplitude_to_dB(float amplitude) { return amplitude > 0.0f ? 20.0f * log10f(amplitude) : -200.0f; }
+
+};
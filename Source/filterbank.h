@@ -0,0 +1,209 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+ #include <xmmintrin.h>
+ #define SOUNDVIEW_FILTERBANK_SSE 1
+#endif
+
+//Perceptual frequency scales and the triangular filterbanks that project an FFT power spectrum onto them. Band centres
+//are equally spaced on the chosen scale. Each band is a triangle reaching from the previous centre to the next, but
+//never narrower than one FFT bin each side. The weights are built once per FFT size, sample rate and band layout.
+//They are stored as a sparse matrix whose rows are contiguous runs of FFT bins, so a band is one SIMD dot product.
+//Weights are scaled so that a sine at a band centre reads its own amplitude.
+
+enum FrequencyScale { log_scale = 0, mel_scale, bark_scale, erb_scale, num_frequency_scales };
+
+inline double frequency_to_scale(FrequencyScale scale, double frequency) {
+
+	switch (scale)
+	{
+	case mel_scale: return 2595.0 * log10(1.0 + frequency / 700.0); //O'Shaughnessy / HTK
+	case bark_scale: return (26.81 * frequency) / (1960.0 + frequency) - 0.53; //Traunmuller
+	case erb_scale: return 21.4 * log10(1.0 + 0.00437 * frequency); //Glasberg and Moore ERB-rate
+	default: return log10(frequency);
+	}
+
+}
+
+inline double scale_to_frequency(FrequencyScale scale, double value) {
+
+	switch (scale)
+	{
+	case mel_scale: return 700.0 * (pow(10.0, value / 2595.0) - 1.0);
+	case bark_scale: return (1960.0 * (value + 0.53)) / (26.28 - value);
+	case erb_scale: return (pow(10.0, value / 21.4) - 1.0) / 0.00437;
+	default: return pow(10.0, value);
+	}
+
+}
+
+inline const char* get_frequency_scale_name(FrequencyScale scale) {
+
+	switch (scale)
+	{
+	case mel_scale: return "Mel";
+	case bark_scale: return "Bark";
+	case erb_scale: return "ERB";
+	default: return "Log";
+	}
+
+}
+
+class Filterbank
+{
+public:
+
+	Filterbank() {};
+
+	~Filterbank() {};
+
+	//centre_frequencies in Hz, ascending and equally spaced on scale
+
+	void build(FrequencyScale scale, int fft_size, double sample_rate, const std::vector<float> &centre_frequencies) {
+
+		num_bands = (int)centre_frequencies.size();
+		num_fft_bins = fft_size / 2 + 1;
+
+		double bin_spacing = sample_rate / fft_size;
+
+		row_offsets.assign(1, 0);
+		column_indices.clear();
+		weights.clear();
+
+		power_spectrum.resize(num_fft_bins);
+
+		double step = num_bands > 1 ? (frequency_to_scale(scale, centre_frequencies.back()) - frequency_to_scale(scale, centre_frequencies.front())) / (num_bands - 1) : 1.0;
+
+		for (int band = 0; band < num_bands; band++) {
+
+			double centre = centre_frequencies[band];
+			double scaled_centre = frequency_to_scale(scale, centre);
+
+			double lower_width = std::max(bin_spacing, centre - scale_to_frequency(scale, scaled_centre - step));
+			double upper_width = std::max(bin_spacing, scale_to_frequency(scale, scaled_centre + step) - centre);
+
+			int first_column = std::max(0, (int)ceil((centre - lower_width) / bin_spacing));
+			int last_column = std::min(num_fft_bins - 1, (int)floor((centre + upper_width) / bin_spacing));
+
+			double tone_response = 0.0; //what a bin centred sine at the band centre would sum to
+
+			int row_start = (int)weights.size();
+
+			for (int column = first_column; column <= last_column; column++) {
+
+				double offset = column * bin_spacing - centre;
+				double weight = 1.0 - fabs(offset) / (offset < 0.0 ? lower_width : upper_width);
+
+				double window_response = get_hann_response(offset / bin_spacing);
+
+				tone_response += weight * window_response * window_response;
+
+				column_indices.push_back(column);
+				weights.push_back((float)weight);
+
+			}
+
+			for (int x = row_start; x < weights.size() && tone_response > 0.0; x++) {
+
+				weights[x] = (float)(weights[x] / tone_response);
+
+			}
+
+			row_offsets.push_back((int)column_indices.size());
+
+		}
+
+	}
+
+	int get_num_bands() const { return num_bands; }
+
+	int get_num_nonzero() const { return (int)weights.size(); }
+
+	//spectrum is fft::fftw_complex_out (normalised by the FFT size), amplitudes receives one linear value per band on
+	//the same scale as AnalysisEngine's FFT bins
+
+	void process(const std::vector<std::vector<double>> &spectrum, double amplitude_scaling, std::vector<float> &amplitudes) {
+
+		double power_scaling = amplitude_scaling * amplitude_scaling;
+
+		for (int column = 0; column < num_fft_bins; column++) {
+
+			power_spectrum[column] = (float)((spectrum[0][column] * spectrum[0][column] + spectrum[1][column] * spectrum[1][column]) * power_scaling);
+
+		}
+
+		amplitudes.resize(num_bands);
+
+		for (int band = 0; band < num_bands; band++) {
+
+			int start = row_offsets[band];
+			int length = row_offsets[band + 1] - start;
+
+			amplitudes[band] = length > 0 ? sqrtf(dot_product(&weights[start], &power_spectrum[column_indices[start]], length)) : 0.0f;
+
+		}
+
+	}
+
+	static float dot_product(const float* a, const float* b, int length) {
+
+		int x = 0;
+		float sum = 0.0f;
+
+#if SOUNDVIEW_FILTERBANK_SSE
+
+		__m128 lanes_sum = _mm_setzero_ps();
+
+		for (; x + 4 <= length; x += 4) {
+
+			lanes_sum = _mm_add_ps(lanes_sum, _mm_mul_ps(_mm_loadu_ps(a + x), _mm_loadu_ps(b + x)));
+
+		}
+
+		float lanes[4];
+
+		_mm_storeu_ps(lanes, lanes_sum);
+
+		sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+
+#endif
+
+		for (; x < length; x++) {
+
+			sum += a[x] * b[x];
+
+		}
+
+		return sum;
+
+	}
+
+private:
+
+	int num_bands{ 0 };
+	int num_fft_bins{ 0 };
+
+	std::vector<int> row_offsets; //num_bands + 1, band b is [row_offsets[b], row_offsets[b + 1])
+	std::vector<int> column_indices; //FFT bins, contiguous within a row
+	std::vector<float> weights;
+
+	std::vector<float> power_spectrum;
+
+	static double get_hann_response(double offset_bins) { //relative amplitude of a Hann windowed sine offset_bins from a bin
+
+		double x = fabs(offset_bins);
+
+		if (x < 1.0e-9) return 1.0;
+		if (fabs(x - 1.0) < 1.0e-9) return 0.5;
+
+		double pi = 3.141592653589793;
+
+		return fabs(sin(pi * x) / (pi * x * (1.0 - x * x)));
+
+	}
+
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+//A log spaced frequency grid that does not move with the display. Statistics kept per frequency over minutes or hours
+//(the percentile spectra, the spectrogram noise floors) are fed through it, so changing the frequency scale, constant-Q
+//or the RTA resolution only changes the values arriving at each grid frequency and never the bins themselves.
+//resample() interpolates a dBFS row linearly in log frequency, and copies it unchanged when its frequencies already are
+//the grid (the log scale spectrogram row). Nothing is allocated per frame.
+
+class FixedFrequencyGrid
+{
+public:
+
+	FixedFrequencyGrid(int num_frequencies, float lowest_frequency, float highest_frequency) {
+
+		frequencies.resize(num_frequencies);
+		resampled_dB.resize(num_frequencies);
+
+		double log_lowest = log(lowest_frequency);
+		double log_step = (log(highest_frequency) - log_lowest) / (num_frequencies - 1.0);
+
+		for (int x = 0; x < num_frequencies; x++) {
+
+			frequencies[x] = (float)exp(log_lowest + log_step * x);
+
+		}
+
+	};
+
+	~FixedFrequencyGrid() {};
+
+	const std::vector<float>& resample(const std::vector<float> &levels_dB, const std::vector<float> &row_frequencies) { //ascending frequencies
+
+		int num_points = (int)std::min(levels_dB.size(), row_frequencies.size());
+
+		if (num_points == 0) {
+
+			std::fill(resampled_dB.begin(), resampled_dB.end(), -100.0f);
+
+			return resampled_dB;
+
+		}
+
+		if (is_grid(row_frequencies) && num_points == (int)frequencies.size()) {
+
+			std::copy(levels_dB.begin(), levels_dB.begin() + num_points, resampled_dB.begin());
+
+			return resampled_dB;
+
+		}
+
+		int point = 0;
+
+		for (int x = 0; x < frequencies.size(); x++) {
+
+			float frequency = frequencies[x];
+
+			while (point + 1 < num_points && row_frequencies[point + 1] < frequency) {
+
+				point++;
+
+			}
+
+			if (point + 1 >= num_points || frequency <= row_frequencies[point]) { //beyond either end, the end value
+
+				resampled_dB[x] = levels_dB[point];
+
+				continue;
+
+			}
+
+			float fraction = logf(frequency / row_frequencies[point]) / logf(row_frequencies[point + 1] / row_frequencies[point]);
+
+			resampled_dB[x] = levels_dB[point] + (levels_dB[point + 1] - levels_dB[point]) * fraction;
+
+		}
+
+		return resampled_dB;
+
+	}
+
+	const std::vector<float>& get_frequencies() const { return frequencies; }
+
+	int get_num_frequencies() const { return (int)frequencies.size(); }
+
+private:
+
+	std::vector<float> frequencies;
+	std::vector<float> resampled_dB;
+
+	bool is_grid(const std::vector<float> &row_frequencies) const {
+
+		if (row_frequencies.size() != frequencies.size()) {
+
+			return false;
+
+		}
+
+		for (int x = 0; x < frequencies.size(); x++) {
+
+			if (std::abs(row_frequencies[x] - frequencies[x]) > frequencies[x] * 1.0e-4f) {
+
+				return false;
+
+			}
+
+		}
+
+		return true;
+
+	}
+
+};
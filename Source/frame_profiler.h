@@ -0,0 +1,386 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdint>
+
+//Scoped timers for the stages of the analysis and render pipeline. Put SOUNDVIEW_PROFILE_SCOPE("stage name") at the
+//top of a block. While the profiler is enabled, the block's start and duration are written to a ring buffer owned by
+//the calling thread. Only that thread writes its buffer, so recording takes no locks. Readers copy the rings to get
+//per-stage statistics or a Chrome trace (load the JSON in chrome://tracing or Perfetto). When disabled at run time a
+//scope costs one relaxed atomic load. Building with SOUNDVIEW_ENABLE_PROFILER=0 removes the scopes entirely.
+//Stage names must be string literals, because only the pointer is stored.
+
+#ifndef SOUNDVIEW_ENABLE_PROFILER
+ #define SOUNDVIEW_ENABLE_PROFILER 1
+#endif
+
+struct ProfileEvent
+{
+
+	const char* name;
+	int64_t start_ns; //since the profiler epoch
+	int64_t duration_ns;
+
+};
+
+struct ProfileStageStats
+{
+
+	std::string name;
+	int64_t count{ 0 };
+	double mean_ms{ 0.0 };
+	double max_ms{ 0.0 };
+
+};
+
+class FrameProfiler
+{
+public:
+
+	typedef std::chrono::steady_clock clock;
+
+	static FrameProfiler& get_instance() {
+
+		static FrameProfiler profiler;
+
+		return profiler;
+
+	}
+
+	void set_enabled(bool should_be_enabled) { enabled.store(should_be_enabled, std::memory_order_relaxed); }
+
+	bool is_enabled() const { return enabled.load(std::memory_order_relaxed); }
+
+	int64_t get_time_ns() const { return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - epoch).count(); }
+
+	void record(const char* name, int64_t start_ns, int64_t duration_ns) {
+
+		ThreadBuffer* buffer = get_thread_buffer();
+
+		uint64_t position = buffer->write_position.load(std::memory_order_relaxed);
+
+		buffer->events[position & (events_per_thread - 1)] = { name, start_ns, duration_ns };
+
+		buffer->write_position.store(position + 1, std::memory_order_release);
+
+	}
+
+	void set_thread_name(const std::string &name) { //optional, labels the calling thread in the trace
+
+		get_thread_buffer();
+
+		std::lock_guard<std::mutex> registry_lock(registry_mtx);
+
+		thread_names[std::this_thread::get_id()] = name;
+
+	}
+
+	//A real time thread must never allocate or lock, so its buffer is made in advance by another thread, e.g. from
+	//prepareToPlay, and the real time thread takes it with claim_reserved_thread_buffer() before its first scope. Only one
+	//buffer is held in reserve, reserving again while it is unclaimed does nothing.
+
+	void reserve_thread_buffer(const std::string &name) {
+
+		if (reserved_buffer.load() != nullptr) {
+
+			return;
+
+		}
+
+		std::unique_ptr<ThreadBuffer> new_buffer(new ThreadBuffer());
+
+		new_buffer->name = name;
+		new_buffer->events.resize(events_per_thread);
+
+		ThreadBuffer* buffer = new_buffer.get();
+
+		{
+			std::lock_guard<std::mutex> registry_lock(registry_mtx);
+
+			thread_buffers.push_back(std::move(new_buffer));
+		}
+
+		reserved_buffer.store(buffer);
+
+	}
+
+	bool claim_reserved_thread_buffer() { //lock free, false if nothing was reserved or this thread already has a buffer
+
+		ThreadBuffer* &thread_buffer = get_thread_buffer_slot();
+
+		if (thread_buffer != nullptr) {
+
+			return false;
+
+		}
+
+		thread_buffer = reserved_buffer.exchange(nullptr);
+
+		return thread_buffer != nullptr;
+
+	}
+
+	//Mean and max duration of each stage over the last window_seconds, across all threads, in first seen order
+
+	std::vector<ProfileStageStats> get_stage_stats(double window_seconds) {
+
+		int64_t window_start_ns = get_time_ns() - (int64_t)(window_seconds * 1.0e9);
+
+		std::vector<ProfileStageStats> stats;
+		std::map<const char*, int> stage_index;
+
+		std::vector<ThreadEvents> threads = copy_events();
+
+		for (int thread = 0; thread < threads.size(); thread++) {
+
+			for (int x = 0; x < threads[thread].events.size(); x++) {
+
+				const ProfileEvent &event = threads[thread].events[x];
+
+				if (event.start_ns < window_start_ns) continue;
+
+				auto existing = stage_index.find(event.name);
+
+				if (existing == stage_index.end()) {
+
+					existing = stage_index.insert({ event.name, (int)stats.size() }).first;
+
+					stats.push_back(ProfileStageStats());
+					stats.back().name = event.name;
+
+				}
+
+				ProfileStageStats &stage = stats[existing->second];
+
+				double duration_ms = event.duration_ns * 1.0e-6;
+
+				stage.mean_ms += duration_ms; //summed here, divided below
+				stage.max_ms = std::max(stage.max_ms, duration_ms);
+				stage.count++;
+
+			}
+
+		}
+
+		for (int x = 0; x < stats.size(); x++) {
+
+			stats[x].mean_ms /= stats[x].count;
+
+		}
+
+		return stats;
+
+	}
+
+	//Every event still held in the per-thread rings as Chrome trace event JSON. extra_events are appended as
+	//already formatted trace events (without a trailing comma), so other modules can add counters.
+
+	void write_chrome_trace(std::ostream &output, const std::vector<std::string> &extra_events = std::vector<std::string>()) {
+
+		std::vector<ThreadEvents> threads = copy_events();
+
+		std::ios::fmtflags previous_flags = output.flags();
+		std::streamsize previous_precision = output.precision();
+
+		output << std::fixed << std::setprecision(3); //microseconds with ns resolution, never in exponent form
+
+		output << "{\"traceEvents\":[\n";
+
+		bool first_event = true;
+
+		for (int thread = 0; thread < threads.size(); thread++) {
+
+			if (!first_event) output << ",\n";
+			first_event = false;
+
+			output	<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread + 1
+					<< ",\"args\":{\"name\":\"" << threads[thread].name << "\"}}";
+
+			for (int x = 0; x < threads[thread].events.size(); x++) {
+
+				const ProfileEvent &event = threads[thread].events[x];
+
+				output	<< ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread + 1
+						<< ",\"ts\":" << event.start_ns / 1000.0 << ",\"dur\":" << event.duration_ns / 1000.0 << "}";
+
+			}
+
+		}
+
+		for (int x = 0; x < extra_events.size(); x++) {
+
+			if (!first_event) output << ",\n";
+			first_event = false;
+
+			output << extra_events[x];
+
+		}
+
+		output << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+		output.flags(previous_flags);
+		output.precision(previous_precision);
+
+	}
+
+private:
+
+	static const int events_per_thread = 8192; //must be a power of two, ~4 minutes of frames at 30 Hz and 10 stages
+
+	struct ThreadBuffer
+	{
+
+		std::thread::id thread_id;
+		std::string name; //set when reserved, otherwise the name comes from thread_names
+		std::vector<ProfileEvent> events;
+		std::atomic<uint64_t> write_position{ 0 };
+
+	};
+
+	struct ThreadEvents
+	{
+
+		std::string name;
+		std::vector<ProfileEvent> events;
+
+	};
+
+	std::atomic<bool> enabled{ false };
+	clock::time_point epoch{ clock::now() };
+
+	std::mutex registry_mtx; //guards the buffer list and names, taken once per thread and when reading
+	std::vector<std::unique_ptr<ThreadBuffer>> thread_buffers;
+	std::map<std::thread::id, std::string> thread_names;
+	std::atomic<ThreadBuffer*> reserved_buffer{ nullptr }; //owned by thread_buffers
+
+	FrameProfiler() {};
+
+	static ThreadBuffer* &get_thread_buffer_slot() {
+
+		static thread_local ThreadBuffer* thread_buffer = nullptr;
+
+		return thread_buffer;
+
+	}
+
+	ThreadBuffer* get_thread_buffer() {
+
+		ThreadBuffer* &thread_buffer = get_thread_buffer_slot();
+
+		if (thread_buffer == nullptr) { //first event from this thread
+
+			std::unique_ptr<ThreadBuffer> new_buffer(new ThreadBuffer());
+
+			new_buffer->thread_id = std::this_thread::get_id();
+			new_buffer->events.resize(events_per_thread);
+
+			thread_buffer = new_buffer.get();
+
+			std::lock_guard<std::mutex> registry_lock(registry_mtx);
+
+			thread_buffers.push_back(std::move(new_buffer));
+
+		}
+
+		return thread_buffer;
+
+	}
+
+	std::vector<ThreadEvents> copy_events() {
+
+		std::lock_guard<std::mutex> registry_lock(registry_mtx);
+
+		std::vector<ThreadEvents> threads(thread_buffers.size());
+
+		for (int thread = 0; thread < thread_buffers.size(); thread++) {
+
+			ThreadBuffer &buffer = *thread_buffers[thread];
+
+			if (!buffer.name.empty()) {
+
+				threads[thread].name = buffer.name;
+
+			}
+
+			else {
+
+				auto name = thread_names.find(buffer.thread_id);
+
+				threads[thread].name = name != thread_names.end() ? name->second : "Thread " + std::to_string(thread + 1);
+
+			}
+
+			uint64_t end = buffer.write_position.load(std::memory_order_acquire);
+			uint64_t begin = end > events_per_thread ? end - events_per_thread : 0;
+
+			for (uint64_t position = begin; position < end; position++) {
+
+				threads[thread].events.push_back(buffer.events[position & (events_per_thread - 1)]);
+
+			}
+
+			//the owning thread may have overwritten the oldest slots while they were copied, so drop those. record()
+			//writes the slot for end_after_copy before it publishes it, so that slot may be half written too
+
+			uint64_t end_after_copy = buffer.write_position.load(std::memory_order_acquire);
+			uint64_t overwritten = end_after_copy + 1 > begin + events_per_thread ? end_after_copy + 1 - (begin + events_per_thread) : 0;
+
+			threads[thread].events.erase(threads[thread].events.begin(), threads[thread].events.begin() + std::min<uint64_t>(overwritten, threads[thread].events.size()));
+
+		}
+
+		return threads;
+
+	}
+
+};
+
+class ProfileScope
+{
+public:
+
+	ProfileScope(const char* stage_name) :
+		name(stage_name),
+		active(FrameProfiler::get_instance().is_enabled())
+	{
+		if (active) start_ns = FrameProfiler::get_instance().get_time_ns();
+	};
+
+	~ProfileScope() {
+
+		if (active) {
+
+			FrameProfiler &profiler = FrameProfiler::get_instance();
+
+			profiler.record(name, start_ns, profiler.get_time_ns() - start_ns);
+
+		}
+
+	};
+
+private:
+
+	const char* name;
+	bool active;
+	int64_t start_ns{ 0 };
+
+};
+
+#define SOUNDVIEW_PROFILE_CONCATENATE_INNER(a, b) a##b
+#define SOUNDVIEW_PROFILE_CONCATENATE(a, b) SOUNDVIEW_PROFILE_CONCATENATE_INNER(a, b)
+
+#if SOUNDVIEW_ENABLE_PROFILER
+ #define SOUNDVIEW_PROFILE_SCOPE(stage_name) ProfileScope SOUNDVIEW_PROFILE_CONCATENATE(profile_scope_, __LINE__)(stage_name)
+#else
+ #define SOUNDVIEW_PROFILE_SCOPE(stage_name)
+#endif
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+//A log bucketed (HDR style) histogram of durations. Values are kept in whole microseconds. Below 32 us every value
+//has its own bucket, and above that each power of two is split into 32 buckets, so any recorded value is known to
+//within about 3% up to roughly a minute. record() is lock free and can be called from the audio thread. Percentiles
+//can be read from any other thread while recording continues.
+
+class LatencyHistogram
+{
+public:
+
+	LatencyHistogram() :
+		bucket_counts(num_buckets)
+	{
+		reset();
+	};
+
+	~LatencyHistogram() {};
+
+	void reset() { //not safe to call while another thread is recording
+
+		for (int x = 0; x < num_buckets; x++) {
+
+			bucket_counts[x].store(0);
+
+		}
+
+		total_count.store(0);
+		max_microseconds.store(0);
+
+	}
+
+	void record(double seconds) {
+
+		uint64_t microseconds = seconds > 0.0 ? (uint64_t)(seconds * 1.0e6 + 0.5) : 0;
+
+		bucket_counts[get_bucket(microseconds)].fetch_add(1, std::memory_order_relaxed);
+
+		total_count.fetch_add(1, std::memory_order_relaxed);
+
+		uint64_t previous_max = max_microseconds.load(std::memory_order_relaxed);
+
+		while (microseconds > previous_max && !max_microseconds.compare_exchange_weak(previous_max, microseconds, std::memory_order_relaxed)) {}
+
+	}
+
+	int64_t get_count() const { return total_count.load(std::memory_order_relaxed); }
+
+	double get_max() const { return max_microseconds.load(std::memory_order_relaxed) * 1.0e-6; }
+
+	double get_percentile(double percentile) const { //seconds, as the upper edge of the bucket holding the percentile
+
+		int64_t count = 0;
+
+		std::vector<int64_t> counts(num_buckets);
+
+		for (int x = 0; x < num_buckets; x++) { //snapshot first, so the total matches the buckets walked below
+
+			counts[x] = bucket_counts[x].load(std::memory_order_relaxed);
+			count += counts[x];
+
+		}
+
+		if (count == 0) {
+
+			return 0.0;
+
+		}
+
+		int64_t target = (int64_t)std::ceil(count * (percentile / 100.0));
+
+		if (target < 1) target = 1;
+
+		int64_t running_count = 0;
+
+		for (int x = 0; x < num_buckets; x++) {
+
+			running_count += counts[x];
+
+			if (running_count >= target) {
+
+				return std::fmin(get_bucket_upper_edge(x), (double)max_microseconds.load(std::memory_order_relaxed)) * 1.0e-6;
+
+			}
+
+		}
+
+		return get_max();
+
+	}
+
+private:
+
+	static const int sub_bucket_bits = 5;
+	static const int sub_buckets = 1 << sub_bucket_bits;
+	static const int num_octaves = 26; //2^26 us = 67 s
+	static const int num_buckets = sub_buckets + (num_octaves - sub_bucket_bits) * sub_buckets;
+
+	std::vector<std::atomic<int64_t>> bucket_counts;
+	std::atomic<int64_t> total_count;
+	std::atomic<uint64_t> max_microseconds;
+
+	static int get_bucket(uint64_t microseconds) {
+
+		if (microseconds < sub_buckets) {
+
+			return (int)microseconds;
+
+		}
+
+		int octave = sub_bucket_bits;
+
+		while ((microseconds >> (octave + 1)) != 0 && octave < num_octaves - 1) {
+
+			octave++;
+
+		}
+
+		int shift = octave - sub_bucket_bits;
+		int sub_bucket = (int)std::min<uint64_t>((microseconds >> shift) - sub_buckets, sub_buckets - 1);
+
+		return sub_buckets + (shift * sub_buckets) + sub_bucket;
+
+	}
+
+	static double get_bucket_upper_edge(int bucket) { //microseconds
+
+		if (bucket < sub_buckets) {
+
+			return bucket;
+
+		}
+
+		int shift = (bucket - sub_buckets) / sub_buckets;
+		int sub_bucket = (bucket - sub_buckets) % sub_buckets;
+
+		return std::ldexp((double)(sub_buckets + sub_bucket + 1), shift) - 1.0;
+
+	}
+
+};
+
+struct CallbackTimingSummary
+{
+
+	int64_t num_callbacks{ 0 };
+	double buffer_period{ 0.0 }; //seconds
+
+	double duration_p50{ 0.0 }, duration_p99{ 0.0 }, duration_p999{ 0.0 }, duration_max{ 0.0 };
+	double jitter_p50{ 0.0 }, jitter_p99{ 0.0 }, jitter_p999{ 0.0 }, jitter_max{ 0.0 };
+
+	double get_percent_of_period(double seconds) const { return buffer_period > 0.0 ? (seconds / buffer_period) * 100.0 : 0.0; }
+
+};
+
+//Times every audio callback: how long it ran, and how far its start was from one buffer period after the previous
+//start (the inter-arrival jitter). Call prepare() while the device is stopped, callback_finished() at the end of
+//each callback, and get_summary() from the GUI.
+
+class CallbackTimingMonitor
+{
+public:
+
+	typedef std::chrono::high_resolution_clock clock;
+
+	CallbackTimingMonitor() {};
+
+	~CallbackTimingMonitor() {};
+
+	void prepare(double sample_rate, int expected_block_size) {
+
+		active_sample_rate = sample_rate;
+		buffer_period.store(expected_block_size / sample_rate);
+
+		duration_histogram.reset();
+		jitter_histogram.reset();
+
+		has_previous_start = false;
+
+	}
+
+	void callback_finished(clock::time_point start, clock::time_point end, int num_samples) { //audio thread only
+
+		std::chrono::duration<double> duration = end - start;
+
+		duration_histogram.record(duration.count());
+
+		if (has_previous_start) {
+
+			std::chrono::duration<double> interval = start - previous_start;
+
+			jitter_histogram.record(std::fabs(interval.count() - previous_block_period));
+
+		}
+
+		previous_start = start;
+		previous_block_period = num_samples / active_sample_rate;
+		has_previous_start = true;
+
+	}
+
+	CallbackTimingSummary get_summary() const {
+
+		CallbackTimingSummary summary;
+
+		summary.num_callbacks = duration_histogram.get_count();
+		summary.buffer_period = buffer_period.load();
+
+		summary.duration_p50 = duration_histogram.get_percentile(50.0);
+		summary.duration_p99 = duration_histogram.get_percentile(99.0);
+		summary.duration_p999 = duration_histogram.get_percentile(99.9);
+		summary.duration_max = duration_histogram.get_max();
+
+		summary.jitter_p50 = jitter_histogram.get_percentile(50.0);
+		summary.jitter_p99 = jitter_histogram.get_percentile(99.0);
+		summary.jitter_p999 = jitter_histogram.get_percentile(99.9);
+		summary.jitter_max = jitter_histogram.get_max();
+
+		return summary;
+
+	}
+
+private:
+
+	LatencyHistogram duration_histogram, jitter_histogram;
+
+	std::atomic<double> buffer_period{ 0.0 };
+	double active_sample_rate{ 48000.0 };
+
+	//audio thread state
+
+	clock::time_point previous_start;
+	double previous_block_period{ 0.0 };
+	bool has_previous_start{ false };
+
+};
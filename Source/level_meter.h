@@ -0,0 +1,595 @@
+#pragma once
+
+#include <atomic>
+#include <limits>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+ #include <xmmintrin.h>
+ #define SOUNDVIEW_LEVEL_METER_SSE 1
+#endif
+
+//Sample peak, RMS and true peak of the captured channels. The audio callback only reduces each channel to raw
+//per period numbers (10 ms): the largest sample magnitude, the mean square, and the largest magnitude of the signal
+//oversampled 4x with the polyphase FIR of ITU-R BS.1770-4 Annex 2. The four phases of the FIR are the four lanes of
+//one SSE register, so every input sample costs 12 multiply-adds for all four interpolated values. Periods go into a
+//ring of atomics, and LevelMeterBallistics applies the meter ballistics on the reading thread, so the ballistics and
+//hold times can change without touching the audio thread. Overs are counted in the callback, once for samples at or
+//beyond full scale and once for interpolated values beyond it. Overs less than 1 ms apart are one over, so a clipped
+//passage counts once rather than once per cycle. process_block() never allocates or locks.
+
+class LevelMeter
+{
+public:
+
+	static const int max_channels = 2;
+	static const int ring_periods = 256; //2.56 s of periods, far more than a display frame
+
+	LevelMeter() {
+
+		for (int x = 0; x < ring_periods * max_channels; x++) {
+
+			period_peaks[x].store(0.0f);
+			period_true_peaks[x].store(0.0f);
+			period_mean_squares[x].store(0.0f);
+
+		}
+
+		reset();
+
+	};
+
+	~LevelMeter() {};
+
+	void set_sample_rate(double sample_rate) { //call while the audio callback is stopped, e.g. from prepareToPlay
+
+		samples_per_period = std::max(1, (int)(sample_rate * 0.01 + 0.5));
+		over_gap = std::max(1, (int)(sample_rate * 0.001));
+
+		period_seconds.store(samples_per_period / sample_rate);
+
+		reset();
+
+	}
+
+	void process_block(const float* const* channels, int num_channels, int num_samples) { //audio thread only
+
+		num_channels = std::min(num_channels, (int)max_channels);
+
+		active_channels.store(num_channels, std::memory_order_relaxed);
+
+		int offset = 0;
+
+		while (offset < num_samples) { //chunks that fit the staging buffer and end on period boundaries
+
+			int samples_to_process = std::min(std::min(num_samples - offset, samples_per_period - samples_in_period), (int)max_chunk_size);
+
+			for (int channel = 0; channel < num_channels; channel++) {
+
+				measure_chunk(channel_states[channel], channels[channel] + offset, samples_to_process);
+
+			}
+
+			offset += samples_to_process;
+			samples_in_period += samples_to_process;
+
+			if (samples_in_period == samples_per_period) {
+
+				publish_period(num_channels);
+
+			}
+
+		}
+
+		for (int channel = 0; channel < num_channels; channel++) {
+
+			sample_overs[channel].store(channel_states[channel].sample_overs, std::memory_order_relaxed);
+			true_peak_overs[channel].store(channel_states[channel].true_peak_overs, std::memory_order_relaxed);
+
+		}
+
+	}
+
+	//reader side, any single thread
+
+	int64_t get_completed_periods() const {
+
+		return completed_periods.load(std::memory_order_acquire);
+
+	}
+
+	void get_period(int64_t period, int channel, float &peak, float &true_peak, float &mean_square) const {
+
+		int slot = (int)(period % ring_periods) * max_channels + channel;
+
+		peak = period_peaks[slot].load(std::memory_order_relaxed);
+		true_peak = period_true_peaks[slot].load(std::memory_order_relaxed);
+		mean_square = period_mean_squares[slot].load(std::memory_order_relaxed);
+
+	}
+
+	double get_period_seconds() const { return period_seconds.load(); }
+
+	int get_num_channels() const { return active_channels.load(std::memory_order_relaxed); }
+
+	int64_t get_sample_overs(int channel) const { return sample_overs[channel].load(std::memory_order_relaxed); }
+
+	int64_t get_true_peak_overs(int channel) const { return true_peak_overs[channel].load(std::memory_order_relaxed); }
+
+private:
+
+	static const int num_taps = 12; //per phase, 48 in all
+	static const int max_chunk_size = 256;
+
+	struct ChannelState
+	{
+
+		float history[num_taps - 1]; //the last input samples, oldest first
+
+		float period_peak{ 0.0f };
+		float period_true_peak{ 0.0f };
+		double period_sum_squares{ 0.0 };
+
+		int samples_since_sample_over{ std::numeric_limits<int>::max() };
+		int samples_since_true_peak_over{ std::numeric_limits<int>::max() };
+		int64_t sample_overs{ 0 };
+		int64_t true_peak_overs{ 0 };
+
+	};
+
+	//ITU-R BS.1770-4 Annex 2, [tap][phase]: phase p of input sample n is the sum of coefficient[k][p] * x[n - k]
+
+	const float coefficients[num_taps][4] = {
+		{ 0.0017089843750f, -0.0291748046875f, -0.0189208984375f, -0.0083007812500f },
+		{ 0.0109863281250f, 0.0292968750000f, 0.0330810546875f, 0.0148925781250f },
+		{ -0.0196533203125f, -0.0517578125000f, -0.0582275390625f, -0.0266113281250f },
+		{ 0.0332031250000f, 0.0891113281250f, 0.1015625000000f, 0.0476074218750f },
+		{ -0.0594482421875f, -0.1665039062500f, -0.2003173828125f, -0.1022949218750f },
+		{ 0.1373291015625f, 0.4650878906250f, 0.7797851562500f, 0.9721679687500f },
+		{ 0.9721679687500f, 0.7797851562500f, 0.4650878906250f, 0.1373291015625f },
+		{ -0.1022949218750f, -0.2003173828125f, -0.1665039062500f, -0.0594482421875f },
+		{ 0.0476074218750f, 0.1015625000000f, 0.0891113281250f, 0.0332031250000f },
+		{ -0.0266113281250f, -0.0582275390625f, -0.0517578125000f, -0.0196533203125f },
+		{ 0.0148925781250f, 0.0330810546875f, 0.0292968750000f, 0.0109863281250f },
+		{ -0.0083007812500f, -0.0189208984375f, -0.0291748046875f, 0.0017089843750f }
+	};
+
+	const float full_scale = 1.0f;
+
+	//audio thread state
+
+	int samples_per_period{ 480 };
+	int over_gap{ 48 }; //samples below full scale that end an over
+	int samples_in_period{ 0 };
+
+	ChannelState channel_states[max_channels];
+
+	float staging[num_taps - 1 + max_chunk_size]; //history followed by the chunk, so the FIR never wraps
+
+	//published
+
+	std::atomic<double> period_seconds{ 0.01 };
+	std::atomic<int> active_channels{ 0 };
+	std::atomic<int64_t> completed_periods{ 0 };
+	std::atomic<float> period_peaks[ring_periods * max_channels];
+	std::atomic<float> period_true_peaks[ring_periods * max_channels];
+	std::atomic<float> period_mean_squares[ring_periods * max_channels];
+	std::atomic<int64_t> sample_overs[max_channels];
+	std::atomic<int64_t> true_peak_overs[max_channels];
+
+	void reset() {
+
+		for (int channel = 0; channel < max_channels; channel++) {
+
+			channel_states[channel] = ChannelState();
+
+			std::fill(channel_states[channel].history, channel_states[channel].history + num_taps - 1, 0.0f);
+
+			sample_overs[channel].store(0);
+			true_peak_overs[channel].store(0);
+
+		}
+
+		samples_in_period = 0;
+
+		completed_periods.store(0);
+
+	}
+
+	void measure_chunk(ChannelState &state, const float* samples, int num_samples) {
+
+		memcpy(staging, state.history, sizeof(state.history));
+		memcpy(staging + num_taps - 1, samples, num_samples * sizeof(float));
+
+		measure_sample_peak(state, samples, num_samples);
+		measure_true_peak(state, num_samples);
+
+		memcpy(state.history, staging + num_samples, sizeof(state.history));
+
+	}
+
+	void measure_sample_peak(ChannelState &state, const float* samples, int num_samples) {
+
+		int x = 0;
+
+#ifdef SOUNDVIEW_LEVEL_METER_SSE
+
+		const __m128 sign_bit = _mm_set1_ps(-0.0f);
+		const __m128 over_level = _mm_set1_ps(full_scale);
+
+		__m128 peak_lanes = _mm_setzero_ps();
+		__m128 sum_lanes = _mm_setzero_ps();
+
+		for (; x + 4 <= num_samples; x += 4) {
+
+			__m128 value = _mm_loadu_ps(samples + x);
+			__m128 magnitude = _mm_andnot_ps(sign_bit, value);
+
+			peak_lanes = _mm_max_ps(peak_lanes, magnitude);
+			sum_lanes = _mm_add_ps(sum_lanes, _mm_mul_ps(value, value));
+
+			if (_mm_movemask_ps(_mm_cmpge_ps(magnitude, over_level)) != 0) { //rare, so only then is it followed sample by sample
+
+				for (int lane = 0; lane < 4; lane++) {
+
+					count_over(std::abs(samples[x + lane]) >= full_scale, state.samples_since_sample_over, state.sample_overs, 1);
+
+				}
+
+			}
+			else {
+
+				count_over(false, state.samples_since_sample_over, state.sample_overs, 4);
+
+			}
+
+		}
+
+		float peaks[4], sums[4];
+
+		_mm_storeu_ps(peaks, peak_lanes);
+		_mm_storeu_ps(sums, sum_lanes);
+
+		state.period_peak = std::max(state.period_peak, std::max(std::max(peaks[0], peaks[1]), std::max(peaks[2], peaks[3])));
+		state.period_sum_squares += (double)sums[0] + sums[1] + sums[2] + sums[3];
+
+#endif
+
+		for (; x < num_samples; x++) {
+
+			float magnitude = std::abs(samples[x]);
+
+			state.period_peak = std::max(state.period_peak, magnitude);
+			state.period_sum_squares += (double)samples[x] * samples[x];
+
+			count_over(magnitude >= full_scale, state.samples_since_sample_over, state.sample_overs, 1);
+
+		}
+
+	}
+
+	void measure_true_peak(ChannelState &state, int num_samples) { //reads the staging buffer
+
+		const float* input = staging + num_taps - 1;
+
+#ifdef SOUNDVIEW_LEVEL_METER_SSE
+
+		const __m128 sign_bit = _mm_set1_ps(-0.0f);
+		const __m128 over_level = _mm_set1_ps(full_scale);
+
+		__m128 taps[num_taps];
+
+		for (int tap = 0; tap < num_taps; tap++) {
+
+			taps[tap] = _mm_loadu_ps(coefficients[tap]);
+
+		}
+
+		__m128 peak_lanes = _mm_setzero_ps();
+
+		for (int x = 0; x < num_samples; x++) {
+
+			__m128 phases = _mm_mul_ps(taps[0], _mm_set1_ps(input[x]));
+
+			for (int tap = 1; tap < num_taps; tap++) {
+
+				phases = _mm_add_ps(phases, _mm_mul_ps(taps[tap], _mm_set1_ps(input[x - tap])));
+
+			}
+
+			__m128 magnitude = _mm_andnot_ps(sign_bit, phases);
+
+			peak_lanes = _mm_max_ps(peak_lanes, magnitude);
+
+			count_over(_mm_movemask_ps(_mm_cmpgt_ps(magnitude, over_level)) != 0, state.samples_since_true_peak_over, state.true_peak_overs, 1);
+
+		}
+
+		float peaks[4];
+
+		_mm_storeu_ps(peaks, peak_lanes);
+
+		state.period_true_peak = std::max(state.period_true_peak, std::max(std::max(peaks[0], peaks[1]), std::max(peaks[2], peaks[3])));
+
+#else
+
+		for (int x = 0; x < num_samples; x++) {
+
+			bool over = false;
+
+			for (int phase = 0; phase < 4; phase++) {
+
+				float value = 0.0f;
+
+				for (int tap = 0; tap < num_taps; tap++) {
+
+					value += coefficients[tap][phase] * input[x - tap];
+
+				}
+
+				state.period_true_peak = std::max(state.period_true_peak, std::abs(value));
+
+				over = over || std::abs(value) > full_scale;
+
+			}
+
+			count_over(over, state.samples_since_true_peak_over, state.true_peak_overs, 1);
+
+		}
+
+#endif
+
+	}
+
+	void count_over(bool over, int &samples_since_over, int64_t &overs, int num_samples) const {
+
+		if (over) {
+
+			if (samples_since_over >= over_gap) {
+
+				overs++;
+
+			}
+
+			samples_since_over = 0;
+
+		}
+		else if (samples_since_over < over_gap) {
+
+			samples_since_over += num_samples;
+
+		}
+
+	}
+
+	void publish_period(int num_channels) {
+
+		int slot = (int)(completed_periods.load(std::memory_order_relaxed) % ring_periods) * max_channels;
+
+		for (int channel = 0; channel < max_channels; channel++) {
+
+			ChannelState &state = channel_states[channel];
+
+			bool active = channel < num_channels;
+
+			period_peaks[slot + channel].store(active ? state.period_peak : 0.0f, std::memory_order_relaxed);
+			period_true_peaks[slot + channel].store(active ? state.period_true_peak : 0.0f, std::memory_order_relaxed);
+			period_mean_squares[slot + channel].store(active ? (float)(state.period_sum_squares / samples_per_period) : 0.0f, std::memory_order_relaxed);
+
+			state.period_peak = 0.0f;
+			state.period_true_peak = 0.0f;
+			state.period_sum_squares = 0.0;
+
+		}
+
+		samples_in_period = 0;
+
+		completed_periods.fetch_add(1, std::memory_order_release);
+
+	}
+
+};
+
+//The display side of the level meters: sample peak and true peak rise instantly and fall at a fixed rate (20 dB in
+//1.7 s, as IEC 60268-10 type I), RMS is an exponential average of the mean square, and the peak hold keeps the
+//highest sample peak for a while before falling. Maximum true peak and the overs are since the last reset_holds().
+//RMS is relative to a full scale sine, as in AES17, so a full scale sine reads 0 dBFS on every meter.
+
+struct LevelReadings
+{
+
+	static const int max_channels = LevelMeter::max_channels;
+
+	int num_channels{ 0 };
+
+	float peak[max_channels] = {}; //dBFS
+	float peak_hold[max_channels] = {};
+	float rms[max_channels] = {};
+	float true_peak[max_channels] = {}; //dBTP
+	float max_true_peak[max_channels] = {};
+
+	int64_t sample_overs[max_channels] = {};
+	int64_t true_peak_overs[max_channels] = {};
+
+};
+
+class LevelMeterBallistics
+{
+public:
+
+	static const int max_channels = LevelMeter::max_channels;
+
+	LevelMeterBallistics() {
+
+		for (int channel = 0; channel < max_channels; channel++) {
+
+			channel_ballistics[channel] = ChannelBallistics();
+
+		}
+
+	};
+
+	~LevelMeterBallistics() {};
+
+	void set_ballistics(double release_dB_per_second, double rms_time_constant_seconds, double hold_time_seconds) {
+
+		release_rate = release_dB_per_second;
+		rms_time_constant = std::max(0.001, rms_time_constant_seconds);
+		hold_time = hold_time_seconds;
+
+	}
+
+	void update(const LevelMeter &level_meter) { //consumes the periods completed since the last call
+
+		int64_t completed = level_meter.get_completed_periods();
+
+		if (completed < next_period) { //the meter was reset by a device change
+
+			next_period = 0;
+
+			reset_holds();
+
+		}
+
+		//the slot the callback is writing next is not read
+
+		next_period = std::max(next_period, completed - (LevelMeter::ring_periods - 1));
+
+		double period_seconds = level_meter.get_period_seconds();
+
+		double release = release_rate * period_seconds;
+		double rms_coefficient = 1.0 - exp(-period_seconds / rms_time_constant);
+
+		num_channels = level_meter.get_num_channels();
+
+		for (; next_period < completed; next_period++) {
+
+			for (int channel = 0; channel < max_channels; channel++) {
+
+				float peak, true_peak, mean_square;
+
+				level_meter.get_period(next_period, channel, peak, true_peak, mean_square);
+
+				if (!std::isfinite(peak) || !std::isfinite(true_peak) || !std::isfinite(mean_square)) { //the sample health rows count these
+
+					continue;
+
+				}
+
+				ChannelBallistics &state = channel_ballistics[channel];
+
+				double peak_dB = amplitude_to_dB(peak);
+				double true_peak_dB = amplitude_to_dB(true_peak);
+
+				state.peak = std::max(peak_dB, state.peak - release);
+				state.true_peak = std::max(true_peak_dB, state.true_peak - release);
+				state.mean_square += (mean_square - state.mean_square) * rms_coefficient;
+				state.max_true_peak = std::max(state.max_true_peak, true_peak_dB);
+
+				if (peak_dB >= state.peak_hold) {
+
+					state.peak_hold = peak_dB;
+					state.hold_remaining = hold_time;
+
+				}
+				else if (state.hold_remaining > 0.0) {
+
+					state.hold_remaining -= period_seconds;
+
+				}
+				else {
+
+					state.peak_hold = std::max(state.peak, state.peak_hold - release);
+
+				}
+
+			}
+
+		}
+
+		for (int channel = 0; channel < max_channels; channel++) {
+
+			channel_ballistics[channel].sample_overs = level_meter.get_sample_overs(channel);
+			channel_ballistics[channel].true_peak_overs = level_meter.get_true_peak_overs(channel);
+
+		}
+
+	}
+
+	void reset_holds() { //peak hold, maximum true peak and the over counts start again
+
+		for (int channel = 0; channel < max_channels; channel++) {
+
+			ChannelBallistics &state = channel_ballistics[channel];
+
+			state.peak_hold = state.peak;
+			state.hold_remaining = 0.0;
+			state.max_true_peak = silence_dB;
+			state.sample_overs_at_reset = state.sample_overs;
+			state.true_peak_overs_at_reset = state.true_peak_overs;
+
+		}
+
+	}
+
+	LevelReadings get_readings() const {
+
+		LevelReadings readings;
+
+		readings.num_channels = num_channels;
+
+		for (int channel = 0; channel < max_channels; channel++) {
+
+			const ChannelBallistics &state = channel_ballistics[channel];
+
+			readings.peak[channel] = (float)state.peak;
+			readings.peak_hold[channel] = (float)state.peak_hold;
+			readings.rms[channel] = (float)(state.mean_square > 0.0 ? std::max((double)silence_dB, 10.0 * log10(2.0 * state.mean_square)) : silence_dB);
+			readings.true_peak[channel] = (float)state.true_peak;
+			readings.max_true_peak[channel] = (float)state.max_true_peak;
+			readings.sample_overs[channel] = state.sample_overs - state.sample_overs_at_reset;
+			readings.true_peak_overs[channel] = state.true_peak_overs - state.true_peak_overs_at_reset;
+
+		}
+
+		return readings;
+
+	}
+
+	static constexpr float silence_dB = -200.0f;
+
+private:
+
+	struct ChannelBallistics
+	{
+
+		double peak{ silence_dB };
+		double peak_hold{ silence_dB };
+		double hold_remaining{ 0.0 };
+		double true_peak{ silence_dB };
+		double max_true_peak{ silence_dB };
+		double mean_square{ 0.0 };
+
+		int64_t sample_overs{ 0 }, sample_overs_at_reset{ 0 };
+		int64_t true_peak_overs{ 0 }, true_peak_overs_at_reset{ 0 };
+
+	};
+
+	double release_rate{ 20.0 / 1.7 };
+	double rms_time_constant{ 0.3 };
+	double hold_time{ 2.0 };
+
+	int64_t next_period{ 0 };
+	int num_channels{ 0 };
+
+	ChannelBallistics channel_ballistics[max_channels];
+
+	static double amplitude_to_dB(float amplitude) {
+
+		return amplitude > 0.0f ? std::max((double)silence_dB, 20.0 * log10((double)amplitude)) : silence_dB;
+
+	}
+
+};
@@ -0,0 +1,450 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cmath>
+#include <algorithm>
+
+//Programme loudness after ITU-R BS.1770-4 and EBU R128 / Tech 3342. Each channel is K-weighted (the high shelf and
+//RLB high pass, designed for any sample rate from the standard's analogue parameters), squared, weighted and summed
+//into 100 ms sub-blocks. A ring of the last 30 sub-blocks gives momentary (400 ms) and short-term (3 s) loudness every
+//100 ms. Integrated loudness gates the momentary blocks at -70 LUFS absolute and 10 LU below their mean. Loudness
+//range takes the 10th to 95th percentile of short-term values gated at -70 LUFS and 20 LU below their mean. Both are
+//kept as fixed 0.1 LU histograms of block counts and energies rather than lists of blocks. Memory is then constant
+//however long the measurement runs, and gated means are exact except within the 0.1 LU bin that holds the gate.
+//process_block() never allocates or locks, so it can run in the audio callback. Readings are published via atomics.
+
+struct LoudnessReadings
+{
+
+	float momentary{ 0.0f }, short_term{ 0.0f }, integrated{ 0.0f }; //LUFS
+	float loudness_range{ 0.0f }; //LU
+	float max_momentary{ 0.0f }, max_short_term{ 0.0f };
+
+	double measured_seconds{ 0.0 };
+
+	bool momentary_valid{ false }, short_term_valid{ false }, integrated_valid{ false }, range_valid{ false };
+
+};
+
+class LoudnessMeter
+{
+public:
+
+	LoudnessMeter(int max_num_channels) :
+		max_channels(std::max(1, max_num_channels)),
+		channel_states(max_channels),
+		channel_weights(max_channels, 1.0)
+	{
+
+		momentary_histogram.resize(num_histogram_bins);
+		short_term_histogram.resize(num_histogram_bins);
+
+		set_sample_rate(48000.0);
+
+	};
+
+	~LoudnessMeter() {};
+
+	void set_sample_rate(double sample_rate) { //call while process_block() is not running, also resets the measurement
+
+		active_sample_rate = sample_rate;
+
+		sub_block_length = std::max(1, (int)std::lround(sample_rate * 0.1));
+
+		design_k_weighting();
+
+		reset();
+
+	}
+
+	void set_channel_weight(int channel, double weight) { //BS.1770: 1.0 for L, R and C, 1.41 for surrounds, 0 for LFE
+
+		if (channel >= 0 && channel < max_channels) {
+
+			channel_weights[channel] = weight;
+
+		}
+
+	}
+
+	void request_reset() { //any thread, applied at the start of the next block
+
+		reset_requested.store(true);
+
+	}
+
+	void reset() {
+
+		for (int channel = 0; channel < max_channels; channel++) {
+
+			channel_states[channel].z[0] = channel_states[channel].z[1] = channel_states[channel].z[2] = channel_states[channel].z[3] = 0.0;
+
+		}
+
+		std::fill(sub_block_powers, sub_block_powers + short_term_sub_blocks, 0.0);
+		std::fill(momentary_histogram.begin(), momentary_histogram.end(), HistogramBin());
+		std::fill(short_term_histogram.begin(), short_term_histogram.end(), HistogramBin());
+
+		sub_block_sum = 0.0;
+		samples_in_sub_block = 0;
+		sub_blocks_completed = 0;
+
+		max_momentary = max_short_term = no_level;
+
+		published_momentary.store(no_level);
+		published_short_term.store(no_level);
+		published_integrated.store(no_level);
+		published_range.store(-1.0f);
+		published_max_momentary.store(no_level);
+		published_max_short_term.store(no_level);
+		published_sub_blocks.store(0);
+
+	}
+
+	void process_block(const float* const* channels, int num_channels, int num_samples) {
+
+		if (reset_requested.exchange(false)) {
+
+			reset();
+
+		}
+
+		num_channels = std::min(num_channels, max_channels);
+
+		int offset = 0;
+
+		while (offset < num_samples) { //split the block where it crosses a sub-block boundary
+
+			int samples_to_process = std::min(num_samples - offset, sub_block_length - samples_in_sub_block);
+
+			for (int channel = 0; channel < num_channels; channel++) {
+
+				if (channel_weights[channel] != 0.0) {
+
+					sub_block_sum += channel_weights[channel] * k_weighted_energy(channel_states[channel], channels[channel] + offset, samples_to_process);
+
+				}
+
+			}
+
+			offset += samples_to_process;
+			samples_in_sub_block += samples_to_process;
+
+			if (samples_in_sub_block == sub_block_length) {
+
+				end_sub_block();
+
+			}
+
+		}
+
+	}
+
+	LoudnessReadings get_readings() const {
+
+		LoudnessReadings readings;
+
+		readings.momentary = published_momentary.load();
+		readings.short_term = published_short_term.load();
+		readings.integrated = published_integrated.load();
+		readings.loudness_range = published_range.load();
+		readings.max_momentary = published_max_momentary.load();
+		readings.max_short_term = published_max_short_term.load();
+
+		int64_t sub_blocks = published_sub_blocks.load();
+
+		readings.measured_seconds = sub_blocks * 0.1;
+		readings.momentary_valid = sub_blocks >= momentary_sub_blocks;
+		readings.short_term_valid = sub_blocks >= short_term_sub_blocks;
+		readings.integrated_valid = readings.integrated > no_level;
+		readings.range_valid = readings.loudness_range >= 0.0f;
+
+		return readings;
+
+	}
+
+	static constexpr float no_level = -200.0f; //LUFS, silence or not measured yet
+
+private:
+
+	static const int momentary_sub_blocks = 4;
+	static const int short_term_sub_blocks = 30;
+
+	//0.1 LU bins from the absolute gate up, louder blocks go in the top bin
+
+	const double histogram_floor = -70.0;
+	const double histogram_step = 0.1;
+	static const int num_histogram_bins = 800;
+
+	struct ChannelState
+	{
+
+		double z[4] = { 0.0, 0.0, 0.0, 0.0 }; //shelf z1, z2 then high pass z1, z2
+
+	};
+
+	struct HistogramBin
+	{
+
+		int64_t count{ 0 };
+		double energy{ 0.0 }; //sum of the blocks' mean squares
+
+	};
+
+	int max_channels;
+
+	std::vector<ChannelState> channel_states;
+	std::vector<double> channel_weights;
+
+	double active_sample_rate{ 48000.0 };
+	int sub_block_length{ 4800 };
+
+	double shelf_b[3], shelf_a[3]; //a[0] is 1
+	double high_pass_b[3], high_pass_a[3];
+
+	double sub_block_sum{ 0.0 };
+	int samples_in_sub_block{ 0 };
+	int64_t sub_blocks_completed{ 0 };
+	double sub_block_powers[short_term_sub_blocks]; //ring, by sub_blocks_completed
+
+	std::vector<HistogramBin> momentary_histogram, short_term_histogram;
+
+	float max_momentary{ no_level }, max_short_term{ no_level };
+
+	std::atomic<bool> reset_requested{ false };
+
+	std::atomic<float> published_momentary{ no_level }, published_short_term{ no_level }, published_integrated{ no_level };
+	std::atomic<float> published_range{ -1.0f };
+	std::atomic<float> published_max_momentary{ no_level }, published_max_short_term{ no_level };
+	std::atomic<int64_t> published_sub_blocks{ 0 };
+
+	void design_k_weighting() { //BS.1770 stage 1 and 2 parameters, which give the standard's 48 kHz coefficients exactly
+
+		const double pi = 3.141592653589793;
+
+		double shelf_frequency = 1681.974450955533;
+		double shelf_gain = 3.999843853973347; //dB
+		double shelf_q = 0.7071752369554196;
+
+		double k = tan(pi * shelf_frequency / active_sample_rate);
+		double high_gain = pow(10.0, shelf_gain / 20.0);
+		double band_gain = pow(high_gain, 0.4996667741545416);
+		double a0 = 1.0 + k / shelf_q + k * k;
+
+		shelf_b[0] = (high_gain + band_gain * k / shelf_q + k * k) / a0;
+		shelf_b[1] = (2.0 * (k * k - high_gain)) / a0;
+		shelf_b[2] = (high_gain - band_gain * k / shelf_q + k * k) / a0;
+		shelf_a[0] = 1.0;
+		shelf_a[1] = (2.0 * (k * k - 1.0)) / a0;
+		shelf_a[2] = (1.0 - k / shelf_q + k * k) / a0;
+
+		double high_pass_frequency = 38.13547087602444;
+		double high_pass_q = 0.5003270373238773;
+
+		k = tan(pi * high_pass_frequency / active_sample_rate);
+		a0 = 1.0 + k / high_pass_q + k * k;
+
+		high_pass_b[0] = 1.0;
+		high_pass_b[1] = -2.0;
+		high_pass_b[2] = 1.0;
+		high_pass_a[0] = 1.0;
+		high_pass_a[1] = (2.0 * (k * k - 1.0)) / a0;
+		high_pass_a[2] = (1.0 - k / high_pass_q + k * k) / a0;
+
+	}
+
+	double k_weighted_energy(ChannelState &state, const float* samples, int num_samples) const { //sum of squares
+
+		double z0 = state.z[0], z1 = state.z[1], z2 = state.z[2], z3 = state.z[3];
+		double energy = 0.0;
+
+		for (int sample = 0; sample < num_samples; sample++) {
+
+			double x = samples[sample];
+
+			double shelved = shelf_b[0] * x + z0;
+
+			z0 = shelf_b[1] * x - shelf_a[1] * shelved + z1;
+			z1 = shelf_b[2] * x - shelf_a[2] * shelved;
+
+			double y = high_pass_b[0] * shelved + z2;
+
+			z2 = high_pass_b[1] * shelved - high_pass_a[1] * y + z3;
+			z3 = high_pass_b[2] * shelved - high_pass_a[2] * y;
+
+			energy += y * y;
+
+		}
+
+		state.z[0] = z0;
+		state.z[1] = z1;
+		state.z[2] = z2;
+		state.z[3] = z3;
+
+		return energy;
+
+	}
+
+	void end_sub_block() {
+
+		sub_block_powers[sub_blocks_completed % short_term_sub_blocks] = sub_block_sum / sub_block_length;
+
+		sub_blocks_completed++;
+		sub_block_sum = 0.0;
+		samples_in_sub_block = 0;
+
+		if (sub_blocks_completed >= momentary_sub_blocks) {
+
+			double power = get_window_power(momentary_sub_blocks);
+			float momentary = power_to_loudness(power);
+
+			max_momentary = std::max(max_momentary, momentary);
+
+			add_to_histogram(momentary_histogram, momentary, power);
+
+			published_momentary.store(momentary);
+			published_max_momentary.store(max_momentary);
+			published_integrated.store(get_integrated_loudness());
+
+		}
+
+		if (sub_blocks_completed >= short_term_sub_blocks) {
+
+			double power = get_window_power(short_term_sub_blocks);
+			float short_term = power_to_loudness(power);
+
+			max_short_term = std::max(max_short_term, short_term);
+
+			add_to_histogram(short_term_histogram, short_term, power);
+
+			published_short_term.store(short_term);
+			published_max_short_term.store(max_short_term);
+			published_range.store(get_loudness_range());
+
+		}
+
+		published_sub_blocks.store(sub_blocks_completed);
+
+	}
+
+	double get_window_power(int num_sub_blocks) const { //mean of the newest sub-blocks
+
+		double sum = 0.0;
+
+		for (int x = 1; x <= num_sub_blocks; x++) {
+
+			sum += sub_block_powers[(sub_blocks_completed - x) % short_term_sub_blocks];
+
+		}
+
+		return sum / num_sub_blocks;
+
+	}
+
+	void add_to_histogram(std::vector<HistogramBin> &histogram, float loudness, double power) {
+
+		if (loudness <= histogram_floor) { //the absolute gate
+
+			return;
+
+		}
+
+		HistogramBin &bin = histogram[get_bin(loudness)];
+
+		bin.count++;
+		bin.energy += power;
+
+	}
+
+	int get_bin(double loudness) const {
+
+		return std::max(0, std::min(num_histogram_bins - 1, (int)((loudness - histogram_floor) / histogram_step)));
+
+	}
+
+	//mean loudness of the blocks at or above gate_bin, no_level if there are none
+
+	float get_gated_loudness(const std::vector<HistogramBin> &histogram, int gate_bin, int64_t &count) const {
+
+		double energy = 0.0;
+
+		count = 0;
+
+		for (int bin = gate_bin; bin < num_histogram_bins; bin++) {
+
+			count += histogram[bin].count;
+			energy += histogram[bin].energy;
+
+		}
+
+		return count > 0 ? power_to_loudness(energy / count) : no_level;
+
+	}
+
+	float get_integrated_loudness() const {
+
+		int64_t count;
+
+		float ungated = get_gated_loudness(momentary_histogram, 0, count);
+
+		if (count == 0) {
+
+			return no_level;
+
+		}
+
+		return get_gated_loudness(momentary_histogram, get_bin(ungated - 10.0), count);
+
+	}
+
+	float get_loudness_range() const { //-1 until there is a gated short-term value
+
+		int64_t count;
+
+		float ungated = get_gated_loudness(short_term_histogram, 0, count);
+
+		if (count == 0) {
+
+			return -1.0f;
+
+		}
+
+		int gate_bin = get_bin(ungated - 20.0);
+
+		get_gated_loudness(short_term_histogram, gate_bin, count);
+
+		return (float)(get_percentile(short_term_histogram, gate_bin, count, 0.95) - get_percentile(short_term_histogram, gate_bin, count, 0.10));
+
+	}
+
+	double get_percentile(const std::vector<HistogramBin> &histogram, int gate_bin, int64_t count, double fraction) const {
+
+		int64_t target = (int64_t)std::lround((count - 1) * fraction); //the index Tech 3342 takes in the sorted values
+		int64_t seen = 0;
+
+		for (int bin = gate_bin; bin < num_histogram_bins; bin++) {
+
+			seen += histogram[bin].count;
+
+			if (seen > target) {
+
+				return histogram_floor + (bin + 0.5) * histogram_step;
+
+			}
+
+		}
+
+		return histogram_floor + num_histogram_bins * histogram_step;
+
+	}
+
+	static float power_to_loudness(double power) {
+
+		double loudness = power > 0.0 ? -0.691 + 10.0 * log10(power) : no_level;
+
+		return loudness > no_level ? (float)loudness : no_level;
+
+	}
+
+};
@@ -0,0 +1,586 @@
+#pragma once
+
+#include "analysis_engine.h"
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <assert.h>
+
+//Runs several FFT sizes over the same input and stitches them into one log frequency RTA and spectrogram row. Each
+//band has its own AnalysisEngine, hop and upper frequency. It covers the bins from the previous band's upper
+//frequency up to its own. Long FFTs resolve the lows and short FFTs react quickly in the highs. Each band is analysed
+//only when its hop has passed, so the total cost is far less than running the longest FFT at the shortest hop.
+//A single band with no upper limit behaves like a plain AnalysisEngine. Engines are kept per FFT size, so switching
+//between layouts does not plan the same FFT twice.
+//
+//The bins are scaled so a sine reads its own level whatever the FFT size, but a bin of a shorter FFT is wider and
+//collects more noise: broadband noise reads 10*log10 of the FFT size ratio higher above each band edge (6 dB at
+//200 Hz and 9 dB at 5 kHz for the default bands). Rather than step there, the linear FFT bins of the half octave below
+//each edge cross-fade, evenly in dB, from the longer FFT's level to the shorter FFT's level interpolated at the same
+//frequency, so noise ramps between the two bin widths and meets the next band without a step. The longer FFT's bins
+//are the ones faded because the shorter FFT's broad peaks still hold a sine's level between its bins, where the
+//longer FFT's narrow peaks would not: a sine keeps its level, within the shorter FFT's scalloping, and only its
+//width on the display grows towards the edge. Constant-Q and filterbank bins have the same bandwidth in every band,
+//so they are not cross-faded.
+
+struct AnalysisBand
+{
+
+	int fft_size;
+	int hop_size; //samples between analyses of this band
+	float highest_frequency; //Hz, the last band should use no_frequency_limit
+
+};
+
+class MultiResolutionEngine
+{
+public:
+
+	static constexpr float no_frequency_limit = 1.0e9f;
+
+	MultiResolutionEngine(int num_spectrogram_frequencies, float lowest_frequency, float highest_frequency) :
+		spectrogram_num_frequencies(num_spectrogram_frequencies),
+		spectrogram_lowest_frequency(lowest_frequency),
+		spectrogram_highest_frequency(highest_frequency)
+	{};
+
+	~MultiResolutionEngine() {};
+
+	static std::vector<AnalysisBand> get_single_resolution_bands(int fft_size, int hop_size) {
+
+		return { { fft_size, hop_size, no_frequency_limit } };
+
+	}
+
+	//Hops of an eighth of each FFT give every band the same overlap, and at 48 kHz the lows get 0.73 Hz bins. Bands are
+	//only analysed when analyse_frame() is called, once per display frame, so at 30 frames a second (1600 samples at
+	//48 kHz) the highs update with every frame, the mids every second frame and the lows every sixth frame.
+
+	static std::vector<AnalysisBand> get_multi_resolution_bands() {
+
+		return { { 65536, 8192, 200.0f }, { 16384, 2048, 5000.0f }, { 2048, 256, no_frequency_limit } };
+
+	}
+
+	void set_bands(const std::vector<AnalysisBand> &new_bands) { //ordered from the lowest band up, one band per FFT size
+
+		bands.clear();
+
+		for (int x = 0; x < new_bands.size(); x++) {
+
+			BandState band;
+
+			band.band = new_bands[x];
+			band.engine = get_engine(new_bands[x].fft_size);
+			band.engine->reset_averages();
+			band.last_analysed_sample = -new_bands[x].hop_size; //due straight away
+
+			bands.push_back(band);
+
+		}
+
+		max_fft_size = 0;
+
+		for (int x = 0; x < bands.size(); x++) {
+
+			max_fft_size = std::max(max_fft_size, bands[x].band.fft_size);
+
+		}
+
+		input_samples.assign(max_fft_size, 0.0);
+
+		generate_band_bins();
+
+	}
+
+	void set_sample_rate(double sample_rate) {
+
+		if (active_sample_rate != sample_rate) {
+
+			active_sample_rate = sample_rate;
+
+			for (auto &engine : engines) {
+
+				engine.second->set_sample_rate(sample_rate);
+
+			}
+
+			generate_band_bins();
+
+		}
+
+	}
+
+	void set_num_averages(int averages) {
+
+		num_averages = averages;
+
+		for (auto &engine : engines) {
+
+			engine.second->set_num_averages(num_averages);
+
+		}
+
+		mark_rta_changed();
+
+	}
+
+	void set_averaging_mode(AveragingMode mode) {
+
+		averaging_mode = mode;
+
+		for (auto &engine : engines) {
+
+			engine.second->set_averaging_mode(averaging_mode);
+
+		}
+
+		mark_rta_changed();
+
+	}
+
+	void reset_averages() {
+
+		for (auto &engine : engines) {
+
+			engine.second->reset_averages();
+
+		}
+
+		mark_rta_changed();
+
+	}
+
+	void set_smoothing(int window_type, int window_size) {
+
+		smoothing_window_type = window_type;
+		smoothing_window_size = window_size;
+
+		for (auto &engine : engines) {
+
+			engine.second->set_smoothing(smoothing_window_type, smoothing_window_size);
+
+		}
+
+		mark_rta_changed();
+
+	}
+
+	void set_spectrogram_num_frequencies(int num_frequencies) {
+
+		spectrogram_num_frequencies = num_frequencies;
+
+		for (auto &engine : engines) {
+
+			engine.second->set_spectrogram_num_frequencies(spectrogram_num_frequencies);
+
+		}
+
+		generate_band_bins(); //constant-Q bins follow the spectrogram frequencies
+
+	}
+
+	void set_constant_q(int bins_per_octave) { //0 = linear FFT bins, each band then covers its range with constant-Q bins
+
+		constant_q_bins_per_octave = bins_per_octave;
+
+		for (auto &engine : engines) {
+
+			engine.second->set_constant_q(constant_q_bins_per_octave);
+
+		}
+
+		generate_band_bins();
+
+	}
+
+	void set_frequency_scale(FrequencyScale scale) { //moves the spectrogram frequencies, and off log uses the filterbank bins
+
+		frequency_scale = scale;
+
+		for (auto &engine : engines) {
+
+			engine.second->set_frequency_scale(frequency_scale);
+
+		}
+
+		generate_band_bins();
+
+	}
+
+	int get_max_fft_size() const { return max_fft_size; }
+
+	int get_num_bands() const { return (int)bands.size(); }
+
+	//Write the newest get_num_samples_due() samples here, newest first, before calling analyse_frame()
+
+	double* get_input_samples() { return input_samples.data(); }
+
+	int get_num_samples_due(int64_t samples_received) const { //0 when no band's hop has passed
+
+		int num_samples = 0;
+
+		for (int x = 0; x < bands.size(); x++) {
+
+			if (samples_received - bands[x].last_analysed_sample >= bands[x].band.hop_size) {
+
+				num_samples = std::max(num_samples, bands[x].band.fft_size);
+
+			}
+
+		}
+
+		return num_samples;
+
+	}
+
+	bool analyse_frame(int64_t samples_received) { //analyses the bands whose hop has passed, returns false if none had
+
+		bool analysed = false;
+
+		for (int x = 0; x < bands.size(); x++) {
+
+			BandState &band = bands[x];
+
+			if (samples_received - band.last_analysed_sample < band.band.hop_size) {
+
+				continue;
+
+			}
+
+			std::copy(input_samples.begin(), input_samples.begin() + band.band.fft_size, band.engine->get_input_samples());
+
+			band.engine->analyse_frame();
+
+			band.last_analysed_sample = samples_received;
+			band.rta_changed = true;
+
+			analysed = true;
+
+		}
+
+		return analysed;
+
+	}
+
+	const std::vector<float>& get_bin_frequencies() const { return bin_frequencies; } //all bands, ascending
+
+	const std::vector<float>& get_spectrogram_frequencies() const { return bands.front().engine->get_spectrogram_frequencies(); }
+
+	const std::vector<float>& get_rta_amplitudes() { //averaged and smoothed per band, linear, only updated for bands with new frames
+
+		for (int x = 0; x < bands.size(); x++) {
+
+			BandState &band = bands[x];
+
+			if (!band.rta_changed) {
+
+				continue;
+
+			}
+
+			band.rta_amplitudes = band.engine->get_rta_amplitudes();
+
+			std::copy(band.rta_amplitudes.begin() + band.first_bin, band.rta_amplitudes.begin() + band.first_bin + band.num_bins, rta_amplitudes.begin() + band.output_offset);
+
+			band.rta_changed = false;
+
+			crossovers_changed = true;
+
+		}
+
+		if (crossovers_changed) {
+
+			for (int x = 0; x < bands.size(); x++) {
+
+				crossover_sources[x] = &bands[x].rta_amplitudes;
+
+			}
+
+			cross_fade_band_edges(rta_amplitudes.data());
+
+			crossovers_changed = false;
+
+		}
+
+		return rta_amplitudes;
+
+	}
+
+	const std::vector<float>& get_frame_amplitudes() { //latest frame of each band, unaveraged, linear, at get_bin_frequencies()
+
+		for (int x = 0; x < bands.size(); x++) {
+
+			const BandState &band = bands[x];
+			const std::vector<float> &band_amplitudes = band.engine->get_bin_amplitudes();
+
+			std::copy(band_amplitudes.begin() + band.first_bin, band_amplitudes.begin() + band.first_bin + band.num_bins, frame_amplitudes.begin() + band.output_offset);
+
+		}
+
+		return frame_amplitudes;
+
+	}
+
+	const std::vector<float>& update_spectrogram_amplitudes() { //latest frame of each band in dBFS at each spectrogram frequency
+
+		if (bands.size() == 1) {
+
+			return bands.front().engine->update_spectrogram_amplitudes();
+
+		}
+
+		SOUNDVIEW_PROFILE_SCOPE("spectrogram_resample");
+
+		for (int x = 0; x < bands.size(); x++) {
+
+			const BandState &band = bands[x];
+			const std::vector<float> &band_amplitudes = band.engine->get_bin_amplitudes();
+
+			std::copy(band_amplitudes.begin() + band.first_bin, band_amplitudes.begin() + band.first_bin + band.num_bins, interpolator_ref_amp.begin() + band.output_offset);
+
+			crossover_sources[x] = &band_amplitudes;
+
+		}
+
+		cross_fade_band_edges(interpolator_ref_amp.data()); //no steps at the band edges for the spline to ring on
+
+		cubic_interpolator.set_points(interpolator_ref_freq, interpolator_ref_amp);
+
+		const std::vector<float> &spectrogram_frequencies = bands.front().engine->get_spectrogram_frequencies();
+
+		for (int frequency = 0; frequency < spectrogram_num_frequencies; frequency++) {
+
+			spectrogram_amplitudes[frequency] = bands.front().engine->amp_to_dBFS(cubic_interpolator(spectrogram_frequencies[frequency]));
+
+		}
+
+		return spectrogram_amplitudes;
+
+	}
+
+private:
+
+	struct BandState
+	{
+
+		AnalysisBand band;
+		AnalysisEngine* engine;
+
+		int first_bin{ 0 }, num_bins{ 0 }; //this band's bins in its engine
+		int output_offset{ 0 }; //where they start in the stitched vectors
+
+		int64_t last_analysed_sample{ 0 };
+		bool rta_changed{ true };
+
+		std::vector<float> rta_amplitudes; //the engine's latest averaged and smoothed output, all of its bins
+
+	};
+
+	struct CrossoverBin
+	{
+
+		int output_index; //in the stitched vectors
+		int band, bin; //the band the output bin belongs to, and its bin in that band's engine
+		int other_band;
+		float other_position; //fractional bin of the same frequency in the other band's engine
+		float other_weight; //0 half an octave below the edge, rising to 1 at the edge
+
+	};
+
+	std::map<int, std::unique_ptr<AnalysisEngine>> engines; //by FFT size
+	std::vector<BandState> bands;
+
+	int max_fft_size{ 0 };
+	std::vector<double> input_samples;
+
+	double active_sample_rate = 44100.0;
+	int num_averages{ 1 };
+	AveragingMode averaging_mode{ mean_averaging };
+	int smoothing_window_type{ 0 };
+	int smoothing_window_size{ 1 };
+	int constant_q_bins_per_octave{ 0 };
+	FrequencyScale frequency_scale{ log_scale };
+
+	int spectrogram_num_frequencies;
+	float spectrogram_lowest_frequency, spectrogram_highest_frequency;
+
+	std::vector<float> bin_frequencies, rta_amplitudes, frame_amplitudes, spectrogram_amplitudes;
+
+	tk::spline cubic_interpolator;
+	std::vector<double> interpolator_ref_freq, interpolator_ref_amp;
+
+	const float crossover_ratio = 1.41421356f; //half an octave below each band edge
+	std::vector<CrossoverBin> crossover_bins;
+	std::vector<const std::vector<float>*> crossover_sources; //per band, the amplitudes being cross-faded
+	bool crossovers_changed{ true };
+
+	AnalysisEngine* get_engine(int fft_size) {
+
+		auto existing = engines.find(fft_size);
+
+		if (existing != engines.end()) {
+
+			return existing->second.get();
+
+		}
+
+		std::unique_ptr<AnalysisEngine> engine(new AnalysisEngine(fft_size, spectrogram_num_frequencies, spectrogram_lowest_frequency, spectrogram_highest_frequency));
+
+		engine->set_sample_rate(active_sample_rate);
+		engine->set_num_averages(num_averages);
+		engine->set_averaging_mode(averaging_mode);
+		engine->set_smoothing(smoothing_window_type, smoothing_window_size);
+		engine->set_constant_q(constant_q_bins_per_octave);
+		engine->set_frequency_scale(frequency_scale);
+
+		AnalysisEngine* engine_pointer = engine.get();
+
+		engines[fft_size] = std::move(engine);
+
+		return engine_pointer;
+
+	}
+
+	void generate_band_bins() { //which bins each band contributes, from the previous band's upper frequency to its own
+
+		bin_frequencies.clear();
+
+		float band_lowest_frequency = 0.0f;
+
+		for (int x = 0; x < bands.size(); x++) {
+
+			BandState &band = bands[x];
+
+			assert(x == 0 || band.band.fft_size != bands[x - 1].band.fft_size);
+
+			const std::vector<float> &engine_frequencies = band.engine->get_bin_frequencies();
+
+			auto first = std::lower_bound(engine_frequencies.begin(), engine_frequencies.end(), band_lowest_frequency);
+			auto end = std::lower_bound(first, engine_frequencies.end(), band.band.highest_frequency);
+
+			band.first_bin = (int)(first - engine_frequencies.begin());
+			band.num_bins = (int)(end - first);
+			band.output_offset = (int)bin_frequencies.size();
+			band.rta_changed = true;
+
+			bin_frequencies.insert(bin_frequencies.end(), first, end);
+
+			band_lowest_frequency = band.band.highest_frequency;
+
+		}
+
+		rta_amplitudes.assign(bin_frequencies.size(), 0.0f);
+		frame_amplitudes.assign(bin_frequencies.size(), 0.0f);
+
+		generate_crossover_bins();
+
+		interpolator_ref_freq.assign(bin_frequencies.begin(), bin_frequencies.end());
+		interpolator_ref_amp.assign(bin_frequencies.size(), 0.0);
+
+		spectrogram_amplitudes.resize(spectrogram_num_frequencies);
+
+	}
+
+	void generate_crossover_bins() {
+
+		crossover_bins.clear();
+		crossover_sources.assign(bands.size(), nullptr);
+		crossovers_changed = true;
+
+		if (bands.size() < 2 || bands.front().engine->uses_spectrogram_bins()) {
+
+			return;
+
+		}
+
+		float log_ratio = logf(crossover_ratio);
+
+		for (int x = 1; x < bands.size(); x++) {
+
+			float edge = bands[x - 1].band.highest_frequency;
+
+			add_crossover_bins(x - 1, x, edge / crossover_ratio, edge, log_ratio);
+
+		}
+
+	}
+
+	void add_crossover_bins(int band_index, int other_band_index, float lowest_frequency, float highest_frequency, float log_ratio) {
+
+		const BandState &band = bands[band_index];
+		const std::vector<float> &other_frequencies = bands[other_band_index].engine->get_bin_frequencies();
+
+		float other_spacing = other_frequencies[1] - other_frequencies[0];
+
+		for (int bin = 0; bin < band.num_bins; bin++) {
+
+			int output_index = band.output_offset + bin;
+			float frequency = bin_frequencies[output_index];
+
+			if (frequency < lowest_frequency || frequency >= highest_frequency) {
+
+				continue;
+
+			}
+
+			CrossoverBin crossover;
+
+			crossover.output_index = output_index;
+			crossover.band = band_index;
+			crossover.bin = band.first_bin + bin;
+			crossover.other_band = other_band_index;
+			crossover.other_position = std::min(frequency / other_spacing, other_frequencies.size() - 1.001f);
+			crossover.other_weight = std::max(0.0f, 1.0f - logf(highest_frequency / frequency) / log_ratio);
+
+			crossover_bins.push_back(crossover);
+
+		}
+
+	}
+
+	template <typename T>
+	void cross_fade_band_edges(T* output) const { //reads crossover_sources, so fill that first
+
+		for (int x = 0; x < crossover_bins.size(); x++) {
+
+			const CrossoverBin &crossover = crossover_bins[x];
+
+			const std::vector<float> &own = *crossover_sources[crossover.band];
+			const std::vector<float> &other = *crossover_sources[crossover.other_band];
+
+			if (own.empty() || other.empty()) {
+
+				continue;
+
+			}
+
+			int lower = (int)crossover.other_position;
+			float fraction = crossover.other_position - lower;
+
+			float own_value = own[crossover.bin];
+			float other_value = other[lower] + (other[lower + 1] - other[lower]) * fraction;
+
+			//evenly in dB, so a level step becomes a straight ramp on the log scale
+
+			output[crossover.output_index] = own_value > 0.0f && other_value > 0.0f ?
+				own_value * powf(other_value / own_value, crossover.other_weight) : own_value + (other_value - own_value) * crossover.other_weight;
+
+		}
+
+	}
+
+	void mark_rta_changed() {
+
+		for (int x = 0; x < bands.size(); x++) {
+
+			bands[x].rta_changed = true;
+
+		}
+
+	}
+
+};
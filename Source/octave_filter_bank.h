@@ -0,0 +1,646 @@
+#pragma once
+
+#include "sample_fifo.h"
+#include "frame_profiler.h"
+
+#include <vector>
+#include <complex>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+ #include <xmmintrin.h>
+ #define SOUNDVIEW_OCTAVE_BANDS_SSE 1
+#endif
+
+//Octave and third-octave band levels from a bank of band pass filters (IEC 61260-1), so the low bands are as accurate
+//as the high ones whatever the FFT size. Band centres are the base 10 series 1000 * 10^(3x / 10b) Hz for b bands per
+//octave. Each band is a 6th order Butterworth band pass, the usual class 1 design, made of three biquads whose edges
+//are prewarped so the bilinear transform puts them exactly where the standard does. The bank is multirate. Below the
+//top octave the input is low pass filtered and decimated by 2 once per octave, and each band runs at the lowest rate
+//that keeps its upper edge below a fifth of that rate. Every band then sits in the same place relative to its own
+//sample rate, single precision stays well conditioned for the 20 Hz band, and the whole bank costs about twice its
+//top octave. Bands at the same rate are filtered four at a time, one per SSE lane. Levels are Fast (125 ms)
+//exponentially time weighted. The audio thread only pushes samples into a SampleFifo, the filters run on a worker.
+
+//Sets flush to zero and denormals are zero for its lifetime and then restores the caller's MXCSR
+
+class ScopedFlushDenormals
+{
+public:
+
+#if SOUNDVIEW_OCTAVE_BANDS_SSE
+
+	ScopedFlushDenormals() : previous_csr(_mm_getcsr()) { _mm_setcsr(previous_csr | 0x8040); };
+
+	~ScopedFlushDenormals() { _mm_setcsr(previous_csr); };
+
+private:
+
+	unsigned int previous_csr;
+
+#else
+
+	ScopedFlushDenormals() {};
+
+	~ScopedFlushDenormals() {};
+
+#endif
+
+};
+
+struct OctaveBandLevels
+{
+
+	std::vector<float> centre_frequencies, lower_edges, upper_edges; //Hz, exact rather than nominal
+	std::vector<float> amplitudes; //linear, RMS * sqrt(2) so a full scale sine reads 1.0 like the FFT bins
+
+	int bands_per_octave{ 3 };
+	bool valid{ false };
+
+};
+
+class OctaveFilterBank
+{
+public:
+
+	OctaveFilterBank() :
+		input_fifo(1, 65536)
+	{
+
+		chunk.resize(block_size);
+
+	};
+
+	~OctaveFilterBank() {
+
+		stop();
+
+	};
+
+	void start() {
+
+		if (worker_thread.joinable()) {
+
+			return;
+
+		}
+
+		stop_requested.store(false);
+
+		worker_thread = std::thread(&OctaveFilterBank::run, this);
+
+	}
+
+	void stop() {
+
+		stop_requested.store(true);
+
+		if (worker_thread.joinable()) {
+
+			worker_thread.join();
+
+		}
+
+	}
+
+	void push_samples(const float* samples, int num_samples) { //audio thread, ignored while disabled
+
+		if (!enabled.load(std::memory_order_relaxed)) {
+
+			return;
+
+		}
+
+		const float* channels[1] = { samples };
+
+		input_fifo.push(channels, num_samples);
+
+	}
+
+	void set_enabled(bool should_be_enabled) {
+
+		enabled.store(should_be_enabled);
+
+		reconfigure_requested.store(true); //settle from silence rather than from stale levels
+
+	}
+
+	bool is_enabled() const { return enabled.load(); }
+
+	void set_sample_rate(double sample_rate) {
+
+		active_sample_rate.store(sample_rate);
+
+		reconfigure_requested.store(true);
+
+	}
+
+	void set_bands_per_octave(int num_bands_per_octave) { //1 or 3
+
+		bands_per_octave.store(num_bands_per_octave == 1 ? 1 : 3);
+
+		reconfigure_requested.store(true);
+
+	}
+
+	//Copies the latest levels into destination if they are newer than last_frame_index, which is then updated
+
+	bool get_levels(OctaveBandLevels &destination, int64_t &last_frame_index) {
+
+		std::lock_guard<std::mutex> result_lock(result_mtx);
+
+		if (frame_index == last_frame_index) {
+
+			return false;
+
+		}
+
+		destination = latest_levels;
+		last_frame_index = frame_index;
+
+		return true;
+
+	}
+
+	int get_num_bands() const { return num_bands; }
+
+	int get_num_rates() const { return num_levels; }
+
+	void process_samples(const float* samples, int num_samples) { //worker thread, or directly when not started
+
+		ScopedFlushDenormals flush_denormals; //already set on the worker, a direct caller gets the same arithmetic
+
+		if (reconfigure_requested.exchange(false)) {
+
+			configure();
+
+		}
+
+		if (num_bands == 0) {
+
+			return;
+
+		}
+
+		SOUNDVIEW_PROFILE_SCOPE("octave_bands");
+
+		for (int offset = 0; offset < num_samples; offset += block_size) {
+
+			level_counts[0] = std::min(block_size, num_samples - offset);
+
+			std::copy(samples + offset, samples + offset + level_counts[0], level_samples[0].begin());
+
+			for (int level = 1; level < num_levels; level++) {
+
+				decimate(decimation_stages[level - 1], level_samples[level - 1].data(), level_counts[level - 1], level_samples[level].data(), level_counts[level]);
+
+			}
+
+			for (int group = 0; group < band_groups.size(); group++) {
+
+				process_group(band_groups[group], level_samples[band_groups[group].level].data(), level_counts[band_groups[group].level]);
+
+			}
+
+		}
+
+		std::lock_guard<std::mutex> result_lock(result_mtx);
+
+		for (int group = 0; group < band_groups.size(); group++) {
+
+			for (int lane = 0; lane < band_groups[group].num_bands; lane++) {
+
+				latest_levels.amplitudes[band_groups[group].first_band + lane] = sqrtf(2.0f * band_groups[group].mean_square[lane]);
+
+			}
+
+		}
+
+		latest_levels.valid = true;
+
+		frame_index++;
+
+	}
+
+private:
+
+	static const int num_sections = 3; //biquads per band
+	static const int num_lanes = 4;
+	static const int max_levels = 12; //20 Hz is 11 octaves below 96 kHz's top octave
+
+	const int block_size = 2048;
+	const double pi = 3.141592653589793;
+	const double fast_time_constant = 0.125; //seconds
+	const double highest_edge_per_rate = 0.2; //a band's upper edge as a fraction of the rate it runs at
+	const double decimation_cutoff = 0.18; //of the rate before decimating, flat to 0.004 dB at the next level's highest edge
+
+	struct Biquad //direct form II transposed, double precision for the single channel decimation filters
+	{
+
+		double b0{ 1.0 }, b1{ 0.0 }, b2{ 0.0 }, a1{ 0.0 }, a2{ 0.0 };
+		double z1{ 0.0 }, z2{ 0.0 };
+
+		double process(double x) {
+
+			double y = b0 * x + z1;
+
+			z1 = b1 * x - a1 * y + z2;
+			z2 = b2 * x - a2 * y;
+
+			return y;
+
+		}
+
+	};
+
+	struct DecimationStage //low pass then keep every other sample, from one level into the next
+	{
+
+		Biquad sections[num_sections];
+		bool keep_next{ false };
+
+	};
+
+	//Up to four bands at the same rate, one per lane. A band pass section is gain * (1 - z^-2) / (1 + a1 z^-1 + a2 z^-2).
+	//Unused lanes have zero gain.
+
+	struct BandGroup
+	{
+
+		int level{ 0 };
+		int first_band{ 0 }, num_bands{ 0 };
+
+		float gain[num_sections][num_lanes];
+		float a1[num_sections][num_lanes];
+		float a2[num_sections][num_lanes];
+		float z1[num_sections][num_lanes];
+		float z2[num_sections][num_lanes];
+
+		float mean_square[num_lanes];
+		float smoothing{ 0.0f }; //exponential time weighting coefficient at this level's rate
+
+	};
+
+	SampleFifo input_fifo;
+	std::vector<float> chunk;
+
+	//filter state, only touched by the processing thread
+
+	int num_bands{ 0 };
+	int num_levels{ 0 };
+
+	std::vector<BandGroup> band_groups;
+	std::vector<DecimationStage> decimation_stages; //num_levels - 1
+	std::vector<std::vector<float>> level_samples; //the current block at each level's rate
+	std::vector<int> level_counts;
+
+	//results
+
+	std::mutex result_mtx;
+	OctaveBandLevels latest_levels;
+	int64_t frame_index{ 0 };
+
+	std::thread worker_thread;
+	std::atomic<bool> stop_requested{ false };
+	std::atomic<bool> enabled{ false };
+	std::atomic<bool> reconfigure_requested{ true };
+	std::atomic<double> active_sample_rate{ 44100.0 };
+	std::atomic<int> bands_per_octave{ 3 };
+
+	void run() {
+
+		FrameProfiler::get_instance().set_thread_name("Octave bands");
+
+#if SOUNDVIEW_OCTAVE_BANDS_SSE
+
+		_mm_setcsr(_mm_getcsr() | 0x8040); //flush denormals to zero, the filters' states decay into them in silence
+
+#endif
+
+		while (!stop_requested.load()) {
+
+			int num_ready = input_fifo.get_num_ready();
+
+			if (num_ready == 0 && !reconfigure_requested.load()) {
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+				continue;
+
+			}
+
+			int num_samples = std::min(num_ready, (int)chunk.size());
+
+			float* channels[1] = { chunk.data() };
+
+			input_fifo.pop(channels, num_samples);
+
+			process_samples(chunk.data(), num_samples);
+
+		}
+
+	}
+
+	void configure() {
+
+		double sample_rate = active_sample_rate.load();
+		int fraction = bands_per_octave.load();
+
+		std::vector<double> centres, lower_edges, upper_edges;
+		std::vector<int> levels;
+
+		for (int x = -10 * fraction; x <= 5 * fraction; x++) {
+
+			double centre = 1000.0 * pow(10.0, (0.3 * x) / fraction);
+			double half_band = pow(10.0, 0.3 / (2.0 * fraction));
+
+			if (centre < 19.0 || centre > 20500.0 || centre * half_band >= sample_rate * 0.49) { //20 Hz to 20 kHz, below Nyquist
+
+				continue;
+
+			}
+
+			int level = 0;
+
+			while (level + 1 < max_levels && centre * half_band <= highest_edge_per_rate * sample_rate / (1 << (level + 1))) {
+
+				level++;
+
+			}
+
+			centres.push_back(centre);
+			lower_edges.push_back(centre / half_band);
+			upper_edges.push_back(centre * half_band);
+			levels.push_back(level);
+
+		}
+
+		num_bands = (int)centres.size();
+		num_levels = 0;
+
+		for (int band = 0; band < num_bands; band++) {
+
+			num_levels = std::max(num_levels, levels[band] + 1);
+
+		}
+
+		decimation_stages.assign(std::max(0, num_levels - 1), DecimationStage());
+
+		for (int stage = 0; stage < decimation_stages.size(); stage++) {
+
+			design_decimation_filter(decimation_stages[stage]);
+
+		}
+
+		level_samples.assign(num_levels, std::vector<float>(block_size, 0.0f));
+		level_counts.assign(num_levels, 0);
+
+		//bands are ascending, so each level's bands are adjacent
+
+		band_groups.clear();
+
+		for (int band = 0; band < num_bands; band++) {
+
+			if (band_groups.empty() || band_groups.back().level != levels[band] || band_groups.back().num_bands == num_lanes) {
+
+				BandGroup group;
+
+				std::fill(&group.gain[0][0], &group.gain[0][0] + num_sections * num_lanes, 0.0f);
+				std::fill(&group.a1[0][0], &group.a1[0][0] + num_sections * num_lanes, 0.0f);
+				std::fill(&group.a2[0][0], &group.a2[0][0] + num_sections * num_lanes, 0.0f);
+				std::fill(&group.z1[0][0], &group.z1[0][0] + num_sections * num_lanes, 0.0f);
+				std::fill(&group.z2[0][0], &group.z2[0][0] + num_sections * num_lanes, 0.0f);
+				std::fill(group.mean_square, group.mean_square + num_lanes, 0.0f);
+
+				group.level = levels[band];
+				group.first_band = band;
+
+				double level_rate = sample_rate / (1 << group.level);
+
+				group.smoothing = (float)(1.0 - exp(-1.0 / (fast_time_constant * level_rate)));
+
+				band_groups.push_back(group);
+
+			}
+
+			BandGroup &group = band_groups.back();
+
+			design_band_pass(lower_edges[band], upper_edges[band], sample_rate / (1 << group.level), group, group.num_bands);
+
+			group.num_bands++;
+
+		}
+
+		std::lock_guard<std::mutex> result_lock(result_mtx);
+
+		latest_levels.centre_frequencies.assign(centres.begin(), centres.end());
+		latest_levels.lower_edges.assign(lower_edges.begin(), lower_edges.end());
+		latest_levels.upper_edges.assign(upper_edges.begin(), upper_edges.end());
+		latest_levels.amplitudes.assign(num_bands, 0.0f);
+		latest_levels.bands_per_octave = fraction;
+		latest_levels.valid = false;
+
+		frame_index++;
+
+	}
+
+	//6th order Butterworth band pass from the 3rd order low pass prototype. Each prototype pole p maps to the roots of
+	//s^2 - p B s + w0^2. The real pole gives one section with both roots, each root of the complex pole above the real
+	//axis gives a section with its conjugate, and every section has a zero at DC and at Nyquist. Each section is
+	//normalised to unity at the centre, where the whole filter's response is exactly 1.
+
+	void design_band_pass(double lower_edge, double upper_edge, double sample_rate, BandGroup &group, int lane) {
+
+		double k = 2.0 * sample_rate;
+		double warped_lower = k * tan(pi * lower_edge / sample_rate);
+		double warped_upper = k * tan(pi * upper_edge / sample_rate);
+		double warped_centre = sqrt(warped_lower * warped_upper);
+		double bandwidth = warped_upper - warped_lower;
+
+		std::vector<std::pair<double, double>> denominators; //analogue s^2 + c1 s + c0
+
+		for (int pole = 0; pole < num_sections; pole++) {
+
+			std::complex<double> prototype_pole = std::polar(1.0, pi * (2.0 * pole + num_sections + 1.0) / (2.0 * num_sections));
+
+			if (prototype_pole.imag() < -1.0e-9) { //its roots are the conjugates of another pole's
+
+				continue;
+
+			}
+
+			if (prototype_pole.imag() < 1.0e-9) {
+
+				denominators.push_back(std::make_pair(-prototype_pole.real() * bandwidth, warped_centre * warped_centre));
+
+				continue;
+
+			}
+
+			std::complex<double> root = sqrt(prototype_pole * prototype_pole * bandwidth * bandwidth - 4.0 * warped_centre * warped_centre);
+
+			std::complex<double> roots[2] = { (prototype_pole * bandwidth + root) * 0.5, (prototype_pole * bandwidth - root) * 0.5 };
+
+			for (int r = 0; r < 2; r++) {
+
+				denominators.push_back(std::make_pair(-2.0 * roots[r].real(), std::norm(roots[r])));
+
+			}
+
+		}
+
+		std::complex<double> z_inverse = std::polar(1.0, -2.0 * atan(warped_centre / k)); //at the centre frequency
+
+		for (int section = 0; section < num_sections && section < denominators.size(); section++) {
+
+			double c1 = denominators[section].first;
+			double c0 = denominators[section].second;
+
+			double a0 = k * k + c1 * k + c0;
+			double a1 = (2.0 * (c0 - k * k)) / a0;
+			double a2 = (k * k - c1 * k + c0) / a0;
+
+			double response = std::abs((1.0 - z_inverse * z_inverse) / (1.0 + a1 * z_inverse + a2 * z_inverse * z_inverse));
+
+			group.gain[section][lane] = (float)(1.0 / response);
+			group.a1[section][lane] = (float)a1;
+			group.a2[section][lane] = (float)a2;
+
+		}
+
+	}
+
+	void design_decimation_filter(DecimationStage &stage) { //6th order Butterworth low pass as three prewarped sections
+
+		double omega = 2.0 * pi * decimation_cutoff;
+		double cos_omega = cos(omega);
+
+		for (int section = 0; section < num_sections; section++) {
+
+			double q = 1.0 / (2.0 * sin((2.0 * section + 1.0) * pi / (4.0 * num_sections)));
+			double alpha = sin(omega) / (2.0 * q);
+			double a0 = 1.0 + alpha;
+
+			Biquad &biquad = stage.sections[section];
+
+			biquad.b0 = ((1.0 - cos_omega) * 0.5) / a0;
+			biquad.b1 = (1.0 - cos_omega) / a0;
+			biquad.b2 = biquad.b0;
+			biquad.a1 = (-2.0 * cos_omega) / a0;
+			biquad.a2 = (1.0 - alpha) / a0;
+
+		}
+
+	}
+
+	static void decimate(DecimationStage &stage, const float* input, int num_input, float* output, int &num_output) {
+
+		num_output = 0;
+
+		for (int sample = 0; sample < num_input; sample++) {
+
+			double y = input[sample];
+
+			for (int section = 0; section < num_sections; section++) {
+
+				y = stage.sections[section].process(y);
+
+			}
+
+			if (stage.keep_next) {
+
+				output[num_output++] = (float)y;
+
+			}
+
+			stage.keep_next = !stage.keep_next;
+
+		}
+
+	}
+
+	static void process_group(BandGroup &group, const float* input, int num_samples) {
+
+#if SOUNDVIEW_OCTAVE_BANDS_SSE
+
+		__m128 gain[num_sections], a1[num_sections], a2[num_sections], z1[num_sections], z2[num_sections];
+
+		for (int section = 0; section < num_sections; section++) {
+
+			gain[section] = _mm_loadu_ps(group.gain[section]);
+			a1[section] = _mm_loadu_ps(group.a1[section]);
+			a2[section] = _mm_loadu_ps(group.a2[section]);
+			z1[section] = _mm_loadu_ps(group.z1[section]);
+			z2[section] = _mm_loadu_ps(group.z2[section]);
+
+		}
+
+		__m128 mean_square = _mm_loadu_ps(group.mean_square);
+		__m128 smoothing = _mm_set1_ps(group.smoothing);
+		__m128 zero = _mm_setzero_ps();
+
+		for (int sample = 0; sample < num_samples; sample++) {
+
+			__m128 x = _mm_set1_ps(input[sample]);
+
+			for (int section = 0; section < num_sections; section++) {
+
+				__m128 scaled_input = _mm_mul_ps(gain[section], x);
+				__m128 y = _mm_add_ps(scaled_input, z1[section]);
+
+				z1[section] = _mm_sub_ps(z2[section], _mm_mul_ps(a1[section], y));
+				z2[section] = _mm_sub_ps(zero, _mm_add_ps(scaled_input, _mm_mul_ps(a2[section], y)));
+
+				x = y;
+
+			}
+
+			mean_square = _mm_add_ps(mean_square, _mm_mul_ps(smoothing, _mm_sub_ps(_mm_mul_ps(x, x), mean_square)));
+
+		}
+
+		for (int section = 0; section < num_sections; section++) {
+
+			_mm_storeu_ps(group.z1[section], z1[section]);
+			_mm_storeu_ps(group.z2[section], z2[section]);
+
+		}
+
+		_mm_storeu_ps(group.mean_square, mean_square);
+
+#else
+
+		for (int lane = 0; lane < group.num_bands; lane++) {
+
+			for (int sample = 0; sample < num_samples; sample++) {
+
+				float x = input[sample];
+
+				for (int section = 0; section < num_sections; section++) {
+
+					float scaled_input = group.gain[section][lane] * x;
+					float y = scaled_input + group.z1[section][lane];
+
+					group.z1[section][lane] = group.z2[section][lane] - group.a1[section][lane] * y;
+					group.z2[section][lane] = -(scaled_input + group.a2[section][lane] * y);
+
+					x = y;
+
+				}
+
+				group.mean_square[lane] += group.smoothing * (x * x - group.mean_square[lane]);
+
+			}
+
+		}
+
+#endif
+
+	}
+
+};
@@ -0,0 +1,591 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include "analysis_engine.h"
+#include "loudness_meter.h"
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <memory>
+
+//Headless analysis of audio files through the same AnalysisEngine the display uses. The file is streamed one hop at a
+//time so memory use does not depend on the length of the recording. Each analysis frame is written as one row of
+//either averaged RTA spectra or spectrogram rows, as CSV or as a compact little endian binary file. With --loudness
+//every channel is also streamed through a LoudnessMeter for R128 file QC, in the same pass.
+
+struct OfflineAnalysisSettings
+{
+
+	File input_file;
+	File output_file;
+
+	int fft_size{ 16384 };
+	int hop_size{ 0 }; //must be <= fft_size, 0 = fft_size / 4
+	int num_averages{ 1 };
+	AveragingMode averaging_mode{ mean_averaging };
+	int smoothing_window_type{ 0 };
+	int smoothing_window_size{ 1 };
+	int input_channel{ 0 };
+
+	bool spectrogram_rows{ false }; //false = averaged RTA spectra, true = spectrogram rows on the log frequency axis
+	bool binary_output{ false };
+	bool measure_loudness{ false }; //integrated loudness and loudness range of all channels
+
+	int spectrogram_num_frequencies{ 1024 };
+	float lowest_frequency{ 20.0f };
+	float highest_frequency{ 20000.0f };
+
+};
+
+struct OfflineAnalysisReport
+{
+
+	bool success{ false };
+	String error_message;
+
+	double audio_seconds{ 0.0 };
+	double wall_seconds{ 0.0 };
+	int64 frames_written{ 0 };
+
+	bool loudness_measured{ false };
+	LoudnessReadings loudness;
+
+	double get_realtime_factor() const { //audio seconds processed per wall second
+
+		return wall_seconds > 0.0 ? audio_seconds / wall_seconds : 0.0;
+
+	}
+
+};
+
+class AnalysisOutputWriter
+{
+public:
+
+	//Binary layout: "SVA1", int32 row type (0 = RTA, 1 = spectrogram), int32 num columns, float64 sample rate,
+	//int32 fft size, int32 hop size, float32 column frequencies[num columns], then per row float64 time (s) followed
+	//by float32 dBFS values[num columns].
+
+	AnalysisOutputWriter(const File& file, bool binary) : binary_output(binary) {
+
+		file.deleteFile();
+
+		FileOutputStream* file_stream = new FileOutputStream(file, 1 << 20);
+
+		stream_opened = file_stream->openedOk();
+
+		output_stream.reset(file_stream);
+
+	};
+
+	AnalysisOutputWriter(OutputStream* stream_to_own, bool binary, int columns) : binary_output(binary) { //rows only, no header
+
+		output_stream.reset(stream_to_own);
+
+		stream_opened = true;
+
+		num_columns = columns;
+
+	};
+
+	~AnalysisOutputWriter() {};
+
+	bool opened_ok() { return stream_opened; }
+
+	void write_header(const std::vector<float> &column_frequencies, bool spectrogram_rows, double sample_rate, int fft_size, int hop_size) {
+
+		num_columns = column_frequencies.size();
+
+		if (binary_output) {
+
+			output_stream->write("SVA1", 4);
+			output_stream->writeInt(spectrogram_rows ? 1 : 0);
+			output_stream->writeInt(num_columns);
+			output_stream->writeDouble(sample_rate);
+			output_stream->writeInt(fft_size);
+			output_stream->writeInt(hop_size);
+			output_stream->write(column_frequencies.data(), num_columns * sizeof(float));
+
+			return;
+
+		}
+
+		output_stream->writeText("time_s", false, false, nullptr);
+
+		for (int column = 0; column < num_columns; column++) {
+
+			write_csv_value(column_frequencies[column], ",%.3f");
+
+		}
+
+		output_stream->writeText("\n", false, false, nullptr);
+
+	}
+
+	void write_row(double time_seconds, const float* values_dBFS) {
+
+		if (binary_output) {
+
+			output_stream->writeDouble(time_seconds);
+			output_stream->write(values_dBFS, num_columns * sizeof(float)); //x86 is little endian, matching writeDouble
+
+			return;
+
+		}
+
+		write_csv_value(time_seconds, "%.6f");
+
+		for (int column = 0; column < num_columns; column++) {
+
+			write_csv_value(values_dBFS[column], ",%.2f");
+
+		}
+
+		output_stream->writeText("\n", false, false, nullptr);
+
+	}
+
+	void write_raw(const void* data, size_t num_bytes) { //appends rows already formatted by another writer
+
+		output_stream->write(data, num_bytes);
+
+	}
+
+	void flush() { output_stream->flush(); }
+
+	int get_num_columns() const { return num_columns; }
+
+private:
+
+	std::unique_ptr<OutputStream> output_stream;
+	bool stream_opened{ false };
+	bool binary_output;
+	int num_columns{ 0 };
+
+	char csv_value[64];
+
+	void write_csv_value(double value, const char* format) {
+
+		int length = snprintf(csv_value, sizeof csv_value, format, value);
+
+		output_stream->write(csv_value, length);
+
+	}
+
+};
+
+class OfflineAnalyser
+{
+public:
+
+	OfflineAnalyser(OfflineAnalysisSettings analysis_settings) : settings(analysis_settings) {};
+
+	~OfflineAnalyser() {};
+
+	OfflineAnalysisReport run() {
+
+		OfflineAnalysisReport report;
+
+		auto start = std::chrono::steady_clock::now();
+
+		AudioFormatManager format_manager;
+		format_manager.registerBasicFormats(); //WAV, AIFF, FLAC, Ogg
+
+		std::unique_ptr<AudioFormatReader> reader(format_manager.createReaderFor(settings.input_file));
+
+		if (!check_reader(reader.get(), report)) {
+
+			return report;
+
+		}
+
+		AnalysisOutputWriter writer(settings.output_file, settings.binary_output);
+
+		if (!writer.opened_ok()) {
+
+			report.error_message = "Could not write " + settings.output_file.getFullPathName();
+
+			return report;
+
+		}
+
+		AnalysisEngine analysis_engine{ settings.fft_size, settings.spectrogram_num_frequencies, settings.lowest_frequency, settings.highest_frequency };
+
+		configure_engine(analysis_engine, reader->sampleRate);
+
+		write_header(writer, analysis_engine);
+
+		int64 total_frames = count_frames(reader->lengthInSamples);
+
+		std::unique_ptr<LoudnessMeter> loudness_meter;
+
+		if (settings.measure_loudness) {
+
+			loudness_meter.reset(new LoudnessMeter((int)reader->numChannels));
+
+			configure_loudness_meter(*loudness_meter, *reader);
+
+		}
+
+		report.frames_written = analyse_frames(*reader, analysis_engine, writer, 0, total_frames, 0, loudness_meter.get());
+
+		if (loudness_meter != nullptr) { //the samples after the last whole frame
+
+			int64 samples_measured = total_frames > 0 ? (total_frames - 1) * settings.hop_size + settings.fft_size : 0;
+
+			measure_loudness(*reader, *loudness_meter, samples_measured, reader->lengthInSamples);
+
+			report.loudness = loudness_meter->get_readings();
+			report.loudness_measured = true;
+
+		}
+
+		writer.flush();
+
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+		report.audio_seconds = reader->lengthInSamples / reader->sampleRate;
+		report.wall_seconds = elapsed.count();
+		report.success = true;
+
+		return report;
+
+	}
+
+	static int run_from_command_line(const StringArray &arguments) { //returns the process exit code
+
+		OfflineAnalysisSettings settings;
+		String error_message;
+
+		if (!parse_arguments(arguments, settings, error_message)) {
+
+			std::cerr << error_message << std::endl << get_usage() << std::endl;
+
+			return 1;
+
+		}
+
+		OfflineAnalysisReport report = OfflineAnalyser(settings).run();
+
+		if (!report.success) {
+
+			std::cerr << report.error_message << std::endl;
+
+			return 1;
+
+		}
+
+		print_report(report);
+
+		return 0;
+
+	}
+
+	static bool parse_arguments(const StringArray &arguments, OfflineAnalysisSettings &settings, String &error_message) {
+
+		parse_analysis_options(arguments, settings);
+
+		if (settings.input_file == File()) {
+
+			error_message = "No input file given";
+
+			return false;
+
+		}
+
+		if (settings.output_file == File()) {
+
+			settings.output_file = settings.input_file.withFileExtension(settings.binary_output ? "sva" : "csv");
+
+		}
+
+		return validate_analysis_options(settings, error_message);
+
+	}
+
+	static void parse_analysis_options(const StringArray &arguments, OfflineAnalysisSettings &settings) {
+
+		for (int x = 0; x < arguments.size(); x++) {
+
+			String argument = arguments[x];
+			String value = arguments[x + 1].unquoted(); //StringArray returns an empty string when out of range
+
+			if (argument == "--analyse") { settings.input_file = File::getCurrentWorkingDirectory().getChildFile(value); x++; }
+			else if (argument == "--output") { settings.output_file = File::getCurrentWorkingDirectory().getChildFile(value); x++; }
+			else if (argument == "--fft") { settings.fft_size = value.getIntValue(); x++; }
+			else if (argument == "--hop") { settings.hop_size = value.getIntValue(); x++; }
+			else if (argument == "--averages") { settings.num_averages = value.getIntValue(); x++; }
+			else if (argument == "--averaging") { settings.averaging_mode = value == "median" ? median_averaging : (value == "trimmed" ? trimmed_mean_averaging : mean_averaging); x++; }
+			else if (argument == "--smoothing-type") { settings.smoothing_window_type = value.getIntValue(); x++; }
+			else if (argument == "--smoothing-size") { settings.smoothing_window_size = value.getIntValue(); x++; }
+			else if (argument == "--channel") { settings.input_channel = value.getIntValue(); x++; }
+			else if (argument == "--spectrogram") { settings.spectrogram_rows = true; }
+			else if (argument == "--binary") { settings.binary_output = true; }
+			else if (argument == "--loudness") { settings.measure_loudness = true; }
+
+		}
+
+	}
+
+	static bool validate_analysis_options(OfflineAnalysisSettings &settings, String &error_message) {
+
+		if (settings.fft_size < 16 || !isPowerOfTwo(settings.fft_size)) {
+
+			error_message = "FFT size must be a power of two";
+
+			return false;
+
+		}
+
+		if (settings.hop_size <= 0) {
+
+			settings.hop_size = settings.fft_size / 4;
+
+		}
+
+		settings.num_averages = jmax(1, settings.num_averages);
+
+		return true;
+
+	}
+
+	static String get_usage() {
+
+		return	"Usage: SoundView --analyse <audio file> [--output <file>] [--fft 16384] [--hop fft/4] [--averages 1]\n"
+				"                 [--averaging mean|median|trimmed] [--smoothing-type 0..2] [--smoothing-size 1..99] [--channel 0] [--spectrogram] [--binary] [--loudness]";
+
+	}
+
+	static void print_report(const OfflineAnalysisReport &report) {
+
+		std::cout	<< "Analysed " << report.audio_seconds << " s of audio in " << report.wall_seconds << " s ("
+					<< report.get_realtime_factor() << " audio s per wall s), " << report.frames_written << " frames" << std::endl;
+
+		if (report.loudness_measured) {
+
+			const LoudnessReadings &loudness = report.loudness;
+
+			std::cout	<< "Integrated " << format_loudness(loudness.integrated, loudness.integrated_valid, " LUFS")
+						<< ", loudness range " << format_loudness(loudness.loudness_range, loudness.range_valid, " LU")
+						<< ", max momentary " << format_loudness(loudness.max_momentary, loudness.momentary_valid, " LUFS")
+						<< ", max short-term " << format_loudness(loudness.max_short_term, loudness.short_term_valid, " LUFS") << std::endl;
+
+		}
+
+	}
+
+protected:
+
+	OfflineAnalysisSettings settings;
+
+	bool check_reader(AudioFormatReader* reader, OfflineAnalysisReport &report) {
+
+		if (reader == nullptr) {
+
+			report.error_message = "Could not open " + settings.input_file.getFullPathName() + " as an audio file";
+
+			return false;
+
+		}
+
+		if (settings.hop_size < 1 || settings.hop_size > settings.fft_size) {
+
+			report.error_message = "Hop size must be between 1 and the FFT size";
+
+			return false;
+
+		}
+
+		if (settings.input_channel < 0 || settings.input_channel >= (int)reader->numChannels) {
+
+			report.error_message = "The file only has " + String(reader->numChannels) + " channel(s)";
+
+			return false;
+
+		}
+
+		return true;
+
+	}
+
+	static String format_loudness(float value, bool valid, const char* unit) {
+
+		return valid ? String(value, 1) + unit : String("--");
+
+	}
+
+	void configure_loudness_meter(LoudnessMeter &loudness_meter, AudioFormatReader &reader) {
+
+		loudness_meter.set_sample_rate(reader.sampleRate);
+
+		if (reader.numChannels == 6) { //5.1 in WAV order, L R C LFE Ls Rs
+
+			loudness_meter.set_channel_weight(3, 0.0);
+			loudness_meter.set_channel_weight(4, 1.41);
+			loudness_meter.set_channel_weight(5, 1.41);
+
+		}
+
+	}
+
+	void measure_loudness(AudioFormatReader &reader, LoudnessMeter &loudness_meter, int64 start_sample, int64 end_sample) {
+
+		const int block_size = 65536;
+
+		AudioBuffer<float> read_buffer((int)reader.numChannels, block_size);
+
+		for (int64 block_start = start_sample; block_start < end_sample; block_start += block_size) {
+
+			int num_samples = (int)jmin((int64)block_size, end_sample - block_start);
+
+			reader.read(&read_buffer, 0, num_samples, block_start, true, true);
+
+			loudness_meter.process_block(read_buffer.getArrayOfReadPointers(), read_buffer.getNumChannels(), num_samples);
+
+		}
+
+	}
+
+	void configure_engine(AnalysisEngine &analysis_engine, double sample_rate) {
+
+		analysis_engine.set_sample_rate(sample_rate);
+		analysis_engine.set_num_averages(settings.num_averages);
+		analysis_engine.set_averaging_mode(settings.averaging_mode);
+		analysis_engine.set_smoothing(settings.smoothing_window_type, settings.smoothing_window_size);
+
+	}
+
+	void write_header(AnalysisOutputWriter &writer, AnalysisEngine &analysis_engine) {
+
+		if (settings.spectrogram_rows) {
+
+			writer.write_header(analysis_engine.get_spectrogram_frequencies(), true, analysis_engine.get_sample_rate(), settings.fft_size, settings.hop_size);
+
+		}
+
+		else {
+
+			const std::vector<float> &bin_frequencies = analysis_engine.get_bin_frequencies();
+
+			std::vector<float> column_frequencies(bin_frequencies.begin() + 1, bin_frequencies.end()); //the DC bin is not written
+
+			writer.write_header(column_frequencies, false, analysis_engine.get_sample_rate(), settings.fft_size, settings.hop_size);
+
+		}
+
+	}
+
+	int64 count_frames(int64 length_in_samples) {
+
+		if (length_in_samples < settings.fft_size) {
+
+			return 0;
+
+		}
+
+		return ((length_in_samples - settings.fft_size) / settings.hop_size) + 1;
+
+	}
+
+	//Analyses frames [first_frame, end_frame) where frame n covers samples [n * hop, n * hop + fft_size). Rows are only
+	//written from first_written_frame onwards, earlier frames just warm up the averager. Each sample read is passed to
+	//loudness_meter (if any) once, in order. Returns the rows written.
+
+	int64 analyse_frames(AudioFormatReader &reader, AnalysisEngine &analysis_engine, AnalysisOutputWriter &writer,
+						 int64 first_frame, int64 end_frame, int64 first_written_frame, LoudnessMeter* loudness_meter = nullptr) {
+
+		const int fft_size = settings.fft_size;
+		const int hop_size = settings.hop_size;
+
+		std::vector<double> frame_samples(fft_size);
+		AudioBuffer<float> read_buffer((int)reader.numChannels, fft_size);
+
+		std::vector<float> row_values;
+		int64 rows_written = 0;
+
+		for (int64 frame = first_frame; frame < end_frame; frame++) {
+
+			int64 frame_start = frame * hop_size;
+
+			if (frame == first_frame) {
+
+				reader.read(&read_buffer, 0, fft_size, frame_start, true, true);
+
+				if (loudness_meter != nullptr) {
+
+					loudness_meter->process_block(read_buffer.getArrayOfReadPointers(), read_buffer.getNumChannels(), fft_size);
+
+				}
+
+				const float* channel_samples = read_buffer.getReadPointer(settings.input_channel);
+
+				std::copy(channel_samples, channel_samples + fft_size, frame_samples.begin());
+
+			}
+
+			else {
+
+				reader.read(&read_buffer, 0, hop_size, frame_start + fft_size - hop_size, true, true);
+
+				if (loudness_meter != nullptr) {
+
+					loudness_meter->process_block(read_buffer.getArrayOfReadPointers(), read_buffer.getNumChannels(), hop_size);
+
+				}
+
+				const float* channel_samples = read_buffer.getReadPointer(settings.input_channel);
+
+				std::copy(frame_samples.begin() + hop_size, frame_samples.end(), frame_samples.begin());
+				std::copy(channel_samples, channel_samples + hop_size, frame_samples.end() - hop_size);
+
+			}
+
+			std::copy(frame_samples.begin(), frame_samples.end(), analysis_engine.get_input_samples());
+
+			analysis_engine.analyse_frame();
+
+			if (frame < first_written_frame) {
+
+				continue;
+
+			}
+
+			double frame_time = (frame_start + (fft_size / 2)) / analysis_engine.get_sample_rate(); //centre of the frame
+
+			get_row_values(analysis_engine, row_values);
+
+			writer.write_row(frame_time, row_values.data());
+
+			rows_written++;
+
+		}
+
+		return rows_written;
+
+	}
+
+	void get_row_values(AnalysisEngine &analysis_engine, std::vector<float> &row_values) {
+
+		if (settings.spectrogram_rows) {
+
+			row_values = analysis_engine.update_spectrogram_amplitudes();
+
+			return;
+
+		}
+
+		std::vector<float> rta_amplitudes = analysis_engine.get_rta_amplitudes();
+
+		row_values.resize(rta_amplitudes.size() - 1);
+
+		for (int x = 1; x < rta_amplitudes.size(); x++) {
+
+			row_values[x - 1] = analysis_engine.amp_to_dBFS(rta_amplitudes[x]);
+
+		}
+
+	}
+
+};
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+//Statistical spectra for long term monitoring: L10, L50 and L90, the level each bin exceeded for 10, 50 and 90% of
+//the frames since the last reset. The input is the unaveraged dBFS spectrogram row on a FixedFrequencyGrid, so the
+//bins stay put whatever the display shows. Every bin has a histogram of 0.25 dB buckets from -100 to +6 dBFS, and all
+//of them live in one contiguous [bins x buckets] array, so memory depends on the number of bins and never on how long
+//the measurement runs (1.8 MB for 1024 frequencies). Each percentile keeps its bucket per bin and the count below it,
+//and a new frame moves that position to the bucket that now holds the percentile. Usually that is a bucket or two
+//away, but with bimodal levels (a tone switching on and off) it can jump across many empty buckets, so each bin also
+//counts its frames per block of 16 buckets and the walk steps over whole blocks. A move then costs at most about 30
+//steps, where stepping bucket by bucket could take 424. The results are the bucket centres, as linear amplitudes like
+//the RTA.
+
+enum PercentileLevel { l10_level = 0, l50_level, l90_level, num_percentile_levels };
+
+class PercentileSpectrum
+{
+public:
+
+	PercentileSpectrum() {
+
+		bucket_amplitudes.resize(num_buckets);
+
+		for (int bucket = 0; bucket < num_buckets; bucket++) {
+
+			bucket_amplitudes[bucket] = (float)pow(10.0, (lowest_dB + (bucket + 0.5) * bucket_width) / 20.0);
+
+		}
+
+	};
+
+	~PercentileSpectrum() {};
+
+	void update(const std::vector<float> &levels_dB) { //one frame
+
+		int num_bins = (int)levels_dB.size();
+
+		if (num_bins != bins) { //new bins, the old histograms no longer line up
+
+			bins = num_bins;
+
+			bucket_counts.assign((size_t)bins * num_buckets, 0);
+			block_counts.assign((size_t)bins * num_blocks, 0);
+
+			for (int level = 0; level < num_percentile_levels; level++) {
+
+				percentile_buckets[level].assign(bins, 0);
+				counts_below[level].assign(bins, 0);
+				levels[level].assign(bins, 0.0f);
+
+			}
+
+			num_frames = 0;
+
+		}
+
+		num_frames++;
+
+		int64_t targets[num_percentile_levels]; //frames at or below the level
+
+		for (int level = 0; level < num_percentile_levels; level++) {
+
+			targets[level] = (percent_at_or_below[level] * num_frames + 99) / 100;
+
+		}
+
+		for (int bin = 0; bin < bins; bin++) {
+
+			uint32_t* counts = bucket_counts.data() + (size_t)bin * num_buckets;
+			uint32_t* blocks = block_counts.data() + (size_t)bin * num_blocks;
+
+			int bucket = get_bucket(levels_dB[bin]);
+
+			counts[bucket]++;
+			blocks[bucket / block_size]++;
+
+			for (int level = 0; level < num_percentile_levels; level++) {
+
+				int &position = percentile_buckets[level][bin];
+				int64_t &below = counts_below[level][bin];
+
+				if (bucket < position) {
+
+					below++;
+
+				}
+
+				//the smallest bucket whose cumulative count reaches the target, a whole block at a time where the target
+				//is not reached within it
+
+				while (below + counts[position] < targets[level]) {
+
+					if (position % block_size == 0 && below + blocks[position / block_size] < targets[level]) {
+
+						below += blocks[position / block_size];
+						position += block_size;
+
+						continue;
+
+					}
+
+					below += counts[position];
+					position++;
+
+				}
+
+				while (position > 0 && below >= targets[level]) {
+
+					if (position % block_size == 0 && below - blocks[position / block_size - 1] >= targets[level]) {
+
+						position -= block_size;
+						below -= blocks[position / block_size];
+
+						continue;
+
+					}
+
+					position--;
+					below -= counts[position];
+
+				}
+
+				levels[level][bin] = bucket_amplitudes[position];
+
+			}
+
+		}
+
+	}
+
+	void reset() { //the next update() starts a new measurement
+
+		bins = -1;
+
+		num_frames = 0;
+
+	}
+
+	int64_t get_num_frames() const { return num_frames; }
+
+	const std::vector<float>& get_levels(PercentileLevel level) const { return levels[level]; }
+
+private:
+
+	const double lowest_dB = -100.0;
+	const double bucket_width = 0.25;
+	static const int num_buckets = 424; //-100 to +6 dBFS
+	static const int block_size = 16; //buckets
+	static const int num_blocks = (num_buckets + block_size - 1) / block_size;
+
+	const int64_t percent_at_or_below[num_percentile_levels] = { 90, 50, 10 }; //exceeded 10, 50 and 90% of the time
+
+	int bins{ -1 };
+	int64_t num_frames{ 0 };
+
+	std::vector<uint32_t> bucket_counts; //[bin * num_buckets + bucket]
+	std::vector<uint32_t> block_counts; //[bin * num_blocks + bucket / block_size]
+	std::vector<int> percentile_buckets[num_percentile_levels];
+	std::vector<int64_t> counts_below[num_percentile_levels];
+	std::vector<float> levels[num_percentile_levels];
+
+	std::vector<float> bucket_amplitudes; //the centre of each bucket
+
+	int get_bucket(float level_dB) const {
+
+		double bucket = (level_dB - lowest_dB) / bucket_width;
+
+		return bucket > 0.0 ? (int)std::min(bucket, num_buckets - 1.0) : 0; //NaN lands in the lowest bucket too
+
+	}
+
+};
@@ -0,0 +1,253 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#include <vector>
+
+//Keeps the display inside its frame budget on slow machines. Each frame reports how long its analysis and render
+//stages took. Once per second the mean frame cost is compared with the frame period. Above step_down_load of the
+//period the governor steps one setting down, in this order: render rate, spectrogram width, smoothing cost, then
+//analysis (hop) rate. After restore_seconds in a row below restore_load it restores the most recently reduced setting.
+//Only GUI thread work is reduced. The audio callback does not depend on any of these settings, so it is never slowed.
+//Every decision is written to the JUCE Logger.
+
+struct QualitySettings
+{
+
+	int render_rate_hz;
+	int spectrogram_texture_width;
+	int max_smoothing_window_size; //odd, caps the user's smoothing window size
+	int analysis_interval; //analyse (and draw) every Nth frame
+
+};
+
+class QualityGovernor
+{
+public:
+
+	QualityGovernor() {
+
+		levels.assign(num_settings, 0);
+
+	};
+
+	~QualityGovernor() {};
+
+	void set_enabled(bool should_be_enabled) {
+
+		enabled = should_be_enabled;
+
+		if (!enabled) {
+
+			levels.assign(num_settings, 0);
+
+		}
+
+		start_new_window();
+
+	}
+
+	bool is_enabled() const { return enabled; }
+
+	bool is_reduced() const {
+
+		for (int x = 0; x < num_settings; x++) {
+
+			if (levels[x] > 0) return true;
+
+		}
+
+		return false;
+
+	}
+
+	QualitySettings get_settings() const {
+
+		QualitySettings settings;
+
+		settings.render_rate_hz = render_rates[levels[render_rate]];
+		settings.spectrogram_texture_width = spectrogram_widths[levels[spectrogram_width]];
+		settings.max_smoothing_window_size = smoothing_caps[levels[smoothing_cost]];
+		settings.analysis_interval = analysis_intervals[levels[analysis_rate]];
+
+		return settings;
+
+	}
+
+	//Call once per analysed frame with the stage times in seconds. Returns true when the settings have changed.
+
+	bool add_frame(double analysis_seconds, double render_seconds) {
+
+		if (!enabled) {
+
+			return false;
+
+		}
+
+		window_analysis_seconds += analysis_seconds;
+		window_render_seconds += render_seconds;
+		window_frames++;
+
+		QualitySettings settings = get_settings();
+
+		double frame_period = settings.analysis_interval / (settings.render_rate_hz * 1.0);
+
+		if (window_frames < 1.0 / frame_period) { //evaluate about once a second
+
+			return false;
+
+		}
+
+		double mean_analysis = window_analysis_seconds / window_frames;
+		double mean_render = window_render_seconds / window_frames;
+		double load = (mean_analysis + mean_render) / frame_period;
+
+		String costs =	"frame cost " + String((mean_analysis + mean_render) * 1000.0, 1) + " ms (analysis " + String(mean_analysis * 1000.0, 1) +
+						", render " + String(mean_render * 1000.0, 1) + ") is " + String(load * 100.0, 0) + "% of the " +
+						String(frame_period * 1000.0, 1) + " ms frame period";
+
+		start_new_window();
+
+		if (load > step_down_load) {
+
+			headroom_windows = 0;
+
+			for (int setting = 0; setting < num_settings; setting++) {
+
+				if (levels[setting] + 1 < get_num_levels(setting)) {
+
+					String before = describe_setting(setting);
+
+					levels[setting]++;
+
+					log_decision(costs + ", reducing " + before + " to " + describe_setting(setting));
+
+					return true;
+
+				}
+
+			}
+
+			return false; //already at the lowest quality
+
+		}
+
+		if (load < restore_load && is_reduced()) {
+
+			headroom_windows++;
+
+			if (headroom_windows < restore_seconds) {
+
+				return false;
+
+			}
+
+			headroom_windows = 0;
+
+			for (int setting = num_settings - 1; setting >= 0; setting--) {
+
+				if (levels[setting] > 0) {
+
+					String before = describe_setting(setting);
+
+					levels[setting]--;
+
+					log_decision(costs + ", restoring " + before + " to " + describe_setting(setting));
+
+					return true;
+
+				}
+
+			}
+
+		}
+
+		else {
+
+			headroom_windows = 0;
+
+		}
+
+		return false;
+
+	}
+
+	String describe_reductions() const { //empty at full quality
+
+		StringArray reductions;
+
+		for (int setting = 0; setting < num_settings; setting++) {
+
+			if (levels[setting] > 0) {
+
+				reductions.add(describe_setting(setting));
+
+			}
+
+		}
+
+		return reductions.joinIntoString(", ");
+
+	}
+
+private:
+
+	enum Setting { render_rate = 0, spectrogram_width, smoothing_cost, analysis_rate, num_settings };
+
+	std::vector<int> render_rates{ 30, 20, 15, 10 };
+	std::vector<int> spectrogram_widths{ 1024, 512, 256 }; //multiples of 4 for the texture upload
+	std::vector<int> smoothing_caps{ 99, 31, 9, 1 };
+	std::vector<int> analysis_intervals{ 1, 2, 3 };
+
+	const double step_down_load = 0.6;
+	const double restore_load = 0.25;
+	const int restore_seconds = 3;
+
+	bool enabled{ true };
+
+	std::vector<int> levels; //0 = full quality
+
+	double window_analysis_seconds{ 0.0 };
+	double window_render_seconds{ 0.0 };
+	int window_frames{ 0 };
+	int headroom_windows{ 0 };
+
+	void start_new_window() {
+
+		window_analysis_seconds = 0.0;
+		window_render_seconds = 0.0;
+		window_frames = 0;
+
+	}
+
+	int get_num_levels(int setting) const {
+
+		switch (setting)
+		{
+		case render_rate: return (int)render_rates.size();
+		case spectrogram_width: return (int)spectrogram_widths.size();
+		case smoothing_cost: return (int)smoothing_caps.size();
+		default: return (int)analysis_intervals.size();
+		}
+
+	}
+
+	String describe_setting(int setting) const {
+
+		switch (setting)
+		{
+		case render_rate: return "render rate " + String(render_rates[levels[setting]]) + " Hz";
+		case spectrogram_width: return "spectrogram width " + String(spectrogram_widths[levels[setting]]);
+		case smoothing_cost: return "smoothing window <= " + String(smoothing_caps[levels[setting]]);
+		default: return "analysis every " + String(analysis_intervals[levels[setting]]) + " frames";
+		}
+
+	}
+
+	void log_decision(const String &message) {
+
+		Logger::writeToLog("Quality governor: " + message);
+
+	}
+
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+//Single producer / single consumer multichannel sample FIFO. The audio callback pushes, one worker thread pops.
+//Neither side ever locks or allocates, so it is safe to push from getNextAudioBlock. If the consumer falls behind
+//the newest samples are dropped (all channels together, so channels stay aligned) and counted.
+//Capacity is rounded up to a power of two.
+
+class SampleFifo
+{
+public:
+
+	SampleFifo(int num_channels, int capacity) {
+
+		set_size(num_channels, capacity);
+
+	};
+
+	~SampleFifo() {};
+
+	void set_size(int num_channels, int capacity) { //not safe while either side is running
+
+		fifo_channels = num_channels;
+
+		fifo_capacity = 1;
+
+		while (fifo_capacity < capacity) {
+
+			fifo_capacity *= 2; //power of two so the free running counters stay valid when they wrap
+
+		}
+
+		fifo_buffer.clear();
+		fifo_buffer.resize(fifo_channels, std::vector<float>(fifo_capacity, 0.0));
+
+		reset();
+
+	}
+
+	void reset() {
+
+		write_count.store(0);
+		read_count.store(0);
+		dropped_samples.store(0);
+
+	}
+
+	int push(const float* const* input_channels, int num_samples) { //producer side only
+
+		unsigned int write = write_count.load(std::memory_order_relaxed);
+		unsigned int read = read_count.load(std::memory_order_acquire);
+
+		int free_space = fifo_capacity - (int)(write - read);
+
+		int samples_to_write = std::min(num_samples, free_space);
+
+		if (samples_to_write < num_samples) {
+
+			dropped_samples.fetch_add(num_samples - samples_to_write, std::memory_order_relaxed);
+
+		}
+
+		int start = write % fifo_capacity;
+		int first_part = std::min(samples_to_write, fifo_capacity - start);
+
+		for (int channel = 0; channel < fifo_channels; channel++) {
+
+			float* destination = fifo_buffer[channel].data();
+
+			if (input_channels[channel] == nullptr) {
+
+				std::fill(destination + start, destination + start + first_part, 0.0f);
+				std::fill(destination, destination + (samples_to_write - first_part), 0.0f);
+
+				continue;
+
+			}
+
+			std::copy(input_channels[channel], input_channels[channel] + first_part, destination + start);
+			std::copy(input_channels[channel] + first_part, input_channels[channel] + samples_to_write, destination);
+
+		}
+
+		write_count.store(write + samples_to_write, std::memory_order_release);
+
+		return samples_to_write;
+
+	}
+
+	int pop(float* const* output_channels, int num_samples) { //consumer side only
+
+		unsigned int read = read_count.load(std::memory_order_relaxed);
+		unsigned int write = write_count.load(std::memory_order_acquire);
+
+		int samples_to_read = std::min(num_samples, (int)(write - read));
+
+		int start = read % fifo_capacity;
+		int first_part = std::min(samples_to_read, fifo_capacity - start);
+
+		for (int channel = 0; channel < fifo_channels; channel++) {
+
+			const float* source = fifo_buffer[channel].data();
+
+			std::copy(source + start, source + start + first_part, output_channels[channel]);
+			std::copy(source, source + (samples_to_read - first_part), output_channels[channel] + first_part);
+
+		}
+
+		read_count.store(read + samples_to_read, std::memory_order_release);
+
+		return samples_to_read;
+
+	}
+
+	int get_num_ready() const {
+
+		return (int)(write_count.load(std::memory_order_acquire) - read_count.load(std::memory_order_relaxed));
+
+	}
+
+	int get_num_channels() const { return fifo_channels; }
+
+	int get_capacity() const { return fifo_capacity; }
+
+	int get_dropped_samples() const { return dropped_samples.load(std::memory_order_relaxed); }
+
+private:
+
+	std::vector<std::vector<float>> fifo_buffer;
+
+	int fifo_channels{ 1 };
+	int fifo_capacity{ 1 };
+
+	std::atomic<unsigned int> write_count{ 0 }, read_count{ 0 }; //free running, wraparound is handled by unsigned arithmetic
+	std::atomic<int> dropped_samples{ 0 };
+
+};
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "JuceHeader.h"
+
+#include <vector>
+#include <atomic>
+#include <limits>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+#endif
+
+//Counts zeroed (exactly 0), out of range (finite but beyond +-1) and NaN/Inf samples. Clipping is left to the level
+//meter's over counters, which also catch inter-sample peaks. Every block from the audio callback is scanned once with
+//a vectorised kernel. The counts are published through atomics into a ring of one second periods, so the GUI can read
+//the totals over the last num_periods seconds without locking or copying samples.
+
+struct SampleHealthCounts
+{
+
+	int64 zeroed{ 0 };
+	int64 out_of_range{ 0 };
+	int64 non_finite{ 0 };
+
+};
+
+class AudioPeformanceEngine
+{
+public:
+
+	AudioPeformanceEngine(int num_periods) :
+		num_sampling_periods(jmax(1, num_periods)),
+		period_counts(num_sampling_periods * num_count_types)
+	{
+		reset();
+	};
+
+	~AudioPeformanceEngine() {};
+
+	void set_sample_rate(double sample_rate) { //call while the audio callback is stopped, e.g. from prepareToPlay
+
+		samples_per_period = jmax(1, (int)sample_rate);
+
+		reset();
+
+	}
+
+	void reset() {
+
+		for (int x = 0; x < period_counts.size(); x++) {
+
+			period_counts[x].store(0);
+
+		}
+
+		for (int x = 0; x < num_count_types; x++) {
+
+			current_period_counts[x] = 0;
+			total_counts[x].store(0);
+
+		}
+
+		samples_in_current_period = 0;
+		completed_periods = 0;
+
+	}
+
+	void process_block(const float* samples, int num_samples) { //audio thread only
+
+		while (num_samples > 0) { //split the block where it crosses a period boundary
+
+			int samples_to_count = jmin(num_samples, samples_per_period - samples_in_current_period);
+
+			int block_counts[num_count_types];
+
+			count_samples(samples, samples_to_count, block_counts);
+
+			for (int x = 0; x < num_count_types; x++) {
+
+				current_period_counts[x] += block_counts[x];
+				total_counts[x].fetch_add(block_counts[x], std::memory_order_relaxed);
+
+			}
+
+			samples += samples_to_count;
+			num_samples -= samples_to_count;
+			samples_in_current_period += samples_to_count;
+
+			if (samples_in_current_period == samples_per_period) {
+
+				int slot = (int)(completed_periods % num_sampling_periods) * num_count_types;
+
+				for (int x = 0; x < num_count_types; x++) {
+
+					period_counts[slot + x].store(current_period_counts[x], std::memory_order_relaxed);
+					current_period_counts[x] = 0;
+
+				}
+
+				completed_periods++;
+				samples_in_current_period = 0;
+
+			}
+
+		}
+
+	}
+
+	SampleHealthCounts get_recent_counts() const { //sum over the last num_periods completed periods
+
+		int64 counts[num_count_types] = { 0, 0, 0 };
+
+		for (int x = 0; x < period_counts.size(); x++) {
+
+			counts[x % num_count_types] += period_counts[x].load(std::memory_order_relaxed);
+
+		}
+
+		return make_counts(counts);
+
+	}
+
+	SampleHealthCounts get_total_counts() const { //since the last reset
+
+		int64 counts[num_count_types];
+
+		for (int x = 0; x < num_count_types; x++) {
+
+			counts[x] = total_counts[x].load(std::memory_order_relaxed);
+
+		}
+
+		return make_counts(counts);
+
+	}
+
+	//counts[0..2] = zeroed, out of range, non finite
+
+	static void count_samples(const float* samples, int num_samples, int* counts) {
+
+		int zeroed = 0, out_of_range = 0, non_finite = 0;
+		int x = 0;
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+		//each comparison gives all ones (-1) per matching lane, so subtracting the masks counts matches per lane
+
+		const __m128 sign_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 infinity = _mm_set1_ps(std::numeric_limits<float>::infinity());
+
+		__m128i zeroed_lanes = _mm_setzero_si128(), out_of_range_lanes = _mm_setzero_si128(), non_finite_lanes = _mm_setzero_si128();
+
+		for (; x + 4 <= num_samples; x += 4) {
+
+			__m128 value = _mm_loadu_ps(samples + x);
+			__m128 magnitude = _mm_and_ps(value, sign_mask);
+
+			__m128 is_zeroed = _mm_cmpeq_ps(value, zero);
+			__m128 is_out_of_range = _mm_and_ps(_mm_cmpgt_ps(magnitude, one), _mm_cmplt_ps(magnitude, infinity));
+			__m128 is_non_finite = _mm_cmpnlt_ps(magnitude, infinity); //true for +-Inf and for NaN, which compares unordered
+
+			zeroed_lanes = _mm_sub_epi32(zeroed_lanes, _mm_castps_si128(is_zeroed));
+			out_of_range_lanes = _mm_sub_epi32(out_of_range_lanes, _mm_castps_si128(is_out_of_range));
+			non_finite_lanes = _mm_sub_epi32(non_finite_lanes, _mm_castps_si128(is_non_finite));
+
+		}
+
+		zeroed = sum_lanes(zeroed_lanes);
+		out_of_range = sum_lanes(out_of_range_lanes);
+		non_finite = sum_lanes(non_finite_lanes);
+
+#endif
+
+		for (; x < num_samples; x++) {
+
+			float magnitude = std::abs(samples[x]);
+
+			if (samples[x] == 0.0f) { zeroed++; }
+			else if (!std::isfinite(samples[x])) { non_finite++; }
+			else if (magnitude > 1.0f) { out_of_range++; }
+
+		}
+
+		counts[0] = zeroed;
+		counts[1] = out_of_range;
+		counts[2] = non_finite;
+
+	}
+
+private:
+
+	static const int num_count_types = 3;
+
+	int num_sampling_periods;
+	int samples_per_period{ 48000 };
+
+	std::vector<std::atomic<int64>> period_counts; //num_sampling_periods slots of num_count_types counts
+	std::atomic<int64> total_counts[num_count_types];
+
+	//audio thread state
+
+	int64 current_period_counts[num_count_types];
+	int samples_in_current_period{ 0 };
+	int64 completed_periods{ 0 };
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+	static int sum_lanes(__m128i lanes) {
+
+		lanes = _mm_add_epi32(lanes, _mm_shuffle_epi32(lanes, _MM_SHUFFLE(1, 0, 3, 2)));
+		lanes = _mm_add_epi32(lanes, _mm_shuffle_epi32(lanes, _MM_SHUFFLE(2, 3, 0, 1)));
+
+		return _mm_cvtsi128_si32(lanes);
+
+	}
+
+#endif
+
+	static SampleHealthCounts make_counts(const int64* counts) {
+
+		SampleHealthCounts sample_health_counts;
+
+		sample_health_counts.zeroed = counts[0];
+		sample_health_counts.out_of_range = counts[1];
+		sample_health_counts.non_finite = counts[2];
+
+		return sample_health_counts;
+
+	}
+
+};
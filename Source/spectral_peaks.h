@@ -0,0 +1,329 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+ #include <xmmintrin.h>
+ #define SOUNDVIEW_SPECTRAL_PEAKS_SSE 1
+#endif
+
+//The strongest spectral peaks of each frame, followed from frame to frame. One vectorised pass over the linear
+//amplitudes marks the bins above both neighbours, raising the bar to the weakest peak kept once the list is full, so
+//only a handful of bins are looked at any closer. A peak must also stand prominence_dB above the bins three either
+//side, which are outside a Hann window's main lobe. Its frequency is refined with a parabola through the log
+//magnitudes of the three bins (exact for a Gaussian, within a few hundredths of a bin for a Hann window). Peaks are
+//then matched to the tracks of the previous frames, strongest first, to the nearest unclaimed track within a few bins.
+//A matched track follows the peak, a track unmatched for a few frames ends, and a peak with no track starts one. A
+//track matched in the latest frame and in at least stable_frames frames is a stable partial. Frequencies need not be
+//evenly spaced, so the multi-resolution and constant-Q bins work too. Nothing is allocated per frame.
+
+struct SpectralPeak
+{
+
+	float frequency{ 0.0f }; //Hz, interpolated
+	float level_dB{ 0.0f }; //interpolated, dB of the linear amplitude
+	float bin{ 0.0f }; //fractional bin
+
+};
+
+struct SpectralPeakTrack
+{
+
+	int id{ 0 };
+	float frequency{ 0.0f };
+	float level_dB{ 0.0f };
+	int frames{ 0 }; //frames it was matched in
+	int missed_frames{ 0 };
+	bool matched{ false }; //in the latest frame
+
+};
+
+class SpectralPeakTracker
+{
+public:
+
+	SpectralPeakTracker() {
+
+		set_max_peaks(8);
+
+	};
+
+	~SpectralPeakTracker() {};
+
+	void set_max_peaks(int num_peaks) {
+
+		max_peaks = std::max(1, num_peaks);
+
+		peaks.reserve(max_peaks);
+		peak_bins.reserve(max_peaks);
+		tracks.reserve(max_peaks * 2);
+		track_claimed.reserve(max_peaks * 2);
+
+	}
+
+	void set_min_level(float level_dB) { min_level_dB = level_dB; }
+
+	void set_prominence(float dB) { prominence_dB = std::max(0.0f, dB); }
+
+	void update(const std::vector<float> &amplitudes, const std::vector<float> &frequencies) { //one frame, linear amplitudes
+
+		find_peaks(amplitudes, frequencies);
+
+		track_peaks(frequencies);
+
+	}
+
+	void reset() {
+
+		peaks.clear();
+		tracks.clear();
+
+	}
+
+	const std::vector<SpectralPeak>& get_peaks() const { return peaks; } //latest frame, strongest first
+
+	const std::vector<SpectralPeakTrack>& get_tracks() const { return tracks; }
+
+	bool is_stable(const SpectralPeakTrack &track) const { return track.matched && track.frames >= stable_frames; }
+
+private:
+
+	int max_peaks{ 8 };
+	float min_level_dB{ -90.0f };
+	float prominence_dB{ 6.0f };
+
+	static const int prominence_offset = 3; //bins
+	const float match_bins = 3.0f;
+	static const int stable_frames = 4;
+	static const int max_missed_frames = 3;
+	const float track_smoothing = 0.5f; //of the frequency, per frame
+
+	std::vector<SpectralPeak> peaks;
+	std::vector<int> peak_bins;
+	std::vector<SpectralPeakTrack> tracks;
+	std::vector<bool> track_claimed;
+	int next_track_id{ 1 };
+
+	void find_peaks(const std::vector<float> &amplitudes, const std::vector<float> &frequencies) {
+
+		peaks.clear();
+		peak_bins.clear();
+
+		int num_bins = (int)std::min(amplitudes.size(), frequencies.size());
+
+		if (num_bins < 2 * prominence_offset + 1) {
+
+			return;
+
+		}
+
+		const float* values = amplitudes.data();
+
+		float min_amplitude = powf(10.0f, min_level_dB / 20.0f);
+		float prominence_ratio = powf(10.0f, prominence_dB / 20.0f);
+
+		float bar = min_amplitude; //the weakest peak kept, once the list is full
+
+		int first = prominence_offset;
+		int last = num_bins - prominence_offset; //exclusive
+
+		int x = first;
+
+#ifdef SOUNDVIEW_SPECTRAL_PEAKS_SSE
+
+		for (; x + 4 <= last; x += 4) {
+
+			__m128 centre = _mm_loadu_ps(values + x);
+
+			__m128 maxima = _mm_and_ps(_mm_cmpgt_ps(centre, _mm_loadu_ps(values + x - 1)), _mm_cmpge_ps(centre, _mm_loadu_ps(values + x + 1)));
+
+			int mask = _mm_movemask_ps(_mm_and_ps(maxima, _mm_cmpgt_ps(centre, _mm_set1_ps(bar))));
+
+			while (mask != 0) {
+
+				int lane = 0;
+
+				while (((mask >> lane) & 1) == 0) { lane++; }
+
+				mask &= mask - 1;
+
+				consider_bin(values, x + lane, prominence_ratio, bar);
+
+			}
+
+		}
+
+#endif
+
+		for (; x < last; x++) {
+
+			if (values[x] > values[x - 1] && values[x] >= values[x + 1] && values[x] > bar) {
+
+				consider_bin(values, x, prominence_ratio, bar);
+
+			}
+
+		}
+
+		for (int peak = 0; peak < peak_bins.size(); peak++) {
+
+			peaks.push_back(interpolate_peak(values, frequencies, peak_bins[peak]));
+
+		}
+
+	}
+
+	void consider_bin(const float* values, int bin, float prominence_ratio, float &bar) { //keeps peak_bins strongest first
+
+		float value = values[bin];
+
+		if (value < values[bin - prominence_offset] * prominence_ratio || value < values[bin + prominence_offset] * prominence_ratio) {
+
+			return;
+
+		}
+
+		if ((int)peak_bins.size() == max_peaks) {
+
+			peak_bins.pop_back();
+
+		}
+
+		int position = (int)peak_bins.size();
+
+		while (position > 0 && values[peak_bins[position - 1]] < value) {
+
+			position--;
+
+		}
+
+		peak_bins.insert(peak_bins.begin() + position, bin);
+
+		if ((int)peak_bins.size() == max_peaks) {
+
+			bar = std::max(bar, values[peak_bins.back()]);
+
+		}
+
+	}
+
+	SpectralPeak interpolate_peak(const float* values, const std::vector<float> &frequencies, int bin) const {
+
+		//a parabola through the log magnitudes: a Gaussian through the magnitudes
+
+		float left = logf(std::max(values[bin - 1], 1e-30f));
+		float centre = logf(std::max(values[bin], 1e-30f));
+		float right = logf(std::max(values[bin + 1], 1e-30f));
+
+		float curvature = left - 2.0f * centre + right;
+
+		float offset = curvature < 0.0f ? limit_offset(0.5f * (left - right) / curvature) : 0.0f;
+
+		SpectralPeak peak;
+
+		peak.bin = bin + offset;
+
+		peak.level_dB = (centre - 0.25f * (left - right) * offset) * (20.0f / logf(10.0f));
+
+		float spacing = offset >= 0.0f ? frequencies[bin + 1] - frequencies[bin] : frequencies[bin] - frequencies[bin - 1];
+
+		peak.frequency = frequencies[bin] + offset * spacing;
+
+		return peak;
+
+	}
+
+	static float limit_offset(float offset) { return std::max(-0.5f, std::min(0.5f, offset)); }
+
+	void track_peaks(const std::vector<float> &frequencies) {
+
+		track_claimed.assign(tracks.size(), false);
+
+		for (int track = 0; track < tracks.size(); track++) {
+
+			tracks[track].matched = false;
+
+		}
+
+		for (int peak = 0; peak < peaks.size(); peak++) { //strongest first, so a strong peak keeps its track
+
+			const SpectralPeak &new_peak = peaks[peak];
+
+			int bin = std::min((int)new_peak.bin, (int)frequencies.size() - 2);
+
+			float tolerance = match_bins * (frequencies[bin + 1] - frequencies[bin]);
+
+			int nearest = -1;
+			float nearest_distance = tolerance;
+
+			for (int track = 0; track < tracks.size(); track++) {
+
+				float distance = std::abs(tracks[track].frequency - new_peak.frequency);
+
+				if (!track_claimed[track] && distance <= nearest_distance) {
+
+					nearest = track;
+					nearest_distance = distance;
+
+				}
+
+			}
+
+			if (nearest >= 0) {
+
+				SpectralPeakTrack &track = tracks[nearest];
+
+				track.frequency += (new_peak.frequency - track.frequency) * (1.0f - track_smoothing);
+				track.level_dB = new_peak.level_dB;
+				track.frames++;
+				track.missed_frames = 0;
+				track.matched = true;
+
+				track_claimed[nearest] = true;
+
+			}
+
+			else if (tracks.size() < max_peaks * 2) {
+
+				SpectralPeakTrack track;
+
+				track.id = next_track_id++;
+				track.frequency = new_peak.frequency;
+				track.level_dB = new_peak.level_dB;
+				track.frames = 1;
+				track.matched = true;
+
+				tracks.push_back(track);
+				track_claimed.push_back(true);
+
+			}
+
+		}
+
+		//tracks that were not matched this frame age, and end after a few frames
+
+		int kept = 0;
+
+		for (int track = 0; track < tracks.size(); track++) {
+
+			if (!tracks[track].matched) {
+
+				tracks[track].missed_frames++;
+
+			}
+
+			if (tracks[track].missed_frames <= max_missed_frames) {
+
+				tracks[kept++] = tracks[track];
+
+			}
+
+		}
+
+		tracks.resize(kept);
+
+	}
+
+};
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+//Automatic spectrogram thresholds. Every bin gets a minimum statistics noise floor estimate: its dBFS level is
+//smoothed over about 0.2 s, the minimum of that is kept for each 0.5 s sub-window, and the floor is the minimum over
+//the last 8 sub-windows, so it follows a rising floor within about 4 s but a burst of signal never lifts it. A decaying
+//histogram of every value in the rows (0.5 dB buckets, about a 10 s memory) gives the level of the loudest 1% of the
+//spectrogram. The lower threshold sits a margin below the median floor and the upper threshold at that loudest 1%.
+//Each limit only starts to move when its target is more than the hysteresis away, then slews to it, so the colours
+//do not pump with the programme. update() is O(bins) per frame; the sub-window minima are folded in once per
+//sub-window. The rows come from a FixedFrequencyGrid, or the zoom spectrogram row, so the bins only change when the
+//statistics are reset anyway, and every buffer is sized then. Levels are dBFS, the same units as the threshold sliders.
+
+class SpectrogramAutoRange
+{
+public:
+
+	SpectrogramAutoRange() {
+
+		histogram_weights.assign(num_buckets, 0.0);
+
+	};
+
+	~SpectrogramAutoRange() {};
+
+	void update(const std::vector<float> &levels_dB, double elapsed_seconds) { //one spectrogram row
+
+		int num_bins = (int)levels_dB.size();
+
+		if (num_bins == 0) {
+
+			return;
+
+		}
+
+		if (num_bins != bins) { //new bins, the old floors no longer line up
+
+			bins = num_bins;
+
+			clear_statistics();
+
+		}
+
+		elapsed_seconds = std::max(0.0, elapsed_seconds);
+
+		float smoothing = frames_in_sub_window == 0 && sub_windows_done == 0 ? 0.0f : (float)exp(-elapsed_seconds / smoothing_seconds);
+
+		for (int bin = 0; bin < bins; bin++) {
+
+			float level = levels_dB[bin] > lowest_dB ? std::min(highest_dB, levels_dB[bin]) : lowest_dB; //NaN too
+
+			smoothed_dB[bin] = level + (smoothed_dB[bin] - level) * smoothing;
+
+			sub_window_minimum[bin] = std::min(sub_window_minimum[bin], smoothed_dB[bin]);
+
+			noise_floor_dB[bin] = std::min(past_minimum[bin], sub_window_minimum[bin]);
+
+		}
+
+		add_to_histogram(levels_dB, elapsed_seconds);
+
+		frames_in_sub_window++;
+		sub_window_seconds_done += elapsed_seconds;
+
+		if (sub_window_seconds_done >= sub_window_seconds) {
+
+			end_sub_window();
+
+			update_targets();
+
+			sub_window_seconds_done = 0.0;
+
+		}
+
+		if (limits_valid) { //the targets change once per sub-window, the limits slew every frame
+
+			double max_step = slew_dB_per_second * elapsed_seconds;
+
+			move_limit(lower_limit, lower_target, lower_moving, max_step);
+			move_limit(upper_limit, upper_target, upper_moving, max_step);
+
+		}
+
+	}
+
+	void reset() { //the next limits come from the first sub-window measured after this
+
+		clear_statistics();
+
+		limits_valid = false;
+		lower_moving = false;
+		upper_moving = false;
+
+	}
+
+	bool has_limits() const { return limits_valid; }
+
+	float get_lower_limit() const { return (float)lower_limit; }
+
+	float get_upper_limit() const { return (float)upper_limit; }
+
+	const std::vector<float>& get_noise_floor() const { return noise_floor_dB; } //dBFS per bin
+
+private:
+
+	const float lowest_dB = -96.0f;
+	const float highest_dB = 6.0f;
+
+	const double smoothing_seconds = 0.2;
+	const double sub_window_seconds = 0.5;
+	static const int num_sub_windows = 8;
+
+	const double bucket_width = 0.5;
+	static const int num_buckets = 204; //-96 to +6 dBFS
+	const double histogram_seconds = 10.0;
+	const double loud_fraction = 0.01;
+
+	const double lower_margin_dB = 6.0; //the noise shows as dark blue rather than black
+	const double minimum_span_dB = 24.0;
+	const double hysteresis_dB = 3.0;
+	const double slew_dB_per_second = 6.0;
+
+	int bins{ -1 };
+
+	std::vector<float> smoothed_dB;
+	std::vector<float> sub_window_minimum; //of the sub-window in progress
+	std::vector<float> past_minimum; //over the completed sub-windows
+	std::vector<float> noise_floor_dB;
+	std::vector<float> sub_window_minima; //[sub_window * bins + bin]
+	std::vector<float> floor_scratch; //for the median, sized with the other buffers
+
+	int frames_in_sub_window{ 0 };
+	int sub_windows_done{ 0 };
+	int next_sub_window{ 0 };
+	double sub_window_seconds_done{ 0.0 };
+
+	std::vector<double> histogram_weights;
+
+	bool limits_valid{ false };
+	double lower_limit{ -96.0 }, upper_limit{ 0.0 };
+	double lower_target{ -96.0 }, upper_target{ 0.0 };
+	bool lower_moving{ false }, upper_moving{ false };
+
+	void clear_statistics() {
+
+		smoothed_dB.assign(std::max(0, bins), lowest_dB);
+		sub_window_minimum.assign(std::max(0, bins), highest_dB);
+		past_minimum.assign(std::max(0, bins), highest_dB);
+		noise_floor_dB.assign(std::max(0, bins), highest_dB);
+		sub_window_minima.assign((size_t)std::max(0, bins) * num_sub_windows, highest_dB);
+		floor_scratch.assign(std::max(0, bins), highest_dB);
+
+		std::fill(histogram_weights.begin(), histogram_weights.end(), 0.0);
+
+		frames_in_sub_window = 0;
+		sub_windows_done = 0;
+		next_sub_window = 0;
+		sub_window_seconds_done = 0.0;
+
+	}
+
+	void add_to_histogram(const std::vector<float> &levels_dB, double elapsed_seconds) {
+
+		double decay = exp(-elapsed_seconds / histogram_seconds);
+
+		for (int bucket = 0; bucket < num_buckets; bucket++) {
+
+			histogram_weights[bucket] *= decay;
+
+		}
+
+		for (int bin = 0; bin < bins; bin++) {
+
+			double bucket = (levels_dB[bin] - lowest_dB) / bucket_width;
+
+			histogram_weights[bucket > 0.0 ? (int)std::min(bucket, num_buckets - 1.0) : 0] += 1.0;
+
+		}
+
+	}
+
+	void end_sub_window() {
+
+		float* minima = sub_window_minima.data() + (size_t)next_sub_window * bins;
+
+		std::copy(sub_window_minimum.begin(), sub_window_minimum.end(), minima);
+
+		next_sub_window = (next_sub_window + 1) % num_sub_windows;
+
+		sub_windows_done = std::min(sub_windows_done + 1, num_sub_windows);
+
+		//the oldest sub-window drops out, so the minimum over the rest is found again
+
+		std::fill(past_minimum.begin(), past_minimum.end(), highest_dB);
+
+		for (int sub_window = 0; sub_window < num_sub_windows; sub_window++) {
+
+			const float* sub_window_values = sub_window_minima.data() + (size_t)sub_window * bins;
+
+			for (int bin = 0; bin < bins; bin++) {
+
+				past_minimum[bin] = std::min(past_minimum[bin], sub_window_values[bin]);
+
+			}
+
+		}
+
+		std::fill(sub_window_minimum.begin(), sub_window_minimum.end(), highest_dB);
+
+		frames_in_sub_window = 0;
+
+	}
+
+	double get_median_floor() {
+
+		std::copy(past_minimum.begin(), past_minimum.end(), floor_scratch.begin());
+
+		std::nth_element(floor_scratch.begin(), floor_scratch.begin() + bins / 2, floor_scratch.end());
+
+		return floor_scratch[bins / 2];
+
+	}
+
+	double get_loud_level() const {
+
+		double total = 0.0;
+
+		for (int bucket = 0; bucket < num_buckets; bucket++) {
+
+			total += histogram_weights[bucket];
+
+		}
+
+		double above = 0.0;
+
+		for (int bucket = num_buckets - 1; bucket > 0; bucket--) {
+
+			above += histogram_weights[bucket];
+
+			if (above >= total * loud_fraction) {
+
+				return lowest_dB + (bucket + 1) * bucket_width;
+
+			}
+
+		}
+
+		return lowest_dB;
+
+	}
+
+	void update_targets() {
+
+		lower_target = get_median_floor() - lower_margin_dB;
+		upper_target = get_loud_level();
+
+		upper_target = std::min(0.0, std::max(upper_target, lower_target + minimum_span_dB));
+		lower_target = std::max((double)lowest_dB, std::min(lower_target, upper_target - minimum_span_dB));
+
+		if (!limits_valid) { //the first estimate is used straight away
+
+			lower_limit = lower_target;
+			upper_limit = upper_target;
+
+			limits_valid = true;
+
+		}
+
+	}
+
+	void move_limit(double &limit, double target, bool &moving, double max_step) const {
+
+		if (std::abs(target - limit) > hysteresis_dB) {
+
+			moving = true;
+
+		}
+
+		if (moving) {
+
+			limit += std::max(-max_step, std::min(max_step, target - limit));
+
+			moving = limit != target;
+
+		}
+
+	}
+
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+//The scrolling spectrogram texture: one row of 8 bit pixels per analysis frame, oldest row first. Rows are added in
+//dBFS and mapped linearly from -96..0 dBFS onto 0..255. A row wider than the texture is reduced to it, each pixel taking
+//the loudest of the row values it covers, so narrow tones stay visible at a lower texture width. When the size changes
+//(the quality governor stepping the texture width), the rows already held are resampled to it the same way, widening
+//by repeating pixels, so the visible history is kept.
+
+class SpectrogramHistory
+{
+public:
+
+	SpectrogramHistory() {};
+
+	~SpectrogramHistory() {};
+
+	void set_size(int num_frequencies, int num_rows) {
+
+		history_num_frequencies = num_frequencies;
+		history_num_rows = num_rows;
+
+	}
+
+	void add_row(const std::vector<float> &amplitudes_dBFS) {
+
+		int total_pixels = history_num_frequencies * history_num_rows;
+
+		if (stored_num_frequencies != history_num_frequencies || stored_num_rows != history_num_rows) {
+
+			resample_history();
+
+		}
+
+		int row_size = (int)amplitudes_dBFS.size();
+
+		for (int texture_pixel = 0; texture_pixel < history_num_frequencies; texture_pixel++) {
+
+			int first = (int)(((int64_t)texture_pixel * row_size) / history_num_frequencies);
+			int last = std::max(first + 1, (int)(((int64_t)(texture_pixel + 1) * row_size) / history_num_frequencies)); //exclusive
+
+			float value_dBFS = *std::max_element(amplitudes_dBFS.begin() + first, amplitudes_dBFS.begin() + std::min(last, row_size));
+
+			int value_pixel = (((value_dBFS - (-96.0)) * 255) / 96);
+
+			spectrogram_texture_pixel_values.push_back(value_pixel);
+
+		}
+
+		while (spectrogram_texture_pixel_values.size() > total_pixels) {
+
+			spectrogram_texture_pixel_values.pop_front();
+
+		}
+
+	}
+
+	void copy_pixels(unsigned char* destination) const { //destination must hold get_num_pixels() values
+
+		std::copy(spectrogram_texture_pixel_values.begin(), spectrogram_texture_pixel_values.end(), destination);
+
+	}
+
+	int get_num_frequencies() const { return history_num_frequencies; }
+
+	int get_num_rows() const { return history_num_rows; }
+
+	int get_num_pixels() const { return history_num_frequencies * history_num_rows; }
+
+private:
+
+	std::deque<unsigned char> spectrogram_texture_pixel_values;
+
+	int history_num_frequencies{ 0 };
+	int history_num_rows{ 0 };
+
+	int stored_num_frequencies{ 0 }; //the size of the rows in spectrogram_texture_pixel_values
+	int stored_num_rows{ 0 };
+
+	void resample_history() { //to the current size, the newest rows kept and silence added before them
+
+		std::deque<unsigned char> resampled((size_t)history_num_frequencies * history_num_rows, 0);
+
+		int rows_kept = stored_num_frequencies > 0 ? std::min(stored_num_rows, history_num_rows) : 0;
+
+		for (int row = 0; row < rows_kept; row++) { //counted back from the newest
+
+			auto old_row = spectrogram_texture_pixel_values.end() - (size_t)(row + 1) * stored_num_frequencies;
+			auto new_row = resampled.end() - (size_t)(row + 1) * history_num_frequencies;
+
+			for (int texture_pixel = 0; texture_pixel < history_num_frequencies; texture_pixel++) {
+
+				int first = (int)(((int64_t)texture_pixel * stored_num_frequencies) / history_num_frequencies);
+				int last = std::max(first + 1, (int)(((int64_t)(texture_pixel + 1) * stored_num_frequencies) / history_num_frequencies));
+
+				new_row[texture_pixel] = *std::max_element(old_row + first, old_row + last);
+
+			}
+
+		}
+
+		spectrogram_texture_pixel_values.swap(resampled);
+
+		stored_num_frequencies = history_num_frequencies;
+		stored_num_rows = history_num_rows;
+
+	}
+
+};
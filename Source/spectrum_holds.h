@@ -0,0 +1,147 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+ #include <xmmintrin.h>
+ #define SOUNDVIEW_SPECTRUM_HOLDS_SSE 1
+#endif
+
+//Peak hold, min hold and decaying peak traces over the RTA's averaged bins. update() folds the latest frame into all
+//three with one element-wise pass: max for the peak hold, min for the min hold, and max against the previous value
+//scaled down by the decay for the decaying peak. The traces are linear amplitudes like the frame, so the decay is a
+//single factor per frame worked out from the elapsed time. Each trace can be reset on its own and starts again from
+//the next frame. Memory is only reallocated when the number of bins changes, which also resets all three.
+
+class SpectrumHolds
+{
+public:
+
+	SpectrumHolds() {};
+
+	~SpectrumHolds() {};
+
+	void set_decay_rate(double dB_per_second) {
+
+		decay_rate = std::max(0.0, dB_per_second);
+
+	}
+
+	void update(const std::vector<float> &amplitudes, double elapsed_seconds) {
+
+		int num_bins = (int)amplitudes.size();
+
+		if (num_bins != (int)peak_hold.size()) { //new bins, the old traces no longer line up
+
+			peak_hold.resize(num_bins);
+			min_hold.resize(num_bins);
+			decaying_peak.resize(num_bins);
+
+			reset_peak_hold();
+			reset_min_hold();
+			reset_decaying_peak();
+
+		}
+
+		float decay = (float)pow(10.0, -decay_rate * std::max(0.0, elapsed_seconds) / 20.0);
+
+		const float* input = amplitudes.data();
+		float* peak = peak_hold.data();
+		float* minimum = min_hold.data();
+		float* decaying = decaying_peak.data();
+
+		int x = 0;
+
+#ifdef SOUNDVIEW_SPECTRUM_HOLDS_SSE
+
+		const __m128 decay_lanes = _mm_set1_ps(decay);
+
+		for (; x + 4 <= num_bins; x += 4) {
+
+			__m128 value = _mm_loadu_ps(input + x);
+
+			_mm_storeu_ps(peak + x, _mm_max_ps(_mm_loadu_ps(peak + x), value));
+			_mm_storeu_ps(minimum + x, _mm_min_ps(_mm_loadu_ps(minimum + x), value));
+			_mm_storeu_ps(decaying + x, _mm_max_ps(_mm_mul_ps(_mm_loadu_ps(decaying + x), decay_lanes), value));
+
+		}
+
+#endif
+
+		for (; x < num_bins; x++) {
+
+			peak[x] = std::max(peak[x], input[x]);
+			minimum[x] = std::min(minimum[x], input[x]);
+			decaying[x] = std::max(decaying[x] * decay, input[x]);
+
+		}
+
+		peak_hold_frames++;
+		min_hold_frames++;
+		decaying_peak_frames++;
+
+	}
+
+	//a reset trace is empty until the next update()
+
+	void reset_peak_hold() {
+
+		std::fill(peak_hold.begin(), peak_hold.end(), 0.0f);
+
+		peak_hold_frames = 0;
+
+	}
+
+	void reset_min_hold() {
+
+		std::fill(min_hold.begin(), min_hold.end(), std::numeric_limits<float>::max());
+
+		min_hold_frames = 0;
+
+	}
+
+	void reset_decaying_peak() {
+
+		std::fill(decaying_peak.begin(), decaying_peak.end(), 0.0f);
+
+		decaying_peak_frames = 0;
+
+	}
+
+	void reset() {
+
+		reset_peak_hold();
+		reset_min_hold();
+		reset_decaying_peak();
+
+	}
+
+	const std::vector<float>& get_peak_hold() const { return peak_hold; }
+
+	const std::vector<float>& get_min_hold() const { return min_hold; }
+
+	const std::vector<float>& get_decaying_peak() const { return decaying_peak; }
+
+	bool has_peak_hold() const { return peak_hold_frames > 0; }
+
+	bool has_min_hold() const { return min_hold_frames > 0; }
+
+	bool has_decaying_peak() const { return decaying_peak_frames > 0; }
+
+private:
+
+	double decay_rate{ 20.0 }; //dB per second
+
+	std::vector<float> peak_hold;
+	std::vector<float> min_hold;
+	std::vector<float> decaying_peak;
+
+	int64_t peak_hold_frames{ 0 };
+	int64_t min_hold_frames{ 0 };
+	int64_t decaying_peak_frames{ 0 };
+
+};
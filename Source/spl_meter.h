@@ -0,0 +1,444 @@
+#pragma once
+
+#include <atomic>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+
+//Sound level meter for the captured channels, after IEC 61672-1. Each channel is frequency weighted (A, C or Z) by
+//biquads made from the standard's analogue poles with the bilinear transform. The pole frequencies are prewarped, which
+//keeps A weighting within class 1 tolerances up to 16 kHz at 44.1 kHz. The weighted signal is squared and
+//exponentially time weighted (Fast 125 ms or Slow 1 s). At the end of every interval the meter publishes Leq, the
+//maximum and minimum of the time weighted level, and the peak of the weighted signal. Levels are in dB relative to a
+//full scale sine plus the channel's calibration offset. Setting the offset to the SPL a full scale sine would produce
+//makes them read dB SPL. process_block() never allocates or locks and costs a few multiplies per sample, so it runs in
+//the audio callback. Results are published through atomics, settings are picked up at the start of the next block.
+
+enum FrequencyWeighting { a_weighting = 0, c_weighting, z_weighting };
+
+enum TimeWeighting { fast_time_weighting = 0, slow_time_weighting };
+
+struct SPLReadings
+{
+
+	static const int max_channels = 2;
+
+	FrequencyWeighting frequency_weighting{ a_weighting };
+	TimeWeighting time_weighting{ fast_time_weighting };
+	double interval_seconds{ 1.0 };
+
+	int num_channels{ 0 }; //channels in the most recent block
+
+	float level[max_channels] = {}; //time weighted, dB, updated every block
+	float leq[max_channels] = {}; //the rest are over the last completed interval
+	float lmax[max_channels] = {};
+	float lmin[max_channels] = {};
+	float lpeak[max_channels] = {};
+
+	bool interval_valid{ false };
+
+};
+
+class SPLMeter
+{
+public:
+
+	static const int max_channels = SPLReadings::max_channels;
+
+	SPLMeter() {
+
+		for (int channel = 0; channel < max_channels; channel++) {
+
+			calibration_offsets[channel].store(0.0f);
+
+			published_level[channel].store(silence_dB);
+			published_leq[channel].store(silence_dB);
+			published_lmax[channel].store(silence_dB);
+			published_lmin[channel].store(silence_dB);
+			published_lpeak[channel].store(silence_dB);
+
+		}
+
+		apply_settings();
+
+	};
+
+	~SPLMeter() {};
+
+	void set_sample_rate(double sample_rate) { //call while the audio callback is stopped, e.g. from prepareToPlay
+
+		active_sample_rate = sample_rate;
+
+		apply_settings();
+
+	}
+
+	void set_frequency_weighting(FrequencyWeighting weighting) { //any thread
+
+		frequency_weighting.store(weighting);
+
+		settings_changed.store(true);
+
+	}
+
+	void set_time_weighting(TimeWeighting weighting) {
+
+		time_weighting.store(weighting);
+
+		settings_changed.store(true);
+
+	}
+
+	void set_interval(double seconds) {
+
+		interval_seconds.store(std::max(0.1, seconds));
+
+		settings_changed.store(true);
+
+	}
+
+	void set_calibration_offset(int channel, float offset_dB) { //dB SPL of a full scale sine on this channel
+
+		if (channel >= 0 && channel < max_channels) {
+
+			calibration_offsets[channel].store(offset_dB);
+
+		}
+
+	}
+
+	void process_block(const float* const* channels, int num_channels, int num_samples) { //audio thread only
+
+		if (settings_changed.exchange(false)) {
+
+			apply_settings();
+
+		}
+
+		num_channels = std::min(num_channels, (int)max_channels);
+
+		active_channels.store(num_channels, std::memory_order_relaxed);
+
+		int offset = 0;
+
+		while (offset < num_samples) { //split the block where it crosses an interval boundary
+
+			int samples_to_process = std::min(num_samples - offset, samples_per_interval - samples_in_interval);
+
+			for (int channel = 0; channel < num_channels; channel++) {
+
+				process_channel(channel_states[channel], channels[channel] + offset, samples_to_process);
+
+			}
+
+			offset += samples_to_process;
+			samples_in_interval += samples_to_process;
+
+			if (samples_in_interval == samples_per_interval) {
+
+				publish_interval(num_channels);
+
+			}
+
+		}
+
+		for (int channel = 0; channel < num_channels; channel++) {
+
+			published_level[channel].store(power_to_dB(channel_states[channel].mean_square), std::memory_order_relaxed);
+
+		}
+
+	}
+
+	SPLReadings get_readings() const {
+
+		SPLReadings readings;
+
+		readings.frequency_weighting = (FrequencyWeighting)frequency_weighting.load();
+		readings.time_weighting = (TimeWeighting)time_weighting.load();
+		readings.interval_seconds = interval_seconds.load();
+		readings.num_channels = active_channels.load(std::memory_order_relaxed);
+		readings.interval_valid = completed_intervals.load() > 0;
+
+		for (int channel = 0; channel < max_channels; channel++) {
+
+			float calibration = calibration_offsets[channel].load(std::memory_order_relaxed);
+
+			readings.level[channel] = calibrate(published_level[channel].load(std::memory_order_relaxed), calibration);
+			readings.leq[channel] = calibrate(published_leq[channel].load(std::memory_order_relaxed), calibration);
+			readings.lmax[channel] = calibrate(published_lmax[channel].load(std::memory_order_relaxed), calibration);
+			readings.lmin[channel] = calibrate(published_lmin[channel].load(std::memory_order_relaxed), calibration);
+			readings.lpeak[channel] = calibrate(published_lpeak[channel].load(std::memory_order_relaxed), calibration);
+
+		}
+
+		return readings;
+
+	}
+
+	static constexpr float silence_dB = -200.0f; //what digital silence reads, calibrated or not
+
+private:
+
+	struct Biquad //direct form II transposed
+	{
+
+		double b0{ 1.0 }, b1{ 0.0 }, b2{ 0.0 }, a1{ 0.0 }, a2{ 0.0 };
+		double z1{ 0.0 }, z2{ 0.0 };
+
+	};
+
+	static const int num_sections = 3; //A weighting is 6th order, C uses the outer two sections, Z none
+
+	struct ChannelState
+	{
+
+		Biquad sections[num_sections];
+
+		double mean_square{ 0.0 }; //time weighted
+		double interval_sum{ 0.0 };
+		double interval_max{ 0.0 }, interval_min{ 0.0 }; //of mean_square
+		double interval_peak{ 0.0 };
+
+	};
+
+	const double pi = 3.141592653589793;
+
+	//IEC 61672-1 pole frequencies, Hz
+
+	const double pole_1 = 20.598997;
+	const double pole_2 = 107.65265;
+	const double pole_3 = 737.86223;
+	const double pole_4 = 12194.217;
+
+	std::atomic<int> frequency_weighting{ a_weighting };
+	std::atomic<int> time_weighting{ fast_time_weighting };
+	std::atomic<double> interval_seconds{ 1.0 };
+	std::atomic<bool> settings_changed{ false };
+	std::atomic<float> calibration_offsets[max_channels];
+
+	//audio thread state
+
+	double active_sample_rate{ 44100.0 };
+	double time_weighting_coefficient{ 0.0 };
+	int samples_per_interval{ 44100 };
+	int samples_in_interval{ 0 };
+
+	ChannelState channel_states[max_channels];
+
+	//published
+
+	std::atomic<int> active_channels{ 0 };
+	std::atomic<int64_t> completed_intervals{ 0 };
+	std::atomic<float> published_level[max_channels];
+	std::atomic<float> published_leq[max_channels];
+	std::atomic<float> published_lmax[max_channels];
+	std::atomic<float> published_lmin[max_channels];
+	std::atomic<float> published_lpeak[max_channels];
+
+	void apply_settings() { //designs the filters and restarts the interval, no allocation
+
+		double time_constant = time_weighting.load() == slow_time_weighting ? 1.0 : 0.125;
+
+		time_weighting_coefficient = 1.0 - exp(-1.0 / (time_constant * active_sample_rate));
+
+		samples_per_interval = std::max(1, (int)(interval_seconds.load() * active_sample_rate));
+		samples_in_interval = 0;
+
+		completed_intervals.store(0);
+
+		for (int channel = 0; channel < max_channels; channel++) {
+
+			design_weighting_filter(channel_states[channel]);
+
+			channel_states[channel].mean_square = 0.0;
+
+			start_interval(channel_states[channel]);
+
+		}
+
+	}
+
+	void design_weighting_filter(ChannelState &state) {
+
+		int weighting = frequency_weighting.load();
+
+		for (int section = 0; section < num_sections; section++) {
+
+			state.sections[section] = Biquad(); //a pass through
+
+		}
+
+		if (weighting == z_weighting) {
+
+			return;
+
+		}
+
+		double w1 = prewarp(pole_1), w2 = prewarp(pole_2), w3 = prewarp(pole_3), w4 = prewarp(pole_4);
+
+		//s^2 / (s + w1)^2, [s^2 / ((s + w2)(s + w3)) for A only], 1 / (s + w4)^2, coefficients from s^0 up
+
+		const double high_pass_numerator[3] = { 0.0, 0.0, 1.0 };
+		const double low_pass_numerator[3] = { 1.0, 0.0, 0.0 };
+
+		const double first_denominator[3] = { w1 * w1, 2.0 * w1, 1.0 };
+		const double middle_denominator[3] = { w2 * w3, w2 + w3, 1.0 };
+		const double last_denominator[3] = { w4 * w4, 2.0 * w4, 1.0 };
+
+		bilinear_transform(high_pass_numerator, first_denominator, state.sections[0]);
+		bilinear_transform(low_pass_numerator, last_denominator, state.sections[2]);
+
+		if (weighting == a_weighting) {
+
+			bilinear_transform(high_pass_numerator, middle_denominator, state.sections[1]);
+
+		}
+
+		//0 dB at 1 kHz, as the standard defines
+
+		double gain = 1.0 / get_response(state, 1000.0);
+
+		state.sections[0].b0 *= gain;
+		state.sections[0].b1 *= gain;
+		state.sections[0].b2 *= gain;
+
+	}
+
+	double prewarp(double frequency) const { //the analogue angular frequency the bilinear transform maps to frequency
+
+		return 2.0 * active_sample_rate * tan(pi * frequency / active_sample_rate);
+
+	}
+
+	void bilinear_transform(const double* numerator, const double* denominator, Biquad &biquad) const {
+
+		double k = 2.0 * active_sample_rate;
+
+		double a0 = denominator[2] * k * k + denominator[1] * k + denominator[0];
+
+		biquad.b0 = (numerator[2] * k * k + numerator[1] * k + numerator[0]) / a0;
+		biquad.b1 = (2.0 * (numerator[0] - numerator[2] * k * k)) / a0;
+		biquad.b2 = (numerator[2] * k * k - numerator[1] * k + numerator[0]) / a0;
+		biquad.a1 = (2.0 * (denominator[0] - denominator[2] * k * k)) / a0;
+		biquad.a2 = (denominator[2] * k * k - denominator[1] * k + denominator[0]) / a0;
+
+	}
+
+	double get_response(const ChannelState &state, double frequency) const { //magnitude of the weighting filter
+
+		double omega = 2.0 * pi * frequency / active_sample_rate;
+		double response = 1.0;
+
+		for (int section = 0; section < num_sections; section++) {
+
+			const Biquad &biquad = state.sections[section];
+
+			double numerator_re = biquad.b0 + biquad.b1 * cos(omega) + biquad.b2 * cos(2.0 * omega);
+			double numerator_im = -biquad.b1 * sin(omega) - biquad.b2 * sin(2.0 * omega);
+			double denominator_re = 1.0 + biquad.a1 * cos(omega) + biquad.a2 * cos(2.0 * omega);
+			double denominator_im = -biquad.a1 * sin(omega) - biquad.a2 * sin(2.0 * omega);
+
+			response *= sqrt((numerator_re * numerator_re + numerator_im * numerator_im) / (denominator_re * denominator_re + denominator_im * denominator_im));
+
+		}
+
+		return response;
+
+	}
+
+	void process_channel(ChannelState &state, const float* samples, int num_samples) {
+
+		Biquad sections[num_sections];
+
+		std::copy(state.sections, state.sections + num_sections, sections); //locals, so the compiler keeps them in registers
+
+		double mean_square = state.mean_square;
+		double interval_sum = state.interval_sum;
+		double interval_max = state.interval_max;
+		double interval_min = state.interval_min;
+		double interval_peak = state.interval_peak;
+
+		for (int sample = 0; sample < num_samples; sample++) {
+
+			double x = samples[sample];
+
+			for (int section = 0; section < num_sections; section++) {
+
+				Biquad &biquad = sections[section];
+
+				double y = biquad.b0 * x + biquad.z1;
+
+				biquad.z1 = biquad.b1 * x - biquad.a1 * y + biquad.z2;
+				biquad.z2 = biquad.b2 * x - biquad.a2 * y;
+
+				x = y;
+
+			}
+
+			double square = x * x;
+
+			mean_square += time_weighting_coefficient * (square - mean_square);
+
+			interval_sum += square;
+			interval_max = std::max(interval_max, mean_square);
+			interval_min = std::min(interval_min, mean_square);
+			interval_peak = std::max(interval_peak, fabs(x));
+
+		}
+
+		std::copy(sections, sections + num_sections, state.sections);
+
+		state.mean_square = mean_square;
+		state.interval_sum = interval_sum;
+		state.interval_max = interval_max;
+		state.interval_min = interval_min;
+		state.interval_peak = interval_peak;
+
+	}
+
+	void start_interval(ChannelState &state) {
+
+		state.interval_sum = 0.0;
+		state.interval_max = 0.0;
+		state.interval_min = std::numeric_limits<double>::max();
+		state.interval_peak = 0.0;
+
+	}
+
+	void publish_interval(int num_channels) {
+
+		for (int channel = 0; channel < num_channels; channel++) {
+
+			ChannelState &state = channel_states[channel];
+
+			published_leq[channel].store(power_to_dB(state.interval_sum / samples_per_interval), std::memory_order_relaxed);
+			published_lmax[channel].store(power_to_dB(state.interval_max), std::memory_order_relaxed);
+			published_lmin[channel].store(power_to_dB(state.interval_min), std::memory_order_relaxed);
+			published_lpeak[channel].store(power_to_dB(state.interval_peak * state.interval_peak), std::memory_order_relaxed); //a sine's peak reads 3 dB over its level
+
+			start_interval(state);
+
+		}
+
+		samples_in_interval = 0;
+
+		completed_intervals.fetch_add(1);
+
+	}
+
+	static float calibrate(float level, float calibration) {
+
+		return level > silence_dB ? level + calibration : silence_dB;
+
+	}
+
+	static float power_to_dB(double mean_square) { //relative to a full scale sine, whose mean square is 0.5
+
+		double level = mean_square > 0.0 ? 10.0 * log10(2.0 * mean_square) : silence_dB;
+
+		return level > silence_dB ? (float)level : silence_dB;
+
+	}
+
+};
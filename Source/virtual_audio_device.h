@@ -0,0 +1,588 @@
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <complex>
+
+//A deterministic audio input device for load and soak testing without a sound card. Each device name is one test
+//signal. Samples depend only on their index, so every run is repeatable. Blocks are delivered from a high
+//priority thread either in real time, at a multiple of real time, or as fast as the callback will take them. In real
+//time mode a block that cannot be delivered within one block period of its deadline is counted as an xrun,
+//mirroring what a hardware driver would report.
+
+struct VirtualAudioDeviceSettings
+{
+
+	int num_input_channels{ 2 };
+	double speed{ 1.0 }; //1 = real time, 4 = four times real time, 0 = as fast as possible
+	int measurement_delay_samples{ 0 }; //input 1 lags the other inputs by this much, for exercising the delay finder
+	float level_dBFS{ -12.0f };
+
+};
+
+struct VirtualAudioDeviceStatistics
+{
+
+	int64 blocks_delivered{ 0 };
+	int64 samples_delivered{ 0 };
+	int xruns{ 0 };
+	double wall_seconds{ 0.0 };
+
+};
+
+class VirtualAudioIODevice : public AudioIODevice, private Thread
+{
+public:
+
+	enum SignalType { sine = 0, multitone, pink_noise, log_sweep, silence, clipping_bursts, feedback_build_up, num_signal_types };
+
+	static StringArray get_signal_names() {
+
+		return { "Virtual Sine 1 kHz", "Virtual Multitone", "Virtual Pink Noise", "Virtual Log Sweep", "Virtual Silence", "Virtual Clipping Bursts",
+				 "Virtual Feedback Build-up" };
+
+	}
+
+	//the feedback build-up: pink noise, and in every cycle a tone that starts at the onset and grows steadily until it
+	//levels off just below full scale, then stops. Public so the feedback detector's latency can be measured against it.
+
+	static constexpr double feedback_cycle_seconds = 10.0;
+	static constexpr double feedback_onset_seconds = 2.0; //into each cycle
+	static constexpr double feedback_stop_seconds = 8.0;
+	static constexpr double feedback_frequency = 2511.9;
+	static constexpr double feedback_start_dBFS = -70.0;
+	static constexpr double feedback_growth_dB_per_second = 15.0;
+	static constexpr double feedback_highest_dBFS = -3.0;
+
+	VirtualAudioIODevice(const String &device_name, const String &type_name, VirtualAudioDeviceSettings device_settings) :
+		AudioIODevice(device_name, type_name),
+		Thread("Virtual audio device"),
+		settings(device_settings)
+	{
+
+		signal_type = jmax(0, get_signal_names().indexOf(device_name));
+
+	};
+
+	~VirtualAudioIODevice() {
+
+		close();
+
+	};
+
+	StringArray getOutputChannelNames() override { return { "Virtual Out 1", "Virtual Out 2" }; }
+
+	StringArray getInputChannelNames() override {
+
+		StringArray names;
+
+		for (int channel = 0; channel < settings.num_input_channels; channel++) {
+
+			names.add("Virtual In " + String(channel + 1));
+
+		}
+
+		return names;
+
+	}
+
+	Array<double> getAvailableSampleRates() override {
+
+		return { 8000.0, 11025.0, 16000.0, 22050.0, 32000.0, 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0, 352800.0, 384000.0 };
+
+	}
+
+	Array<int> getAvailableBufferSizes() override {
+
+		return { 16, 32, 48, 64, 96, 128, 192, 256, 480, 512, 1024, 2048, 4096, 8192 };
+
+	}
+
+	int getDefaultBufferSize() override { return 512; }
+
+	String open(const BigInteger &input_channels, const BigInteger &output_channels, double sample_rate, int buffer_size) override {
+
+		close();
+
+		active_input_channels = input_channels;
+		active_input_channels.setRange(settings.num_input_channels, active_input_channels.getHighestBit() + 1, false);
+
+		active_output_channels = output_channels;
+		active_output_channels.setRange(2, active_output_channels.getHighestBit() + 1, false);
+
+		current_sample_rate = sample_rate > 0.0 ? sample_rate : 48000.0;
+		current_buffer_size = buffer_size > 0 ? jlimit(16, 8192, buffer_size) : getDefaultBufferSize();
+
+		input_buffer.setSize(jmax(1, active_input_channels.countNumberOfSetBits()), current_buffer_size);
+		output_buffer.setSize(jmax(1, active_output_channels.countNumberOfSetBits()), current_buffer_size);
+		signal_block.resize(current_buffer_size);
+		delay_line.assign(jmax(1, settings.measurement_delay_samples), 0.0f);
+
+		reset_signal_state();
+
+		device_open = true;
+
+		startThread(9);
+
+		return {};
+
+	}
+
+	void close() override {
+
+		stop();
+
+		stopThread(2000);
+
+		device_open = false;
+
+	}
+
+	bool isOpen() override { return device_open; }
+
+	void start(AudioIODeviceCallback* new_callback) override {
+
+		if (new_callback == nullptr || new_callback == callback) {
+
+			return;
+
+		}
+
+		stop();
+
+		new_callback->audioDeviceAboutToStart(this);
+
+		const ScopedLock callback_scope(callback_lock);
+
+		callback = new_callback;
+
+	}
+
+	void stop() override {
+
+		AudioIODeviceCallback* old_callback;
+
+		{
+			const ScopedLock callback_scope(callback_lock);
+
+			old_callback = callback;
+			callback = nullptr;
+		}
+
+		if (old_callback != nullptr) {
+
+			old_callback->audioDeviceStopped();
+
+		}
+
+	}
+
+	bool isPlaying() override { return callback != nullptr; }
+
+	String getLastError() override { return {}; }
+
+	int getCurrentBufferSizeSamples() override { return current_buffer_size; }
+
+	double getCurrentSampleRate() override { return current_sample_rate; }
+
+	int getCurrentBitDepth() override { return 32; }
+
+	BigInteger getActiveOutputChannels() const override { return active_output_channels; }
+
+	BigInteger getActiveInputChannels() const override { return active_input_channels; }
+
+	int getOutputLatencyInSamples() override { return 0; }
+
+	int getInputLatencyInSamples() override { return 0; }
+
+	int getXRunCount() const noexcept override { return xrun_count.load(); }
+
+	VirtualAudioDeviceStatistics get_statistics() const {
+
+		VirtualAudioDeviceStatistics statistics;
+
+		statistics.blocks_delivered = blocks_delivered.load();
+		statistics.samples_delivered = statistics.blocks_delivered * current_buffer_size;
+		statistics.xruns = xrun_count.load();
+		statistics.wall_seconds = (Time::getMillisecondCounterHiRes() - start_time_ms) / 1000.0;
+
+		return statistics;
+
+	}
+
+private:
+
+	VirtualAudioDeviceSettings settings;
+	int signal_type;
+
+	bool device_open{ false };
+	BigInteger active_input_channels, active_output_channels;
+	double current_sample_rate{ 48000.0 };
+	int current_buffer_size{ 512 };
+
+	CriticalSection callback_lock;
+	AudioIODeviceCallback* callback{ nullptr };
+
+	AudioBuffer<float> input_buffer, output_buffer;
+	std::vector<float> signal_block;
+	std::vector<float> delay_line;
+	int delay_line_position{ 0 };
+
+	std::atomic<int64> blocks_delivered{ 0 };
+	std::atomic<int> xrun_count{ 0 };
+	double start_time_ms{ 0.0 };
+
+	//signal state, all advanced per sample so the output only depends on the sample index
+
+	int64 sample_index{ 0 };
+	double sweep_phase{ 0.0 };
+	uint32 noise_state{ 0x12345678 };
+	double pink_state[7];
+
+	//the multitone's tones below 0.45 fs, each a unit phasor turned by its step every sample, so a sample costs one
+	//complex multiply per tone instead of a sin() and pow()
+
+	static const int num_multitone_tones = 31;
+
+	std::complex<double> multitone_phasors[num_multitone_tones];
+	std::complex<double> multitone_steps[num_multitone_tones];
+	int num_active_tones{ 0 };
+
+	void reset_signal_state() {
+
+		sample_index = 0;
+		sweep_phase = 0.0;
+
+		reset_multitone();
+		noise_state = 0x12345678;
+		delay_line_position = 0;
+
+		std::fill(pink_state, pink_state + 7, 0.0);
+		std::fill(delay_line.begin(), delay_line.end(), 0.0f);
+
+		blocks_delivered.store(0);
+		xrun_count.store(0);
+
+	}
+
+	void reset_multitone() { //the tones for the current sample rate, from sample 0
+
+		num_active_tones = 0;
+
+		for (int tone = 0; tone < num_multitone_tones; tone++) {
+
+			double frequency = 20.0 * pow(2.0, tone / 3.0);
+
+			if (frequency >= current_sample_rate * 0.45) {
+
+				break;
+
+			}
+
+			multitone_phasors[num_active_tones] = std::polar(1.0, tone * tone * 0.7);
+			multitone_steps[num_active_tones] = std::polar(1.0, 2.0 * MathConstants<double>::pi * frequency / current_sample_rate);
+
+			num_active_tones++;
+
+		}
+
+	}
+
+	void run() override {
+
+		typedef std::chrono::steady_clock clock;
+
+		start_time_ms = Time::getMillisecondCounterHiRes();
+
+		const bool paced = settings.speed > 0.0;
+		const std::chrono::duration<double> block_period(paced ? current_buffer_size / (current_sample_rate * settings.speed) : 0.0);
+
+		clock::time_point deadline = clock::now();
+
+		while (!threadShouldExit()) {
+
+			generate_block();
+
+			{
+				const ScopedLock callback_scope(callback_lock);
+
+				if (callback != nullptr) {
+
+					callback->audioDeviceIOCallback(input_buffer.getArrayOfReadPointers(), input_buffer.getNumChannels(),
+													output_buffer.getArrayOfWritePointers(), output_buffer.getNumChannels(),
+													current_buffer_size);
+
+				}
+			}
+
+			blocks_delivered++;
+
+			if (!paced) {
+
+				continue;
+
+			}
+
+			deadline += std::chrono::duration_cast<clock::duration>(block_period);
+
+			clock::time_point now = clock::now();
+
+			if (now > deadline + std::chrono::duration_cast<clock::duration>(block_period)) { //more than a whole block late
+
+				xrun_count++;
+
+				deadline = now;
+
+				continue;
+
+			}
+
+			std::this_thread::sleep_until(deadline);
+
+		}
+
+	}
+
+	void generate_block() {
+
+		float gain = Decibels::decibelsToGain(settings.level_dBFS);
+
+		for (int sample = 0; sample < current_buffer_size; sample++) {
+
+			signal_block[sample] = next_sample(gain);
+
+		}
+
+		for (int channel = 0; channel < input_buffer.getNumChannels(); channel++) {
+
+			input_buffer.copyFrom(channel, 0, signal_block.data(), current_buffer_size);
+
+		}
+
+		if (settings.measurement_delay_samples > 0) { //delay input 1 relative to the others
+
+			float* measurement = input_buffer.getWritePointer(0);
+
+			for (int sample = 0; sample < current_buffer_size; sample++) {
+
+				float delayed = delay_line[delay_line_position];
+
+				delay_line[delay_line_position] = measurement[sample];
+				delay_line_position = (delay_line_position + 1) % delay_line.size();
+
+				measurement[sample] = delayed;
+
+			}
+
+		}
+
+	}
+
+	float next_sample(float gain) {
+
+		double time = sample_index / current_sample_rate;
+		double value = 0.0;
+
+		switch (signal_type)
+		{
+
+		case sine:
+
+			value = gain * sin(2.0 * MathConstants<double>::pi * 1000.0 * time);
+
+			break;
+
+		case multitone: //one tone per third octave from 20 Hz, with fixed phases so the crest factor stays sensible
+
+			for (int tone = 0; tone < num_active_tones; tone++) {
+
+				value += multitone_phasors[tone].imag();
+
+				multitone_phasors[tone] *= multitone_steps[tone];
+
+			}
+
+			if ((sample_index & 4095) == 4095) { //stop rounding errors from changing the tones' levels
+
+				for (int tone = 0; tone < num_active_tones; tone++) {
+
+					multitone_phasors[tone] /= std::abs(multitone_phasors[tone]);
+
+				}
+
+			}
+
+			value *= gain / sqrt((double)num_multitone_tones);
+
+			break;
+
+		case pink_noise:
+
+			value = gain * next_pink_noise();
+
+			break;
+
+		case log_sweep: //20 Hz to 20 kHz (or Nyquist) over 10 s, repeating
+
+			{
+				double sweep_length = 10.0;
+				double sweep_time = fmod(time, sweep_length);
+				double highest_frequency = jmin(20000.0, current_sample_rate * 0.45);
+
+				double frequency = 20.0 * pow(highest_frequency / 20.0, sweep_time / sweep_length);
+
+				sweep_phase = fmod(sweep_phase + (2.0 * MathConstants<double>::pi * frequency / current_sample_rate), 2.0 * MathConstants<double>::pi);
+
+				value = gain * sin(sweep_phase);
+			}
+
+			break;
+
+		case clipping_bursts: //a 1 kHz sine driven into hard clipping for 50 ms of every 500 ms
+
+			{
+				bool in_burst = fmod(time, 0.5) < 0.05;
+
+				value = (in_burst ? 2.0 : gain) * sin(2.0 * MathConstants<double>::pi * 1000.0 * time);
+
+				value = jlimit(-1.0, 1.0, value);
+			}
+
+			break;
+
+		case feedback_build_up: //pink noise at the set level, with the tone on top at its own level
+
+			{
+				double cycle_time = fmod(time, feedback_cycle_seconds);
+
+				value = gain * next_pink_noise();
+
+				if (cycle_time >= feedback_onset_seconds && cycle_time < feedback_stop_seconds) {
+
+					double tone_dBFS = jmin(feedback_highest_dBFS, feedback_start_dBFS + feedback_growth_dB_per_second * (cycle_time - feedback_onset_seconds));
+
+					value += Decibels::decibelsToGain(tone_dBFS) * sin(2.0 * MathConstants<double>::pi * feedback_frequency * time);
+
+				}
+			}
+
+			break;
+
+		default: //silence
+
+			break;
+
+		}
+
+		sample_index++;
+
+		return (float)value;
+
+	}
+
+	double next_pink_noise() { //Paul Kellet's refined pink noise filter on white noise
+
+		double white = next_white_noise();
+
+		pink_state[0] = 0.99886 * pink_state[0] + white * 0.0555179;
+		pink_state[1] = 0.99332 * pink_state[1] + white * 0.0750759;
+		pink_state[2] = 0.96900 * pink_state[2] + white * 0.1538520;
+		pink_state[3] = 0.86650 * pink_state[3] + white * 0.3104856;
+		pink_state[4] = 0.55000 * pink_state[4] + white * 0.5329522;
+		pink_state[5] = -0.7616 * pink_state[5] - white * 0.0168980;
+
+		double pink = 0.11 * (pink_state[0] + pink_state[1] + pink_state[2] + pink_state[3] + pink_state[4] + pink_state[5] + pink_state[6] + white * 0.5362);
+
+		pink_state[6] = white * 0.115926;
+
+		return pink;
+
+	}
+
+	double next_white_noise() { //xorshift32, uniform in -1..1
+
+		noise_state ^= noise_state << 13;
+		noise_state ^= noise_state >> 17;
+		noise_state ^= noise_state << 5;
+
+		return (noise_state / 2147483647.5) - 1.0;
+
+	}
+
+};
+
+class VirtualAudioIODeviceType : public AudioIODeviceType
+{
+public:
+
+	VirtualAudioIODeviceType(VirtualAudioDeviceSettings device_settings) :
+		AudioIODeviceType(get_type_name()),
+		settings(device_settings)
+	{
+	};
+
+	~VirtualAudioIODeviceType() {};
+
+	static String get_type_name() { return "SoundView Virtual"; }
+
+	static VirtualAudioDeviceSettings settings_from_arguments(const StringArray &arguments) {
+
+		VirtualAudioDeviceSettings settings;
+
+		for (int x = 0; x < arguments.size(); x++) {
+
+			String value = arguments[x + 1].unquoted();
+
+			if (arguments[x] == "--virtual-channels") { settings.num_input_channels = jlimit(1, 64, value.getIntValue()); x++; }
+			else if (arguments[x] == "--virtual-speed") { settings.speed = jmax(0.0, value.getDoubleValue()); x++; }
+			else if (arguments[x] == "--virtual-delay") { settings.measurement_delay_samples = jmax(0, value.getIntValue()); x++; }
+			else if (arguments[x] == "--virtual-level") { settings.level_dBFS = value.getFloatValue(); x++; }
+
+		}
+
+		return settings;
+
+	}
+
+	void scanForDevices() override {}
+
+	StringArray getDeviceNames(bool want_input_names) const override {
+
+		return VirtualAudioIODevice::get_signal_names();
+
+	}
+
+	int getDefaultDeviceIndex(bool for_input) const override { return 0; }
+
+	int getIndexOfDevice(AudioIODevice* device, bool as_input) const override {
+
+		return device != nullptr ? VirtualAudioIODevice::get_signal_names().indexOf(device->getName()) : -1;
+
+	}
+
+	bool hasSeparateInputsAndOutputs() const override { return false; }
+
+	AudioIODevice* createDevice(const String &output_device_name, const String &input_device_name) override {
+
+		String device_name = input_device_name.isNotEmpty() ? input_device_name : output_device_name;
+
+		if (!VirtualAudioIODevice::get_signal_names().contains(device_name)) {
+
+			return nullptr;
+
+		}
+
+		return new VirtualAudioIODevice(device_name, getTypeName(), settings);
+
+	}
+
+private:
+
+	VirtualAudioDeviceSettings settings;
+
+};
@@ -0,0 +1,550 @@
+#pragma once
+
+#include "fft.h"
+#include "sample_fifo.h"
+#include "frame_profiler.h"
+
+#include <fftw3.h>
+#include <vector>
+#include <complex>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+ #include <xmmintrin.h>
+ #define SOUNDVIEW_ZOOM_FFT_SSE 1
+#endif
+
+//High resolution analysis of a narrow band (a zoom FFT). The input is mixed down with a complex oscillator so the
+//centre of the band sits at 0 Hz, low pass filtered and decimated so that only the band is left, then transformed
+//with a moderate sized complex FFT. Decimating by D gives D times finer resolution for the same FFT size. 20-500 Hz
+//at 48 kHz is decimated by 80, so an 8192 point FFT resolves 0.07 Hz. The decimating filter is a linear phase FIR
+//that only computes the kept outputs (the same work as its polyphase form), with an SSE dot product. The audio thread
+//only pushes samples into a SampleFifo, with the arrival time of each block in a ring of stamps beside it. Mixing,
+//filtering and the FFT run on a background thread, one block at a time, so each spectrum carries the arrival time of
+//the newest block in it and how long the thread took from that block to the spectrum.
+
+struct ZoomSpectrum
+{
+
+	std::vector<float> frequencies; //Hz, linearly spaced over the band
+	std::vector<float> amplitudes; //linear, scaled like AnalysisEngine so a full scale sine reads 1.0
+
+	double resolution{ 0.0 }; //Hz per bin
+	double update_interval{ 0.0 }; //seconds of audio between spectra
+	int decimation{ 1 };
+	bool valid{ false };
+
+	int64_t newest_sample_ns{ 0 }; //FrameProfiler clock, arrival of the newest block in the spectrum, 0 = not stamped
+	double processing_seconds{ 0.0 }; //on the zoom thread, from taking that block to the spectrum
+
+};
+
+class ZoomFFT
+{
+public:
+
+	ZoomFFT(int fft_size_points) :
+		fft_size(fft_size_points),
+		hop_size(fft_size_points / 16), //a new spectrum every 0.85 s for 20-500 Hz, the FFT is cheap next to the filter
+		input_fifo(1, 65536)
+	{
+
+		decimated_re.resize(fft_size, 0.0f);
+		decimated_im.resize(fft_size, 0.0f);
+		chunk.resize(2048);
+
+		for (int stamp = 0; stamp < num_arrival_stamps; stamp++) {
+
+			stamp_end_samples[stamp].store(0);
+			stamp_arrival_ns[stamp].store(0);
+
+		}
+
+		hann_window_weights.resize(fft_size);
+
+		for (int n = 0; n < fft_size; n++) {
+
+			hann_window_weights[n] = 0.5 * (1.0 - cos((2.0 * 3.141592654 * n) / (fft_size - 1)));
+
+		}
+
+		fft_input = fftw_alloc_complex(fft_size);
+		fft_output = fftw_alloc_complex(fft_size);
+
+		std::lock_guard<std::mutex> planner_lock(fftw_planner_mutex());
+
+		plan = fftw_plan_dft_1d(fft_size, fft_input, fft_output, FFTW_FORWARD, FFTW_ESTIMATE);
+
+	};
+
+	~ZoomFFT() {
+
+		stop();
+
+		std::unique_lock<std::mutex> planner_lock(fftw_planner_mutex());
+		fftw_destroy_plan(plan);
+		planner_lock.unlock();
+
+		fftw_free(fft_input);
+		fftw_free(fft_output);
+
+	};
+
+	void start() {
+
+		if (worker_thread.joinable()) {
+
+			return;
+
+		}
+
+		stop_requested.store(false);
+
+		worker_thread = std::thread(&ZoomFFT::run, this);
+
+	}
+
+	void stop() {
+
+		stop_requested.store(true);
+
+		if (worker_thread.joinable()) {
+
+			worker_thread.join();
+
+		}
+
+	}
+
+	void push_samples(const float* samples, int num_samples, int64_t arrival_ns = 0) { //audio thread, ignored while disabled
+
+		if (!enabled.load(std::memory_order_relaxed)) {
+
+			return;
+
+		}
+
+		const float* channels[1] = { samples };
+
+		int samples_written = input_fifo.push(channels, num_samples);
+
+		if (samples_written == 0) {
+
+			return;
+
+		}
+
+		samples_pushed += samples_written;
+
+		int64_t stamp = stamps_written.load(std::memory_order_relaxed);
+
+		stamp_end_samples[stamp % num_arrival_stamps].store(samples_pushed, std::memory_order_relaxed);
+		stamp_arrival_ns[stamp % num_arrival_stamps].store(arrival_ns, std::memory_order_relaxed);
+
+		stamps_written.store(stamp + 1, std::memory_order_release);
+
+	}
+
+	void set_enabled(bool should_be_enabled) {
+
+		enabled.store(should_be_enabled);
+
+		reconfigure_requested.store(true); //start from an empty history
+
+	}
+
+	bool is_enabled() const { return enabled.load(); }
+
+	void set_sample_rate(double sample_rate) {
+
+		active_sample_rate.store(sample_rate);
+
+		reconfigure_requested.store(true);
+
+	}
+
+	void set_band(double lowest_frequency, double highest_frequency) {
+
+		band_low.store(std::max(0.0, lowest_frequency));
+		band_high.store(std::max(lowest_frequency + minimum_bandwidth, highest_frequency));
+
+		reconfigure_requested.store(true);
+
+	}
+
+	//Copies the latest spectrum into destination if it is newer than last_frame_index, which is then updated
+
+	bool get_spectrum(ZoomSpectrum &destination, int64_t &last_frame_index) {
+
+		std::lock_guard<std::mutex> result_lock(result_mtx);
+
+		if (frame_index == last_frame_index) {
+
+			return false;
+
+		}
+
+		destination = latest_spectrum;
+		last_frame_index = frame_index;
+
+		return true;
+
+	}
+
+	void process_samples(const float* samples, int num_samples) { //worker thread, or directly when not started
+
+		if (reconfigure_requested.exchange(false)) {
+
+			configure();
+
+		}
+
+		for (int sample = 0; sample < num_samples; sample++) {
+
+			std::complex<double> mixed = oscillator * (double)samples[sample];
+
+			oscillator *= oscillator_step;
+
+			if (++samples_since_renormalise == 4096) { //stop rounding errors from changing the oscillator's level
+
+				oscillator /= std::abs(oscillator);
+
+				samples_since_renormalise = 0;
+
+			}
+
+			//each sample is written twice, so the newest num_taps samples are always contiguous from filter_position
+
+			mixed_re[filter_position] = mixed_re[filter_position + num_taps] = (float)mixed.real();
+			mixed_im[filter_position] = mixed_im[filter_position + num_taps] = (float)mixed.imag();
+
+			filter_position = (filter_position + 1) % num_taps;
+
+			if (--samples_until_output == 0) {
+
+				samples_until_output = decimation;
+
+				add_decimated_sample(	dot_product(filter_taps.data(), &mixed_re[filter_position], num_taps),
+										dot_product(filter_taps.data(), &mixed_im[filter_position], num_taps));
+
+			}
+
+		}
+
+	}
+
+	static float dot_product(const float* a, const float* b, int length) { //length must be a multiple of 4
+
+#if SOUNDVIEW_ZOOM_FFT_SSE
+
+		__m128 sum = _mm_setzero_ps();
+
+		for (int x = 0; x < length; x += 4) {
+
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a + x), _mm_loadu_ps(b + x)));
+
+		}
+
+		float lanes[4];
+
+		_mm_storeu_ps(lanes, sum);
+
+		return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+
+#else
+
+		float sum = 0.0f;
+
+		for (int x = 0; x < length; x++) {
+
+			sum += a[x] * b[x];
+
+		}
+
+		return sum;
+
+#endif
+
+	}
+
+private:
+
+	const int fft_size;
+	const int hop_size;
+
+	const double minimum_bandwidth = 10.0;
+	const int max_decimation = 1024;
+	const int taps_per_decimation = 28; //sets the filter's transition band to about a fifth of the decimated rate
+
+	SampleFifo input_fifo;
+	std::vector<float> chunk;
+
+	//filter and oscillator state, only touched by the processing thread
+
+	int decimation{ 1 };
+	int num_taps{ 4 };
+	double decimated_rate{ 48000.0 };
+	double centre_frequency{ 0.0 };
+
+	std::vector<float> filter_taps;
+	std::vector<float> mixed_re, mixed_im;
+	int filter_position{ 0 };
+	int samples_until_output{ 1 };
+
+	std::complex<double> oscillator{ 1.0, 0.0 }, oscillator_step{ 1.0, 0.0 };
+	int samples_since_renormalise{ 0 };
+
+	std::vector<float> decimated_re, decimated_im; //ring of the last fft_size decimated samples
+	int decimated_position{ 0 };
+	int64_t decimated_count{ 0 };
+	int samples_since_fft{ 0 };
+
+	std::vector<double> hann_window_weights;
+	fftw_complex *fft_input, *fft_output;
+	fftw_plan plan;
+
+	int first_bin{ 0 }, num_bins{ 0 }; //the band's bins, counted from the most negative frequency
+
+	//results
+
+	std::mutex result_mtx;
+	ZoomSpectrum latest_spectrum;
+	int64_t frame_index{ 0 };
+
+	std::thread worker_thread;
+	std::atomic<bool> stop_requested{ false };
+	std::atomic<bool> enabled{ false };
+	std::atomic<bool> reconfigure_requested{ true };
+	std::atomic<double> active_sample_rate{ 44100.0 };
+	std::atomic<double> band_low{ 20.0 }, band_high{ 500.0 };
+
+	//arrival stamps, one per pushed block: the count of samples pushed up to the end of the block, and its arrival.
+	//Enough for a full input_fifo of 64 sample blocks
+
+	static const int num_arrival_stamps = 1024;
+
+	std::atomic<int64_t> stamp_end_samples[num_arrival_stamps];
+	std::atomic<int64_t> stamp_arrival_ns[num_arrival_stamps];
+	std::atomic<int64_t> stamps_written{ 0 };
+	int64_t samples_pushed{ 0 }; //audio thread
+
+	int64_t stamps_read{ 0 }; //worker thread
+	int64_t samples_popped{ 0 };
+	int64_t block_stamp{ -1 }; //the block being processed
+	int64_t block_arrival_ns{ 0 };
+	int64_t block_taken_ns{ 0 };
+
+	void run() {
+
+		FrameProfiler::get_instance().set_thread_name("Zoom FFT");
+
+		while (!stop_requested.load()) {
+
+			int num_ready = std::min(input_fifo.get_num_ready(), get_samples_left_in_block());
+
+			if (num_ready == 0 && !reconfigure_requested.load()) {
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+				continue;
+
+			}
+
+			int num_samples = std::min(num_ready, (int)chunk.size());
+
+			float* channels[1] = { chunk.data() };
+
+			input_fifo.pop(channels, num_samples);
+
+			samples_popped += num_samples;
+
+			process_samples(chunk.data(), num_samples);
+
+		}
+
+	}
+
+	int get_samples_left_in_block() { //worker thread, up to the end of the oldest stamped block not yet processed
+
+		int64_t written = stamps_written.load(std::memory_order_acquire);
+
+		stamps_read = std::max(stamps_read, written - num_arrival_stamps); //only if the thread fell a whole ring behind
+
+		while (stamps_read < written) {
+
+			int64_t end_samples = stamp_end_samples[stamps_read % num_arrival_stamps].load(std::memory_order_relaxed);
+
+			if (end_samples > samples_popped) {
+
+				if (block_stamp != stamps_read) {
+
+					block_stamp = stamps_read;
+					block_arrival_ns = stamp_arrival_ns[stamps_read % num_arrival_stamps].load(std::memory_order_relaxed);
+					block_taken_ns = FrameProfiler::get_instance().get_time_ns();
+
+				}
+
+				return (int)std::min<int64_t>(end_samples - samples_popped, std::numeric_limits<int>::max());
+
+			}
+
+			stamps_read++;
+
+		}
+
+		return 0;
+
+	}
+
+	void configure() {
+
+		double sample_rate = active_sample_rate.load();
+		double low = band_low.load();
+		double high = std::min(band_high.load(), sample_rate * 0.5);
+		double bandwidth = std::max(high - low, minimum_bandwidth);
+
+		centre_frequency = (low + high) * 0.5;
+
+		//the decimated rate leaves 25% room around the band for the filter's transition
+
+		decimation = std::max(1, std::min(max_decimation, (int)(sample_rate / (bandwidth * 1.25))));
+		decimated_rate = sample_rate / decimation;
+
+		num_taps = ((taps_per_decimation * decimation) / 4 + 1) * 4;
+
+		design_filter(bandwidth * 0.625 / sample_rate);
+
+		mixed_re.assign(num_taps * 2, 0.0f);
+		mixed_im.assign(num_taps * 2, 0.0f);
+		filter_position = 0;
+		samples_until_output = decimation;
+
+		oscillator = std::complex<double>(1.0, 0.0);
+		oscillator_step = std::polar(1.0, -2.0 * 3.141592653589793 * centre_frequency / sample_rate);
+		samples_since_renormalise = 0;
+
+		std::fill(decimated_re.begin(), decimated_re.end(), 0.0f);
+		std::fill(decimated_im.begin(), decimated_im.end(), 0.0f);
+		decimated_position = 0;
+		decimated_count = 0;
+		samples_since_fft = 0;
+
+		//bin j of the shifted spectrum is at centre + (j - fft_size/2) * decimated_rate / fft_size
+
+		double bin_spacing = decimated_rate / fft_size;
+
+		first_bin = std::max(0, (int)std::ceil((low - centre_frequency) / bin_spacing) + fft_size / 2);
+		int last_bin = std::min(fft_size - 1, (int)std::floor((high - centre_frequency) / bin_spacing) + fft_size / 2);
+		num_bins = std::max(0, last_bin - first_bin + 1);
+
+		std::lock_guard<std::mutex> result_lock(result_mtx);
+
+		latest_spectrum.frequencies.resize(num_bins);
+		latest_spectrum.amplitudes.assign(num_bins, 0.0f);
+
+		for (int bin = 0; bin < num_bins; bin++) {
+
+			latest_spectrum.frequencies[bin] = centre_frequency + (first_bin + bin - fft_size / 2) * bin_spacing;
+
+		}
+
+		latest_spectrum.resolution = bin_spacing;
+		latest_spectrum.update_interval = (hop_size * decimation) / sample_rate;
+		latest_spectrum.decimation = decimation;
+		latest_spectrum.valid = false;
+
+		frame_index++;
+
+	}
+
+	void design_filter(double cutoff) { //Blackman windowed sinc, cutoff in cycles per sample, unity gain at DC
+
+		filter_taps.resize(num_taps);
+
+		double centre = (num_taps - 1) * 0.5;
+		double sum = 0.0;
+
+		for (int tap = 0; tap < num_taps; tap++) {
+
+			double t = tap - centre;
+			double sinc = t == 0.0 ? 2.0 * cutoff : sin(2.0 * 3.141592653589793 * cutoff * t) / (3.141592653589793 * t);
+			double phase = (2.0 * 3.141592653589793 * tap) / (num_taps - 1);
+			double window = 0.42 - 0.5 * cos(phase) + 0.08 * cos(2.0 * phase);
+
+			filter_taps[tap] = (float)(sinc * window);
+			sum += filter_taps[tap];
+
+		}
+
+		for (int tap = 0; tap < num_taps; tap++) {
+
+			filter_taps[tap] = (float)(filter_taps[tap] / sum);
+
+		}
+
+	}
+
+	void add_decimated_sample(float re, float im) {
+
+		decimated_re[decimated_position] = re;
+		decimated_im[decimated_position] = im;
+
+		decimated_position = (decimated_position + 1) % fft_size;
+		decimated_count++;
+		samples_since_fft++;
+
+		if (decimated_count >= fft_size && samples_since_fft >= hop_size) {
+
+			samples_since_fft = 0;
+
+			run_fft();
+
+		}
+
+	}
+
+	void run_fft() {
+
+		SOUNDVIEW_PROFILE_SCOPE("zoom_fft");
+
+		for (int n = 0; n < fft_size; n++) { //oldest sample first
+
+			int position = (decimated_position + n) % fft_size;
+
+			fft_input[n][0] = decimated_re[position] * hann_window_weights[n];
+			fft_input[n][1] = decimated_im[position] * hann_window_weights[n];
+
+		}
+
+		fftw_execute(plan);
+
+		//a real sine of amplitude A becomes A/2 at one complex frequency, and the Hann window halves it again
+
+		double amplitude_scaling = 4.0 / fft_size;
+
+		std::lock_guard<std::mutex> result_lock(result_mtx);
+
+		for (int bin = 0; bin < num_bins; bin++) {
+
+			int fft_bin = (first_bin + bin + fft_size / 2) % fft_size; //undo the shift, negative frequencies are stored last
+
+			latest_spectrum.amplitudes[bin] = (float)(sqrt(fft_output[fft_bin][0] * fft_output[fft_bin][0] + fft_output[fft_bin][1] * fft_output[fft_bin][1]) * amplitude_scaling);
+
+		}
+
+		latest_spectrum.valid = true;
+		latest_spectrum.newest_sample_ns = block_arrival_ns;
+		latest_spectrum.processing_seconds = block_arrival_ns > 0 ? (FrameProfiler::get_instance().get_time_ns() - block_taken_ns) * 1.0e-9 : 0.0;
+
+		frame_index++;
+
+	}
+
+};